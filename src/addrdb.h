@@ -14,7 +14,7 @@
 
 class CSubNet;
 class CAddrMan;
-class CDataStream;
+#include "streams.h"
 
 typedef enum BanReason
 {
@@ -5,6 +5,7 @@
 #include "lelantus.h"
 #include "ui_interface.h"
 #include "spark/state.h"
+#include "perfstats.h"
 
 std::unique_ptr<BatchProofContainer> BatchProofContainer::instance;
 
@@ -39,6 +40,7 @@ void BatchProofContainer::finalize() {
 
 void BatchProofContainer::verify() {
     if (!fCollectProofs) {
+        PERF_SCOPE("batch_verify");
         batch_lelantus();
         batch_rangeProofs();
         batch_spark();
@@ -46,6 +48,13 @@ void BatchProofContainer::verify() {
     fCollectProofs = false;
 }
 
+void BatchProofContainer::flush() {
+    PERF_SCOPE("batch_verify");
+    batch_lelantus();
+    batch_rangeProofs();
+    batch_spark();
+}
+
 void BatchProofContainer::add(lelantus::JoinSplit* joinSplit,
                               const std::map<uint32_t, size_t>& setSizes,
                               const Scalar& challenge,
@@ -34,6 +34,9 @@ public:
 
     void verify();
 
+    // verify the proofs collected so far, while collecting goes on
+    void flush();
+
     void add(lelantus::JoinSplit* joinSplit,
              const std::map<uint32_t, size_t>& setSizes,
              const Scalar& challenge,
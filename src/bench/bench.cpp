@@ -0,0 +1,181 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "tinyformat.h"
+#include "univalue.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <regex>
+
+namespace benchmark {
+
+//! Iterations every run does at least, even if they take longer than the minimum time
+static const uint64_t MIN_ITERATIONS = 5;
+
+State::State(int64_t nParamIn, double nMinTimeIn, uint64_t nMaxIterationsIn) :
+    nParam(nParamIn),
+    nMinTime(nMinTimeIn),
+    nMaxIterations(std::max<uint64_t>(nMaxIterationsIn, 1)),
+    nItems(1),
+    fStarted(false)
+{
+}
+
+bool State::KeepRunning()
+{
+    time_point now = clock::now();
+    if (!fStarted) {
+        fStarted = true;
+        startTime = lastTime = now;
+        return true;
+    }
+
+    vElapsed.push_back(std::chrono::duration<double>(now - lastTime).count());
+    if (vElapsed.size() >= nMaxIterations)
+        return false;
+    if (vElapsed.size() >= MIN_ITERATIONS && std::chrono::duration<double>(now - startTime).count() >= nMinTime)
+        return false;
+
+    // don't count the bookkeeping above
+    lastTime = clock::now();
+    return true;
+}
+
+std::string Result::GetFullName() const
+{
+    return fHasParam ? strprintf("%s/%d", name, nParam) : name;
+}
+
+BenchRunner::BenchmarkMap& BenchRunner::benchmarks()
+{
+    static BenchmarkMap benchmarks_map;
+    return benchmarks_map;
+}
+
+BenchRunner::BenchRunner(const std::string& name, BenchFunction func, const std::vector<int64_t>& vParams)
+{
+    BenchInfo& info = benchmarks()[name];
+    info.func = func;
+    info.vParams = vParams;
+}
+
+std::string BenchRunner::Run::GetFullName() const
+{
+    return fHasParam ? strprintf("%s/%d", name, nParam) : name;
+}
+
+std::vector<BenchRunner::Run> BenchRunner::GetRuns(const Options& options)
+{
+    std::regex reFilter(options.strFilter);
+    std::vector<Run> runs;
+    for (const auto& bench : benchmarks()) {
+        const std::vector<int64_t>& vParams = bench.second.vParams;
+        if (vParams.empty()) {
+            runs.push_back(Run{bench.first, bench.second.func, false, 0});
+        } else {
+            for (int64_t nParam : options.vParams.empty() ? vParams : options.vParams)
+                runs.push_back(Run{bench.first, bench.second.func, true, nParam});
+        }
+    }
+    runs.erase(std::remove_if(runs.begin(), runs.end(), [&](const Run& run) {
+        return !std::regex_search(run.GetFullName(), reFilter);
+    }), runs.end());
+    return runs;
+}
+
+std::vector<std::string> BenchRunner::List(const Options& options)
+{
+    std::vector<std::string> names;
+    for (const Run& run : GetRuns(options))
+        names.push_back(run.GetFullName());
+    return names;
+}
+
+std::vector<Result> BenchRunner::RunAll(const Options& options)
+{
+    std::vector<Result> results;
+    for (const Run& run : GetRuns(options)) {
+        State state(run.nParam, options.nMinTime, options.nMaxIterations);
+        run.func(state);
+
+        Result result;
+        result.name = run.name;
+        result.fHasParam = run.fHasParam;
+        result.nParam = run.nParam;
+        result.nItems = std::max<uint64_t>(state.GetItemsPerIteration(), 1);
+
+        std::vector<double> vElapsed = state.GetElapsed();
+        result.nIterations = vElapsed.size();
+        if (!vElapsed.empty()) {
+            std::sort(vElapsed.begin(), vElapsed.end());
+            result.nTotal = std::accumulate(vElapsed.begin(), vElapsed.end(), 0.0);
+            result.nMin = vElapsed.front();
+            result.nMax = vElapsed.back();
+            result.nMean = result.nTotal / vElapsed.size();
+            size_t nMid = vElapsed.size() / 2;
+            result.nMedian = vElapsed.size() % 2 ? vElapsed[nMid] : (vElapsed[nMid - 1] + vElapsed[nMid]) / 2;
+        }
+
+        PrintConsole(result, results.empty());
+        results.push_back(result);
+    }
+    return results;
+}
+
+void PrintConsole(const Result& result, bool fHeader)
+{
+    if (fHeader)
+        std::cout << strprintf("%-40s %10s %14s %14s %14s %14s\n", "# Benchmark", "Iterations", "Min (us)", "Median (us)", "Max (us)", "Median/item");
+    std::cout << strprintf("%-40s %10u %14.3f %14.3f %14.3f %14.3f\n", result.GetFullName(), result.nIterations,
+                           result.nMin * 1e6, result.nMedian * 1e6, result.nMax * 1e6, result.nMedian * 1e6 / result.nItems);
+    std::cout.flush();
+}
+
+bool WriteCSV(const std::string& strFile, const std::vector<Result>& results)
+{
+    std::ofstream file(strFile);
+    if (!file.is_open())
+        return false;
+
+    file << "name,param,iterations,items,total_s,min_s,median_s,mean_s,max_s\n";
+    for (const Result& result : results) {
+        file << strprintf("%s,%s,%u,%u,%.9f,%.9f,%.9f,%.9f,%.9f\n", result.name, result.fHasParam ? std::to_string(result.nParam) : "",
+                          result.nIterations, result.nItems, result.nTotal, result.nMin, result.nMedian, result.nMean, result.nMax);
+    }
+    return file.good();
+}
+
+bool WriteJSON(const std::string& strFile, const std::vector<Result>& results)
+{
+    std::ofstream file(strFile);
+    if (!file.is_open())
+        return false;
+
+    UniValue arr(UniValue::VARR);
+    for (const Result& result : results) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", result.name));
+        if (result.fHasParam)
+            obj.push_back(Pair("param", result.nParam));
+        obj.push_back(Pair("iterations", (uint64_t)result.nIterations));
+        obj.push_back(Pair("items", (uint64_t)result.nItems));
+        obj.push_back(Pair("total_s", result.nTotal));
+        obj.push_back(Pair("min_s", result.nMin));
+        obj.push_back(Pair("median_s", result.nMedian));
+        obj.push_back(Pair("mean_s", result.nMean));
+        obj.push_back(Pair("max_s", result.nMax));
+        arr.push_back(obj);
+    }
+    UniValue root(UniValue::VOBJ);
+    root.push_back(Pair("benchmarks", arr));
+    file << root.write(2) << "\n";
+    return file.good();
+}
+
+} // namespace benchmark
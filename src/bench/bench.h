@@ -0,0 +1,150 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_BENCH_BENCH_H
+#define BZX_BENCH_BENCH_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+// Simple micro-benchmarking framework. Usage:
+//
+// static void CODE_TO_TIME(benchmark::State& state)
+// {
+//     ... do any setup needed, sized by state.GetParam() if parameterized ...
+//     while (state.KeepRunning()) {
+//        ... do stuff you want to time ...
+//     }
+//     ... do any cleanup needed ...
+// }
+//
+// BENCHMARK(CODE_TO_TIME);
+// BENCHMARK_PARAMS(CODE_TO_TIME, 16, 256, 1024);
+//
+// Parameterized benchmarks run once for every parameter, e.g. every set or
+// batch size. Setup is not timed, so fixtures should be built before the
+// first call to KeepRunning.
+
+namespace benchmark {
+
+typedef std::chrono::high_resolution_clock clock;
+typedef std::chrono::time_point<clock> time_point;
+
+class State
+{
+private:
+    const int64_t nParam;
+    const double nMinTime;
+    const uint64_t nMaxIterations;
+    uint64_t nItems;
+    bool fStarted;
+    time_point startTime;
+    time_point lastTime;
+    //! Duration of every iteration in seconds
+    std::vector<double> vElapsed;
+
+public:
+    State(int64_t nParamIn, double nMinTimeIn, uint64_t nMaxIterationsIn);
+
+    //! Parameter of this run, 0 for benchmarks without parameters
+    int64_t GetParam() const { return nParam; }
+    //! Number of items (transactions, proofs, ...) handled by one iteration, for per item timings
+    void SetItemsPerIteration(uint64_t n) { nItems = n; }
+    uint64_t GetItemsPerIteration() const { return nItems; }
+
+    bool KeepRunning();
+
+    const std::vector<double>& GetElapsed() const { return vElapsed; }
+};
+
+typedef std::function<void(State&)> BenchFunction;
+
+/** Timings of one benchmark run, all durations in seconds per iteration */
+struct Result
+{
+    std::string name;
+    int64_t nParam;
+    bool fHasParam;
+    uint64_t nIterations;
+    uint64_t nItems;
+    double nTotal;
+    double nMin;
+    double nMedian;
+    double nMean;
+    double nMax;
+
+    Result() : nParam(0), fHasParam(false), nIterations(0), nItems(1), nTotal(0), nMin(0), nMedian(0), nMean(0), nMax(0) {}
+
+    //! name/param as used by -filter and in the reports
+    std::string GetFullName() const;
+};
+
+struct Options
+{
+    //! Regular expression the full names of the benchmarks to run must match
+    std::string strFilter;
+    //! Replaces the parameters of parameterized benchmarks if not empty
+    std::vector<int64_t> vParams;
+    //! Minimum time to spend in every benchmark run, in seconds
+    double nMinTime;
+    uint64_t nMaxIterations;
+
+    Options() : strFilter(".*"), nMinTime(0.5), nMaxIterations(1000000) {}
+};
+
+class BenchRunner
+{
+private:
+    struct BenchInfo
+    {
+        BenchFunction func;
+        std::vector<int64_t> vParams;
+    };
+    typedef std::map<std::string, BenchInfo> BenchmarkMap;
+    static BenchmarkMap& benchmarks();
+
+    /** One run of a benchmark, parameterized benchmarks have a run per parameter */
+    struct Run
+    {
+        std::string name;
+        BenchFunction func;
+        bool fHasParam;
+        int64_t nParam;
+
+        std::string GetFullName() const;
+    };
+    static std::vector<Run> GetRuns(const Options& options);
+
+public:
+    BenchRunner(const std::string& name, BenchFunction func, const std::vector<int64_t>& vParams = std::vector<int64_t>());
+
+    //! Names of all registered benchmark runs, with their parameters
+    static std::vector<std::string> List(const Options& options);
+    static std::vector<Result> RunAll(const Options& options);
+};
+
+//! Human readable table on stdout
+void PrintConsole(const Result& result, bool fHeader);
+//! Machine readable reports for comparing runs, e.g. in CI
+bool WriteCSV(const std::string& strFile, const std::vector<Result>& results);
+bool WriteJSON(const std::string& strFile, const std::vector<Result>& results);
+
+} // namespace benchmark
+
+// BENCHMARK(foo) expands to:  benchmark::BenchRunner bench_11foo("foo", foo);
+#define BENCHMARK(n) \
+    benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n);
+
+#define BENCHMARK_PARAMS(n, ...) \
+    benchmark::BenchRunner BOOST_PP_CAT(bench_, BOOST_PP_CAT(__LINE__, n))(BOOST_PP_STRINGIZE(n), n, {__VA_ARGS__});
+
+#endif // BZX_BENCH_BENCH_H
@@ -0,0 +1,88 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "chainparamsbase.h"
+#include "key.h"
+#include "util.h"
+#include "utilstrencodings.h"
+
+#include <iostream>
+
+#include <boost/algorithm/string.hpp>
+
+static const int64_t DEFAULT_BENCH_MIN_TIME = 500;
+static const int64_t DEFAULT_BENCH_MAX_ITERATIONS = 1000000;
+
+static std::string HelpMessageBench()
+{
+    std::string strUsage = "Usage: bench_bitcoinzero [options]\n\n";
+    strUsage += HelpMessageOpt("-?", "Print this help message and exit");
+    strUsage += HelpMessageOpt("-list", "List the selected benchmarks without running them");
+    strUsage += HelpMessageOpt("-filter=<regex>", "Run only the benchmarks whose name/parameter matches the regular expression (default: .*)");
+    strUsage += HelpMessageOpt("-params=<n>,<n>,...", "Run parameterized benchmarks (set and batch sizes) with these parameters instead of their defaults");
+    strUsage += HelpMessageOpt("-min-time=<ms>", strprintf("Minimum time to spend in every benchmark (default: %u)", DEFAULT_BENCH_MIN_TIME));
+    strUsage += HelpMessageOpt("-max-iterations=<n>", strprintf("Maximum number of iterations of every benchmark (default: %u)", DEFAULT_BENCH_MAX_ITERATIONS));
+    strUsage += HelpMessageOpt("-output-csv=<file>", "Write the results to a CSV file");
+    strUsage += HelpMessageOpt("-output-json=<file>", "Write the results to a JSON file");
+    return strUsage;
+}
+
+int main(int argc, char** argv)
+{
+    SetupEnvironment();
+    ParseParameters(argc, argv);
+
+    if (IsArgSet("-?") || IsArgSet("-h") || IsArgSet("-help")) {
+        std::cout << HelpMessageBench();
+        return EXIT_SUCCESS;
+    }
+
+    benchmark::Options options;
+    options.strFilter = GetArg("-filter", options.strFilter);
+    options.nMinTime = std::max<int64_t>(GetArg("-min-time", DEFAULT_BENCH_MIN_TIME), 0) * 0.001;
+    options.nMaxIterations = std::max<int64_t>(GetArg("-max-iterations", DEFAULT_BENCH_MAX_ITERATIONS), 1);
+    if (IsArgSet("-params")) {
+        std::string strParams = GetArg("-params", "");
+        std::vector<std::string> vParams;
+        boost::split(vParams, strParams, boost::is_any_of(","));
+        for (const std::string& strParam : vParams) {
+            int64_t nParam;
+            if (!ParseInt64(strParam, &nParam) || nParam <= 0) {
+                std::cerr << strprintf("Invalid -params value: %s\n", strParam);
+                return EXIT_FAILURE;
+            }
+            options.vParams.push_back(nParam);
+        }
+    }
+
+    if (IsArgSet("-list")) {
+        for (const std::string& name : benchmark::BenchRunner::List(options))
+            std::cout << name << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    // fixtures are regtest-style, nothing touches the data directory or the network
+    SelectParams(CBaseChainParams::REGTEST);
+    fPrintToConsole = false;
+    fPrintToDebugLog = false;
+    ECC_Start();
+
+    std::vector<benchmark::Result> results = benchmark::BenchRunner::RunAll(options);
+
+    ECC_Stop();
+
+    bool fOk = true;
+    if (IsArgSet("-output-csv") && !benchmark::WriteCSV(GetArg("-output-csv", ""), results)) {
+        std::cerr << "Could not write " << GetArg("-output-csv", "") << "\n";
+        fOk = false;
+    }
+    if (IsArgSet("-output-json") && !benchmark::WriteJSON(GetArg("-output-json", ""), results)) {
+        std::cerr << "Could not write " << GetArg("-output-json", "") << "\n";
+        fOk = false;
+    }
+    return fOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,30 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "validation.h"
+
+#include <cassert>
+
+// Context free checks of a block with the given number of transactions,
+// without proof of work so the block doesn't get marked as checked.
+static void CheckBlockTransactions(benchmark::State& state)
+{
+    benchmark::SyntheticChain chain = benchmark::CreateSyntheticChain(1, state.GetParam(), 1);
+    const CBlock& block = chain.vBlocks[0];
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    state.SetItemsPerIteration(block.vtx.size());
+
+    while (state.KeepRunning()) {
+        CValidationState validationState;
+        bool fValid = CheckBlock(block, validationState, consensusParams, false, true, 1, false);
+        assert(fValid);
+    }
+}
+
+BENCHMARK_PARAMS(CheckBlockTransactions, 10, 100, 1000);
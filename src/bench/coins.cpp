@@ -0,0 +1,64 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "coins.h"
+
+#include <cassert>
+
+// Parameter: transactions per block, every transaction spends two coins and adds two
+
+static const unsigned int COINS_BENCH_BLOCKS = 10;
+
+// The coins view updates of ConnectBlock for a chain of blocks, each block in
+// its own cache on top of the previous one, flushed once the block is done.
+static void CoinsViewCacheConnectBlocks(benchmark::State& state)
+{
+    benchmark::SyntheticChain chain = benchmark::CreateSyntheticChain(COINS_BENCH_BLOCKS, state.GetParam(), 2);
+    state.SetItemsPerIteration(COINS_BENCH_BLOCKS * state.GetParam());
+
+    CCoinsView viewDummy;
+    while (state.KeepRunning()) {
+        CCoinsViewCache viewTip(&viewDummy);
+        benchmark::AddFundingCoins(viewTip, chain);
+        for (size_t i = 0; i < chain.vBlocks.size(); i++) {
+            CCoinsViewCache view(&viewTip);
+            for (const CTransactionRef& tx : chain.vBlocks[i].vtx) {
+                if (!tx->IsCoinBase()) {
+                    for (const CTxIn& txin : tx->vin) {
+                        assert(view.HaveCoin(txin.prevout));
+                        view.SpendCoin(txin.prevout);
+                    }
+                }
+                AddCoins(view, *tx, i + 2);
+            }
+            bool fFlushed = view.Flush();
+            assert(fFlushed);
+        }
+    }
+}
+
+// Lookups of coins which are in the parent cache only, as done for the inputs
+// of every transaction entering the mempool.
+static void CoinsViewCacheAccessCoin(benchmark::State& state)
+{
+    benchmark::SyntheticChain chain = benchmark::CreateSyntheticChain(1, state.GetParam(), 3);
+    state.SetItemsPerIteration(chain.vFunding.size());
+
+    CCoinsView viewDummy;
+    CCoinsViewCache viewTip(&viewDummy);
+    benchmark::AddFundingCoins(viewTip, chain);
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(&viewTip);
+        for (const COutPoint& outpoint : chain.vFunding) {
+            const Coin& coin = view.AccessCoin(outpoint);
+            assert(!coin.IsSpent());
+        }
+    }
+}
+
+BENCHMARK_PARAMS(CoinsViewCacheConnectBlocks, 10, 100, 1000);
+BENCHMARK_PARAMS(CoinsViewCacheAccessCoin, 100, 1000, 10000);
@@ -0,0 +1,125 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "fixtures.h"
+
+#include "amount.h"
+#include "chainparams.h"
+#include "coins.h"
+#include "consensus/merkle.h"
+#include "hash.h"
+#include "random.h"
+#include "script/script.h"
+
+namespace benchmark {
+
+namespace {
+
+uint256 SeedHash(const std::string& strTag, uint64_t nSeed)
+{
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << strTag << nSeed;
+    return hasher.GetHash();
+}
+
+CScript RandomP2PKH(FastRandomContext& rng)
+{
+    std::vector<unsigned char> vchKeyId(20);
+    for (unsigned char& c : vchKeyId)
+        c = rng.randbits(8);
+    return CScript() << OP_DUP << OP_HASH160 << vchKeyId << OP_EQUALVERIFY << OP_CHECKSIG;
+}
+
+//! Signature and public key sized push data, never evaluated by the benchmarks
+CScript DummyScriptSig()
+{
+    return CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+}
+
+} // anon namespace
+
+secp_primitives::Scalar DeterministicScalar(uint64_t nSeed)
+{
+    uint256 hash = SeedHash("scalar", nSeed);
+    secp_primitives::Scalar result;
+    result.memberFromSeed(hash.begin());
+    return result;
+}
+
+SyntheticChain CreateSyntheticChain(unsigned int nBlocks, unsigned int nTxPerBlock, uint64_t nSeed)
+{
+    static const CAmount FUNDING_VALUE = 1000 * COIN;
+    static const CAmount FEE = 1000;
+
+    FastRandomContext rng(SeedHash("chain", nSeed));
+    SyntheticChain chain;
+
+    // every transaction spends two outputs and creates two
+    std::vector<COutPoint> vSpendable;
+    std::vector<CAmount> vValues;
+    for (unsigned int i = 0; i < 2 * nTxPerBlock; i++) {
+        COutPoint outpoint(SeedHash("funding", nSeed * 1000003 + i), i % 2);
+        CTxOut txout(FUNDING_VALUE, RandomP2PKH(rng));
+        chain.vFunding.push_back(outpoint);
+        chain.vFundingOutputs.push_back(txout);
+        vSpendable.push_back(outpoint);
+        vValues.push_back(FUNDING_VALUE);
+    }
+
+    const CBlock& genesis = Params().GenesisBlock();
+    uint256 hashPrevBlock = genesis.GetHash();
+    for (unsigned int nBlock = 0; nBlock < nBlocks; nBlock++) {
+        int nHeight = nBlock + 1;
+        CBlock block;
+        block.nVersion = CBlockHeader::CURRENT_VERSION;
+        block.hashPrevBlock = hashPrevBlock;
+        block.nTime = genesis.nTime + 150 * nHeight;
+        block.nBits = genesis.nBits;
+        block.nNonce = 0;
+
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vin[0].scriptSig = CScript() << nHeight << OP_0;
+        coinbase.vout.emplace_back(50 * COIN + nTxPerBlock * FEE, RandomP2PKH(rng));
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+
+        std::vector<COutPoint> vSpendableNext;
+        std::vector<CAmount> vValuesNext;
+        for (unsigned int i = 0; i < nTxPerBlock; i++) {
+            // tx i spends output 0 of tx i and output 1 of tx i + 1 of the previous block
+            size_t nIn0 = 2 * i;
+            size_t nIn1 = (2 * (i + 1) + 1) % vSpendable.size();
+            CMutableTransaction tx;
+            tx.vin.emplace_back(vSpendable[nIn0], DummyScriptSig());
+            tx.vin.emplace_back(vSpendable[nIn1], DummyScriptSig());
+            CAmount nOut = (vValues[nIn0] + vValues[nIn1] - FEE) / 2;
+            tx.vout.emplace_back(nOut, RandomP2PKH(rng));
+            tx.vout.emplace_back(nOut, RandomP2PKH(rng));
+
+            CTransactionRef ptx = MakeTransactionRef(std::move(tx));
+            vSpendableNext.emplace_back(ptx->GetHash(), 0);
+            vSpendableNext.emplace_back(ptx->GetHash(), 1);
+            vValuesNext.push_back(nOut);
+            vValuesNext.push_back(nOut);
+            block.vtx.push_back(ptx);
+        }
+
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+        hashPrevBlock = block.GetHash();
+        chain.vBlocks.push_back(block);
+        vSpendable.swap(vSpendableNext);
+        vValues.swap(vValuesNext);
+    }
+
+    return chain;
+}
+
+void AddFundingCoins(CCoinsViewCache& cache, const SyntheticChain& chain)
+{
+    for (size_t i = 0; i < chain.vFunding.size(); i++)
+        cache.AddCoin(chain.vFunding[i], Coin(chain.vFundingOutputs[i], 1, false), false);
+}
+
+} // namespace benchmark
@@ -0,0 +1,49 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_BENCH_FIXTURES_H
+#define BZX_BENCH_FIXTURES_H
+
+#include "primitives/block.h"
+#include "primitives/transaction.h"
+
+#include <secp256k1/include/GroupElement.h>
+#include <secp256k1/include/Scalar.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+class CCoinsViewCache;
+
+/**
+ * Inputs of the benchmarks are derived from fixed seeds only, so every run
+ * and every machine works on the same data. Proof nonces are still drawn by
+ * the provers, they don't change the cost of verification.
+ */
+namespace benchmark {
+
+secp_primitives::Scalar DeterministicScalar(uint64_t nSeed);
+
+/**
+ * Regtest-style chain of nBlocks blocks with nTxPerBlock transactions each.
+ * The transactions of the first block spend vFunding, every later block
+ * spends the outputs of the block before it. Scripts are P2PKH with dummy
+ * signatures, so the blocks pass the context free checks only.
+ */
+struct SyntheticChain
+{
+    std::vector<COutPoint> vFunding;
+    std::vector<CTxOut> vFundingOutputs;
+    std::vector<CBlock> vBlocks;
+};
+
+SyntheticChain CreateSyntheticChain(unsigned int nBlocks, unsigned int nTxPerBlock, uint64_t nSeed);
+
+//! Add the funding outputs of chain to cache as if they were confirmed at height 1
+void AddFundingCoins(CCoinsViewCache& cache, const SyntheticChain& chain);
+
+} // namespace benchmark
+
+#endif // BZX_BENCH_FIXTURES_H
@@ -0,0 +1,117 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "liblelantus/lelantus_primitives.h"
+#include "liblelantus/params.h"
+#include "liblelantus/sigmaextended_prover.h"
+#include "liblelantus/sigmaextended_verifier.h"
+
+#include <cassert>
+
+namespace {
+
+/**
+ * One-of-many proofs of a joinsplit, each spending a coin out of the same
+ * anonymity set of nSetSize coins. These are what the batch proof container
+ * verifies per anonymity set when blocks are connected.
+ */
+struct SigmaFixture
+{
+    std::vector<GroupElement> anonymity_set;
+    std::vector<Scalar> challenges;
+    std::vector<Scalar> serials;
+    std::vector<size_t> setSizes;
+    std::vector<lelantus::SigmaExtendedProof> proofs;
+};
+
+SigmaFixture CreateSigmaFixture(size_t nSetSize, size_t nProofs)
+{
+    const lelantus::Params* params = lelantus::Params::get_default();
+    const GroupElement& g = params->get_g();
+    const std::vector<GroupElement>& h = params->get_sigma_h();
+    size_t n = params->get_sigma_n();
+    size_t m = params->get_sigma_m();
+    lelantus::SigmaExtendedProver prover(g, h, n, m);
+
+    SigmaFixture fixture;
+    for (size_t i = 0; i < nSetSize; i++)
+        fixture.anonymity_set.push_back(g * benchmark::DeterministicScalar(i));
+
+    // every proof spends its own coin, put at its own index first
+    std::vector<size_t> indexes;
+    std::vector<Scalar> values, randomness;
+    for (size_t t = 0; t < nProofs; t++) {
+        size_t l = (t * 7919 + 13) % nSetSize;
+        indexes.push_back(l);
+        fixture.serials.push_back(benchmark::DeterministicScalar(1000000 + 3 * t));
+        values.push_back(Scalar(uint64_t(1000 + t)));
+        randomness.push_back(benchmark::DeterministicScalar(1000000 + 3 * t + 1));
+        fixture.anonymity_set[l] = lelantus::LelantusPrimitives::double_commit(g, fixture.serials[t], h[1], values[t], h[0], randomness[t]);
+    }
+
+    for (size_t t = 0; t < nProofs; t++) {
+        // the prover works on the set with the serial number taken out
+        GroupElement gs = g * fixture.serials[t].negate();
+        std::vector<GroupElement> commits;
+        commits.reserve(nSetSize);
+        for (const GroupElement& coin : fixture.anonymity_set)
+            commits.push_back(coin + gs);
+
+        Scalar rA, rB, rC, rD;
+        rA.randomize();
+        rB.randomize();
+        rC.randomize();
+        rD.randomize();
+        std::vector<Scalar> sigma, Tk(m), Pk(m), Yk(m), a(n * m);
+        lelantus::SigmaExtendedProof proof;
+        prover.sigma_commit(commits, indexes[t], rA, rB, rC, rD, a, Tk, Pk, Yk, sigma, proof);
+
+        Scalar x = benchmark::DeterministicScalar(1000000 + 3 * t + 2);
+        prover.sigma_response(sigma, a, rA, rB, rC, rD, values[t], randomness[t], Tk, Pk, x, proof);
+
+        fixture.challenges.push_back(x);
+        fixture.setSizes.push_back(nSetSize);
+        fixture.proofs.push_back(proof);
+    }
+    return fixture;
+}
+
+lelantus::SigmaExtendedVerifier CreateSigmaVerifier()
+{
+    const lelantus::Params* params = lelantus::Params::get_default();
+    return lelantus::SigmaExtendedVerifier(params->get_g(), params->get_sigma_h(), params->get_sigma_n(), params->get_sigma_m());
+}
+
+} // anon namespace
+
+// Parameter: size of the anonymity set
+static void LelantusSigmaVerify(benchmark::State& state)
+{
+    SigmaFixture fixture = CreateSigmaFixture(state.GetParam(), 1);
+    lelantus::SigmaExtendedVerifier verifier = CreateSigmaVerifier();
+
+    while (state.KeepRunning()) {
+        bool fValid = verifier.singleverify(fixture.anonymity_set, fixture.challenges[0], fixture.serials[0], fixture.setSizes[0], fixture.proofs[0]);
+        assert(fValid);
+    }
+}
+
+// Parameter: number of proofs verified together, over an anonymity set of 1024 coins
+static void LelantusSigmaBatchVerify(benchmark::State& state)
+{
+    SigmaFixture fixture = CreateSigmaFixture(1024, state.GetParam());
+    lelantus::SigmaExtendedVerifier verifier = CreateSigmaVerifier();
+    state.SetItemsPerIteration(fixture.proofs.size());
+
+    while (state.KeepRunning()) {
+        bool fValid = verifier.batchverify(fixture.anonymity_set, fixture.challenges, fixture.serials, fixture.setSizes, fixture.proofs);
+        assert(fValid);
+    }
+}
+
+BENCHMARK_PARAMS(LelantusSigmaVerify, 64, 1024, 16384);
+BENCHMARK_PARAMS(LelantusSigmaBatchVerify, 1, 8, 32);
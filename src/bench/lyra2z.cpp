@@ -0,0 +1,24 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "crypto/Lyra2Z/Lyra2Z.h"
+#include "primitives/block.h"
+#include "uint256.h"
+#include "utilstrencodings.h"
+
+// Proof of work of a single header, as done for every header received
+static void Lyra2ZHash(benchmark::State& state)
+{
+    CBlockHeader header = Params().GenesisBlock().GetBlockHeader();
+    uint256 hash;
+    while (state.KeepRunning()) {
+        lyra2z_hash(BEGIN(header.nVersion), BEGIN(hash));
+        header.nNonce++;
+    }
+}
+
+BENCHMARK(Lyra2ZHash);
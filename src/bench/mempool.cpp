@@ -0,0 +1,57 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "amount.h"
+#include "txmempool.h"
+
+// Parameter: transactions per block, the blocks are turned into chains of
+// unconfirmed transactions MEMPOOL_BENCH_DEPTH deep.
+
+static const unsigned int MEMPOOL_BENCH_DEPTH = 5;
+
+static std::vector<CTxMemPoolEntry> CreateEntries(unsigned int nTxPerBlock)
+{
+    benchmark::SyntheticChain chain = benchmark::CreateSyntheticChain(MEMPOOL_BENCH_DEPTH, nTxPerBlock, 4);
+    std::vector<CTxMemPoolEntry> entries;
+    for (const CBlock& block : chain.vBlocks) {
+        for (const CTransactionRef& tx : block.vtx) {
+            if (!tx->IsCoinBase())
+                entries.emplace_back(tx, 1000, 0, 1, 0, false, 4, LockPoints());
+        }
+    }
+    return entries;
+}
+
+// The mempool side of admission, ancestor and descendant bookkeeping
+static void MempoolAddUnchecked(benchmark::State& state)
+{
+    std::vector<CTxMemPoolEntry> entries = CreateEntries(state.GetParam());
+    state.SetItemsPerIteration(entries.size());
+
+    while (state.KeepRunning()) {
+        CTxMemPool pool(CFeeRate(0));
+        for (const CTxMemPoolEntry& entry : entries)
+            pool.addUnchecked(entry.GetTx().GetHash(), entry);
+    }
+}
+
+// Filling the mempool and evicting half of it by descendant score
+static void MempoolTrimToSize(benchmark::State& state)
+{
+    std::vector<CTxMemPoolEntry> entries = CreateEntries(state.GetParam());
+    state.SetItemsPerIteration(entries.size());
+
+    while (state.KeepRunning()) {
+        CTxMemPool pool(CFeeRate(0));
+        for (const CTxMemPoolEntry& entry : entries)
+            pool.addUnchecked(entry.GetTx().GetHash(), entry);
+        pool.TrimToSize(pool.DynamicMemoryUsage() / 2);
+    }
+}
+
+BENCHMARK_PARAMS(MempoolAddUnchecked, 10, 100, 1000);
+BENCHMARK_PARAMS(MempoolTrimToSize, 10, 100, 1000);
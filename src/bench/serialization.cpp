@@ -0,0 +1,46 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "streams.h"
+#include "version.h"
+
+#include <cassert>
+
+// Parameter: transactions per block
+
+static void SerializeBlock(benchmark::State& state)
+{
+    CBlock block = benchmark::CreateSyntheticChain(1, state.GetParam(), 1).vBlocks[0];
+    state.SetItemsPerIteration(block.vtx.size());
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    while (state.KeepRunning()) {
+        stream.clear();
+        stream << block;
+    }
+}
+
+static void DeserializeBlock(benchmark::State& state)
+{
+    CBlock block = benchmark::CreateSyntheticChain(1, state.GetParam(), 1).vBlocks[0];
+    state.SetItemsPerIteration(block.vtx.size());
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << block;
+    size_t nBlockSize = stream.size();
+    // one byte more so the stream isn't compacted by the read and can be rewound
+    stream.write("\0", 1);
+    while (state.KeepRunning()) {
+        CBlock blockRead;
+        stream >> blockRead;
+        bool fRewound = stream.Rewind(nBlockSize);
+        assert(fRewound);
+    }
+}
+
+BENCHMARK_PARAMS(SerializeBlock, 10, 100, 1000);
+BENCHMARK_PARAMS(DeserializeBlock, 10, 100, 1000);
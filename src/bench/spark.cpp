@@ -0,0 +1,202 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "libspark/bpplus.h"
+#include "libspark/grootle.h"
+#include "libspark/spend_transaction.h"
+
+#include <cassert>
+
+namespace {
+
+std::vector<unsigned char> DeterministicBytes(uint64_t nSeed)
+{
+    std::vector<unsigned char> result(spark::SCALAR_ENCODING);
+    benchmark::DeterministicScalar(nSeed).serialize(result.data());
+    return result;
+}
+
+struct GrootleFixture
+{
+    std::vector<GroupElement> S, V;
+    std::vector<GroupElement> S1, V1;
+    std::vector<std::vector<unsigned char>> roots;
+    std::vector<size_t> sizes;
+    std::vector<spark::GrootleProof> proofs;
+};
+
+// nProofs proofs over the same set of nSetSize commitments, as in a block
+// spending from one coin group
+GrootleFixture CreateGrootleFixture(const spark::Params* params, spark::Grootle& grootle, size_t nSetSize, size_t nProofs)
+{
+    GrootleFixture fixture;
+    for (size_t i = 0; i < nSetSize; i++) {
+        fixture.S.push_back(params->get_G() * benchmark::DeterministicScalar(2 * i));
+        fixture.V.push_back(params->get_G() * benchmark::DeterministicScalar(2 * i + 1));
+    }
+
+    for (size_t t = 0; t < nProofs; t++) {
+        size_t l = (t * 7919 + 13) % nSetSize;
+        Scalar s = benchmark::DeterministicScalar(1000000 + 2 * t);
+        Scalar v = benchmark::DeterministicScalar(1000000 + 2 * t + 1);
+        fixture.S1.push_back(fixture.S[l] + (params->get_H() * s).inverse());
+        fixture.V1.push_back(fixture.V[l] + (params->get_H() * v).inverse());
+        fixture.roots.push_back(DeterministicBytes(2000000 + t));
+        fixture.sizes.push_back(nSetSize);
+        fixture.proofs.emplace_back();
+        grootle.prove(l, s, fixture.S, fixture.S1.back(), v, fixture.V, fixture.V1.back(), fixture.roots.back(), fixture.proofs.back());
+    }
+    return fixture;
+}
+
+spark::Grootle CreateGrootle(const spark::Params* params)
+{
+    return spark::Grootle(params->get_H(), params->get_G_grootle(), params->get_H_grootle(), params->get_n_grootle(), params->get_m_grootle());
+}
+
+} // anon namespace
+
+// Parameter: size of the set the proof is over
+static void GrootleVerify(benchmark::State& state)
+{
+    const spark::Params* params = spark::Params::get_default();
+    spark::Grootle grootle = CreateGrootle(params);
+    GrootleFixture fixture = CreateGrootleFixture(params, grootle, state.GetParam(), 1);
+
+    while (state.KeepRunning()) {
+        bool fValid = grootle.verify(fixture.S, fixture.S1[0], fixture.V, fixture.V1[0], fixture.roots[0], fixture.sizes[0], fixture.proofs[0]);
+        assert(fValid);
+    }
+}
+
+// Parameter: number of proofs verified together, over a set of 1024 commitments
+static void GrootleBatchVerify(benchmark::State& state)
+{
+    const spark::Params* params = spark::Params::get_default();
+    spark::Grootle grootle = CreateGrootle(params);
+    GrootleFixture fixture = CreateGrootleFixture(params, grootle, 1024, state.GetParam());
+    state.SetItemsPerIteration(fixture.proofs.size());
+
+    while (state.KeepRunning()) {
+        bool fValid = grootle.verify(fixture.S, fixture.S1, fixture.V, fixture.V1, fixture.roots, fixture.sizes, fixture.proofs);
+        assert(fValid);
+    }
+}
+
+// Parameter: number of range proofs verified together, each for two outputs
+static void BPPlusBatchVerify(benchmark::State& state)
+{
+    const spark::Params* params = spark::Params::get_default();
+    spark::BPPlus range(params->get_G(), params->get_H(), params->get_G_range(), params->get_H_range(), 64);
+
+    std::vector<std::vector<GroupElement>> C(state.GetParam());
+    std::vector<spark::BPPlusProof> proofs(state.GetParam());
+    for (size_t i = 0; i < proofs.size(); i++) {
+        std::vector<Scalar> v, r;
+        for (size_t j = 0; j < 2; j++) {
+            v.emplace_back(uint64_t(1000 * i + j));
+            r.push_back(benchmark::DeterministicScalar(2 * i + j));
+            C[i].push_back(params->get_G() * v.back() + params->get_H() * r.back());
+        }
+        range.prove(v, r, C[i], proofs[i]);
+    }
+    state.SetItemsPerIteration(proofs.size());
+
+    while (state.KeepRunning()) {
+        bool fValid = range.verify(C, proofs);
+        assert(fValid);
+    }
+}
+
+namespace {
+
+struct SpendFixture
+{
+    std::unordered_map<uint64_t, std::vector<spark::Coin>> cover_sets;
+    std::vector<spark::SpendTransaction> transactions;
+};
+
+// nTransactions spends of one coin each from a single cover set of nSetSize
+// coins, every spend with two outputs
+SpendFixture CreateSpendFixture(size_t nSetSize, size_t nTransactions)
+{
+    static const uint64_t COIN_VALUE = 100000;
+    static const uint64_t FEE = 1000;
+    static const uint64_t COVER_SET_ID = 1;
+
+    const spark::Params* params = spark::Params::get_default();
+    spark::SpendKey spend_key(params, benchmark::DeterministicScalar(1));
+    spark::FullViewKey full_view_key(spend_key);
+    spark::IncomingViewKey incoming_view_key(full_view_key);
+    spark::Address address(incoming_view_key, 1);
+
+    SpendFixture fixture;
+    std::vector<spark::Coin>& cover_set = fixture.cover_sets[COVER_SET_ID];
+    for (size_t i = 0; i < nSetSize; i++)
+        cover_set.emplace_back(params, spark::COIN_TYPE_MINT, benchmark::DeterministicScalar(100 + i), address, COIN_VALUE, "", DeterministicBytes(3000000 + i));
+
+    std::unordered_map<uint64_t, spark::CoverSetData> cover_set_data;
+    cover_set_data[COVER_SET_ID].cover_set_size = nSetSize;
+    cover_set_data[COVER_SET_ID].cover_set_representation = DeterministicBytes(4000000);
+
+    for (size_t t = 0; t < nTransactions; t++) {
+        size_t l = (t * 7919 + 13) % nSetSize;
+        spark::IdentifiedCoinData identified = cover_set[l].identify(incoming_view_key);
+        spark::RecoveredCoinData recovered = cover_set[l].recover(full_view_key, identified);
+
+        spark::InputCoinData input;
+        input.cover_set_id = COVER_SET_ID;
+        input.index = l;
+        input.s = recovered.s;
+        input.T = recovered.T;
+        input.v = identified.v;
+        input.k = identified.k;
+
+        std::vector<spark::OutputCoinData> outputs(2);
+        for (spark::OutputCoinData& output : outputs) {
+            output.address = address;
+            output.v = (COIN_VALUE - FEE) / 2;
+            output.memo = "";
+        }
+
+        fixture.transactions.emplace_back(params, full_view_key, spend_key, std::vector<spark::InputCoinData>{input},
+                                          cover_set_data, fixture.cover_sets, FEE, 0, outputs);
+    }
+    return fixture;
+}
+
+} // anon namespace
+
+// Parameter: size of the cover set
+static void SparkSpendVerify(benchmark::State& state)
+{
+    SpendFixture fixture = CreateSpendFixture(state.GetParam(), 1);
+
+    while (state.KeepRunning()) {
+        bool fValid = spark::SpendTransaction::verify(fixture.transactions[0], fixture.cover_sets);
+        assert(fValid);
+    }
+}
+
+// Parameter: number of spends verified together, all from a cover set of 1024 coins
+static void SparkSpendBatchVerify(benchmark::State& state)
+{
+    SpendFixture fixture = CreateSpendFixture(1024, state.GetParam());
+    const spark::Params* params = spark::Params::get_default();
+    state.SetItemsPerIteration(fixture.transactions.size());
+
+    while (state.KeepRunning()) {
+        bool fValid = spark::SpendTransaction::verify(params, fixture.transactions, fixture.cover_sets);
+        assert(fValid);
+    }
+}
+
+BENCHMARK_PARAMS(GrootleVerify, 64, 1024, 16384);
+BENCHMARK_PARAMS(GrootleBatchVerify, 1, 8, 32);
+BENCHMARK_PARAMS(BPPlusBatchVerify, 1, 8, 32);
+BENCHMARK_PARAMS(SparkSpendVerify, 64, 1024);
+BENCHMARK_PARAMS(SparkSpendBatchVerify, 1, 8);
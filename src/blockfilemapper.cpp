@@ -0,0 +1,263 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilemapper.h"
+
+#include "chain.h"
+#include "crypto/common.h"
+#include "perfstats.h"
+#include "util.h"
+#include "validation.h"
+
+#include <mutex>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CBlockFileMapper* pblockfilemapper = NULL;
+
+namespace {
+
+//! Message start and size written in front of every record
+const size_t RECORD_HEADER_SIZE = 4 + sizeof(uint32_t);
+//! A read this close behind the previous one counts as sequential
+const size_t SEQUENTIAL_GAP = 64 << 10;
+
+#ifndef WIN32
+void AdviseWillNeed(const unsigned char* pbegin, size_t nSize, size_t nOffset, size_t nLength)
+{
+    static const size_t nPageSize = sysconf(_SC_PAGESIZE);
+    if (nOffset >= nSize)
+        return;
+    nLength = std::min(nLength, nSize - nOffset);
+    size_t nAligned = nOffset - nOffset % nPageSize;
+    posix_madvise((void*)(pbegin + nAligned), nLength + (nOffset - nAligned), POSIX_MADV_WILLNEED);
+}
+
+//! Set while CopyPages reads a mapping, a SIGBUS then returns there instead of ending the process
+thread_local sigjmp_buf* pSigbusJump = nullptr;
+struct sigaction saPrevSigbus;
+
+void HandleSigbus(int nSignal, siginfo_t* info, void* context)
+{
+    if (pSigbusJump)
+        siglongjmp(*pSigbusJump, 1);
+    // not raised by CopyPages, leave it to the previous handler or the default action
+    sigaction(SIGBUS, &saPrevSigbus, nullptr);
+    raise(SIGBUS);
+}
+
+void InstallSigbusHandler()
+{
+    static std::once_flag flag;
+    std::call_once(flag, [] {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = HandleSigbus;
+        sa.sa_flags = SA_SIGINFO;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGBUS, &sa, &saPrevSigbus);
+    });
+}
+
+/**
+ * Copy [pbegin, pbegin + nLength) to pdest, false if that raised SIGBUS. Nothing
+ * but the copy runs under the guard, the jump back must not skip destructors
+ */
+bool CopyPages(const unsigned char* pbegin, size_t nLength, unsigned char* pdest)
+{
+    sigjmp_buf jump;
+    if (sigsetjmp(jump, 1) != 0) {
+        pSigbusJump = nullptr;
+        return false;
+    }
+    pSigbusJump = &jump;
+    memcpy(pdest, pbegin, nLength);
+    pSigbusJump = nullptr;
+    return true;
+}
+#endif
+
+} // anon namespace
+
+CMappedBlockFile::CMappedBlockFile(const std::string& strPathIn, const unsigned char* pbeginIn, size_t nSizeIn) :
+    strPath(strPathIn), pbegin(pbeginIn), nSize(nSizeIn), nLastReadEnd(0), nReadaheadEnd(0)
+{
+}
+
+CMappedBlockFile::~CMappedBlockFile()
+{
+#ifndef WIN32
+    munmap((void*)pbegin, nSize);
+#endif
+}
+
+void CMappedBlockFile::Prefetch(size_t nOffset, size_t nLength) const
+{
+#ifndef WIN32
+    size_t nEnd = nOffset + nLength;
+    size_t nLast = nLastReadEnd.exchange(nEnd, std::memory_order_relaxed);
+    bool fSequential = nOffset >= nLast && nOffset - nLast <= SEQUENTIAL_GAP;
+
+    if (!fSequential) {
+        // random access: the kernel doesn't read ahead on this mapping, ask
+        // for the whole record at once instead of faulting it in page by page
+        AdviseWillNeed(pbegin, nSize, nOffset, nLength);
+        nReadaheadEnd.store(nEnd, std::memory_order_relaxed);
+        return;
+    }
+
+    // keep at least half of the readahead window in front of the reader
+    size_t nRequested = nReadaheadEnd.load(std::memory_order_relaxed);
+    if (nRequested >= nEnd + READAHEAD / 2)
+        return;
+    size_t nFrom = std::max(nRequested, nOffset);
+    size_t nTo = nEnd + READAHEAD;
+    AdviseWillNeed(pbegin, nSize, nFrom, nTo - nFrom);
+    nReadaheadEnd.store(nTo, std::memory_order_relaxed);
+#endif
+}
+
+bool CMappedBlockFile::Read(size_t nOffset, size_t nLength, unsigned char* pdest) const
+{
+#ifndef WIN32
+    assert(nOffset + nLength <= nSize);
+    // pages past the end of a truncated file raise SIGBUS, the tail of the last page reads as zeros
+    struct stat st;
+    if (stat(strPath.c_str(), &st) != 0 || (uint64_t)st.st_size < nOffset + nLength)
+        return false;
+    return CopyPages(pbegin + nOffset, nLength, pdest);
+#else
+    return false;
+#endif
+}
+
+CBlockFileMapper::CBlockFileMapper(size_t nMaxFilesIn) : nMaxFiles(std::max<size_t>(nMaxFilesIn, 1))
+{
+#ifndef WIN32
+    InstallSigbusHandler();
+#endif
+}
+
+std::shared_ptr<const CMappedBlockFile> CBlockFileMapper::MapFile(const CDiskBlockPos& pos, const char* prefix) const
+{
+#ifndef WIN32
+    boost::filesystem::path path = GetBlockPosFilename(pos, prefix);
+    // the file is only read, the writer keeps appending to it through stdio
+    // and the shared mapping sees those appends up to the size mapped here
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    size_t nSize = st.st_size;
+    void* p = mmap(nullptr, nSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        LogPrintf("%s: mmap of %s failed: %s\n", __func__, path.string(), strerror(errno));
+        return nullptr;
+    }
+    // reads are either random (serving old blocks) or announced through
+    // Prefetch, the default readahead would mostly read pages nobody asks for
+    posix_madvise(p, nSize, POSIX_MADV_RANDOM);
+
+    PERF_COUNT("blockfile_mmap_maps", 1);
+    return std::make_shared<const CMappedBlockFile>(path.string(), (const unsigned char*)p, nSize);
+#else
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<const CMappedBlockFile> CBlockFileMapper::GetFile(const CDiskBlockPos& pos, const char* prefix, size_t nMinSize)
+{
+    FileKey key(prefix, pos.nFile);
+
+    LOCK(cs);
+    auto it = mapFiles.find(key);
+    if (it != mapFiles.end()) {
+        lruFiles.splice(lruFiles.begin(), lruFiles, it->second.itLRU);
+        if (it->second.file->size() >= nMinSize)
+            return it->second.file;
+        // the file grew since it was mapped
+        lruFiles.erase(it->second.itLRU);
+        mapFiles.erase(it);
+    }
+
+    std::shared_ptr<const CMappedBlockFile> file = MapFile(pos, prefix);
+    if (!file)
+        return nullptr;
+
+    lruFiles.push_front(key);
+    mapFiles[key] = MappedFile{file, lruFiles.begin()};
+    while (lruFiles.size() > nMaxFiles) {
+        mapFiles.erase(lruFiles.back());
+        lruFiles.pop_back();
+    }
+
+    if (file->size() < nMinSize)
+        return nullptr;
+    return file;
+}
+
+bool CBlockFileMapper::GetRecord(const CDiskBlockPos& pos, const char* prefix, size_t nTrailing, CMappedBlockRecord& record)
+{
+    if (pos.IsNull() || pos.nPos < RECORD_HEADER_SIZE)
+        return false;
+
+    std::shared_ptr<const CMappedBlockFile> file = GetFile(pos, prefix, pos.nPos);
+    if (!file)
+        return false;
+
+    unsigned char size[sizeof(uint32_t)];
+    if (!file->Read(pos.nPos - sizeof(size), sizeof(size), size)) {
+        Invalidate(pos.nFile);
+        return false;
+    }
+    size_t nLength = ReadLE32(size) + nTrailing;
+    if (pos.nPos + nLength > file->size()) {
+        file = GetFile(pos, prefix, pos.nPos + nLength);
+        if (!file)
+            return false;
+    }
+
+    file->Prefetch(pos.nPos, nLength);
+    record.vch.resize(nLength);
+    if (!file->Read(pos.nPos, nLength, record.vch.data())) {
+        LogPrintf("%s: unable to read %s%05u.dat at %u through its mapping, reading it through stdio\n", __func__,
+                  prefix, pos.nFile, pos.nPos);
+        Invalidate(pos.nFile);
+        return false;
+    }
+    return true;
+}
+
+void CBlockFileMapper::Invalidate(int nFile)
+{
+    LOCK(cs);
+    for (const char* prefix : {"blk", "rev"}) {
+        auto it = mapFiles.find(FileKey(prefix, nFile));
+        if (it != mapFiles.end()) {
+            lruFiles.erase(it->second.itLRU);
+            mapFiles.erase(it);
+        }
+    }
+}
+
+void CBlockFileMapper::Clear()
+{
+    LOCK(cs);
+    mapFiles.clear();
+    lruFiles.clear();
+}
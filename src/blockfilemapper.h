@@ -0,0 +1,136 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_BLOCKFILEMAPPER_H
+#define BZX_BLOCKFILEMAPPER_H
+
+#include "sync.h"
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stddef.h>
+
+struct CDiskBlockPos;
+
+//! -blockmmap default. Off, I/O errors on mapped pages are only seen through a SIGBUS handler
+static const bool DEFAULT_BLOCKMMAP = false;
+//! -blockmmapfiles default
+static const int DEFAULT_BLOCKMMAP_FILES = 64;
+
+/** Read-only mapping of one blk?????.dat or rev?????.dat file */
+class CMappedBlockFile
+{
+private:
+    const std::string strPath;
+    const unsigned char* pbegin;
+    size_t nSize;
+    //! End of the last record read from the file, to detect sequential reads
+    mutable std::atomic<size_t> nLastReadEnd;
+    //! Offset up to which readahead has been requested
+    mutable std::atomic<size_t> nReadaheadEnd;
+
+public:
+    CMappedBlockFile(const std::string& strPathIn, const unsigned char* pbeginIn, size_t nSizeIn);
+    ~CMappedBlockFile();
+
+    CMappedBlockFile(const CMappedBlockFile&) = delete;
+    CMappedBlockFile& operator=(const CMappedBlockFile&) = delete;
+
+    const unsigned char* data() const { return pbegin; }
+    size_t size() const { return nSize; }
+
+    /**
+     * Tell the kernel the record [nOffset, nOffset + nLength) is about to be
+     * read. When the record follows the one read before it, the next
+     * READAHEAD bytes are requested as well, so block-by-block scans don't
+     * wait for the disk on every block.
+     */
+    void Prefetch(size_t nOffset, size_t nLength) const;
+
+    /**
+     * Check that the file still covers [nOffset, nOffset + nLength) and copy
+     * the range to pdest. Returns false if the file shrank or reading a page
+     * failed, the SIGBUS this raises is caught while the range is copied.
+     */
+    bool Read(size_t nOffset, size_t nLength, unsigned char* pdest) const;
+
+    static const size_t READAHEAD = 8 << 20;
+};
+
+/** One record of a block file: the bytes of a block or undo entry, copied out of the mapping */
+class CMappedBlockRecord
+{
+    friend class CBlockFileMapper;
+
+private:
+    std::vector<unsigned char> vch;
+
+public:
+    const unsigned char* begin() const { return vch.data(); }
+    const unsigned char* end() const { return vch.data() + vch.size(); }
+};
+
+/**
+ * Memory maps block and undo files so records are copied straight from the
+ * page cache, without a file open, seek and buffered read through stdio per
+ * read.
+ *
+ * At most nMaxFiles files are mapped at a time, the least recently used ones
+ * are unmapped first. Mappings are shared and read-only and a mapping stays
+ * valid while a record is copied from it, even when it is evicted or the file
+ * is pruned meanwhile. Files that grew since they were mapped are mapped again
+ * on the first read past the old end.
+ *
+ * Records are located through the size field stored in front of them by
+ * WriteBlockToDisk and UndoWriteToDisk. Every record is copied out of the
+ * mapping under a SIGBUS guard before it is handed out, callers deserialize
+ * the copy and never touch the mapping themselves. A file truncated or a page
+ * failing to read fails GetRecord and callers fall back to reading through
+ * stdio.
+ */
+class CBlockFileMapper
+{
+private:
+    typedef std::pair<std::string, int> FileKey;
+    typedef std::list<FileKey> LRUList;
+
+    struct MappedFile
+    {
+        std::shared_ptr<const CMappedBlockFile> file;
+        LRUList::iterator itLRU;
+    };
+
+    CCriticalSection cs;
+    std::map<FileKey, MappedFile> mapFiles;
+    //! Most recently used first
+    LRUList lruFiles;
+    const size_t nMaxFiles;
+
+    std::shared_ptr<const CMappedBlockFile> MapFile(const CDiskBlockPos& pos, const char* prefix) const;
+    std::shared_ptr<const CMappedBlockFile> GetFile(const CDiskBlockPos& pos, const char* prefix, size_t nMinSize);
+
+public:
+    explicit CBlockFileMapper(size_t nMaxFilesIn);
+
+    /**
+     * Find the record at pos in the prefix file, plus nTrailing bytes stored
+     * after it (the checksum of undo data).
+     */
+    bool GetRecord(const CDiskBlockPos& pos, const char* prefix, size_t nTrailing, CMappedBlockRecord& record);
+
+    //! Drop the mappings of file nFile, after it was truncated or deleted
+    void Invalidate(int nFile);
+    void Clear();
+};
+
+/** Global mapper of the block files, NULL when -blockmmap is off */
+extern CBlockFileMapper* pblockfilemapper;
+
+#endif // BZX_BLOCKFILEMAPPER_H
@@ -0,0 +1,224 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilterindex.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+
+#include <boost/filesystem.hpp>
+
+static const char DB_FILTER = 'F';
+static const char DB_BEST_BLOCK = 'B';
+
+//! Blocks indexed between two progress messages in the log
+static const int BLOCKFILTER_LOG_INTERVAL = 10000;
+
+CBlockFilterIndex* pblockfilterindex = nullptr;
+
+static boost::filesystem::path GetFilterIndexPath(BlockFilterType filterType)
+{
+    boost::filesystem::path path = GetDataDir() / "indexes" / "blockfilter";
+    boost::filesystem::create_directories(path);
+    return path / BlockFilterTypeName(filterType);
+}
+
+CBlockFilterIndex::CBlockFilterIndex(BlockFilterType filterType, size_t nCacheSize, bool fMemory, bool fWipe) :
+    filterType(filterType),
+    db(fMemory ? "" : GetFilterIndexPath(filterType), nCacheSize, fMemory, fWipe),
+    bestBlockIndex(nullptr),
+    fSynced(false)
+{
+}
+
+CBlockFilterIndex::~CBlockFilterIndex()
+{
+    Interrupt();
+    Stop();
+}
+
+bool CBlockFilterIndex::Init()
+{
+    uint256 bestHash;
+    if (!db.Read(DB_BEST_BLOCK, bestHash))
+        return true;
+
+    LOCK(cs_main);
+    BlockMap::const_iterator it = mapBlockIndex.find(bestHash);
+    if (it == mapBlockIndex.end())
+        return error("%s: best block %s of the %s filter index is not in the block index", __func__, bestHash.ToString(), BlockFilterTypeName(filterType));
+
+    // Filters are stored by block hash, so after a reorg we only have to continue from the fork point
+    bestBlockIndex = chainActive.FindFork(it->second);
+    return true;
+}
+
+void CBlockFilterIndex::Start()
+{
+    // can't start new thread if we have one running already
+    if (syncThread.joinable()) {
+        assert(false);
+    }
+
+    syncThread = std::thread(&TraceThread<std::function<void()> >,
+        "blockfilter",
+        std::function<void()>(std::bind(&CBlockFilterIndex::ThreadSync, this)));
+}
+
+void CBlockFilterIndex::Interrupt()
+{
+    syncInterrupt();
+}
+
+void CBlockFilterIndex::Stop()
+{
+    if (syncThread.joinable()) {
+        syncThread.join();
+    }
+}
+
+bool CBlockFilterIndex::ReadEntry(const uint256& blockHash, CFilterEntry& entry) const
+{
+    return db.Read(std::make_pair(DB_FILTER, blockHash), entry);
+}
+
+bool CBlockFilterIndex::WriteBlock(const CBlockIndex* pindex)
+{
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+        return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+
+    CBlockUndo blockUndo;
+    uint256 prevHeader;
+    if (pindex->pprev) {
+        CDiskBlockPos undoPos;
+        {
+            LOCK(cs_main);
+            undoPos = pindex->GetUndoPos();
+        }
+        if (undoPos.IsNull() || !UndoReadFromDisk(blockUndo, undoPos, pindex->pprev->GetBlockHash()))
+            return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+
+        CFilterEntry prevEntry;
+        if (!ReadEntry(pindex->pprev->GetBlockHash(), prevEntry))
+            return error("%s: filter of block %s not found", __func__, pindex->pprev->GetBlockHash().ToString());
+        prevHeader = prevEntry.header;
+    }
+
+    BlockFilter filter(filterType, block, blockUndo);
+
+    CFilterEntry entry;
+    entry.hash = filter.GetHash();
+    entry.header = filter.ComputeHeader(prevHeader);
+    entry.filter = filter.GetEncodedFilter();
+
+    CDBBatch batch(db);
+    batch.Write(std::make_pair(DB_FILTER, pindex->GetBlockHash()), entry);
+    batch.Write(DB_BEST_BLOCK, pindex->GetBlockHash());
+    return db.WriteBatch(batch);
+}
+
+void CBlockFilterIndex::ThreadSync()
+{
+    const std::string& name = BlockFilterTypeName(filterType);
+    int64_t nLastLogTime = 0;
+
+    while (!syncInterrupt) {
+        const CBlockIndex* pindexNext;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* pindexBest = bestBlockIndex;
+            if (pindexBest && !chainActive.Contains(pindexBest)) {
+                pindexBest = chainActive.FindFork(pindexBest);
+                bestBlockIndex = pindexBest;
+            }
+            pindexNext = pindexBest ? chainActive.Next(pindexBest) : chainActive.Genesis();
+        }
+
+        if (!pindexNext) {
+            if (!fSynced) {
+                const CBlockIndex* pindexBest = bestBlockIndex;
+                LogPrintf("%s filter index is synced to height %d\n", name, pindexBest ? pindexBest->nHeight : -1);
+                fSynced = true;
+            }
+            syncInterrupt.sleep_for(std::chrono::milliseconds(500));
+            continue;
+        }
+
+        // Don't compete with the initial sync for the disk, filters are only served once we are synced anyway
+        if (!fSynced && (fImporting || fReindex)) {
+            syncInterrupt.sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+
+        if (!WriteBlock(pindexNext)) {
+            LogPrintf("%s: failed to index block %s, %s filter index stopped\n", __func__, pindexNext->GetBlockHash().ToString(), name);
+            return;
+        }
+        bestBlockIndex = pindexNext;
+
+        int64_t nNow = GetTime();
+        if (!fSynced && (pindexNext->nHeight % BLOCKFILTER_LOG_INTERVAL == 0 || nNow - nLastLogTime >= 30)) {
+            LogPrintf("Syncing %s filter index with block chain from height %d\n", name, pindexNext->nHeight);
+            nLastLogTime = nNow;
+        }
+    }
+
+    db.Sync();
+}
+
+bool CBlockFilterIndex::LookupFilter(const CBlockIndex* pindex, BlockFilter& filterOut) const
+{
+    CFilterEntry entry;
+    if (!ReadEntry(pindex->GetBlockHash(), entry))
+        return false;
+
+    try {
+        filterOut = BlockFilter(filterType, pindex->GetBlockHash(), std::move(entry.filter));
+    } catch (const std::exception& e) {
+        return error("%s: corrupt filter for block %s: %s", __func__, pindex->GetBlockHash().ToString(), e.what());
+    }
+    return true;
+}
+
+bool CBlockFilterIndex::LookupFilterHeader(const CBlockIndex* pindex, uint256& headerOut) const
+{
+    CFilterEntry entry;
+    if (!ReadEntry(pindex->GetBlockHash(), entry))
+        return false;
+
+    headerOut = entry.header;
+    return true;
+}
+
+bool CBlockFilterIndex::LookupFilterRange(int startHeight, const CBlockIndex* stopIndex, std::vector<BlockFilter>& filtersOut) const
+{
+    if (startHeight < 0 || startHeight > stopIndex->nHeight)
+        return false;
+
+    filtersOut.resize(stopIndex->nHeight - startHeight + 1);
+    for (const CBlockIndex* pindex = stopIndex; pindex && pindex->nHeight >= startHeight; pindex = pindex->pprev) {
+        if (!LookupFilter(pindex, filtersOut[pindex->nHeight - startHeight]))
+            return false;
+    }
+    return true;
+}
+
+bool CBlockFilterIndex::LookupFilterHashRange(int startHeight, const CBlockIndex* stopIndex, std::vector<uint256>& hashesOut) const
+{
+    if (startHeight < 0 || startHeight > stopIndex->nHeight)
+        return false;
+
+    hashesOut.resize(stopIndex->nHeight - startHeight + 1);
+    for (const CBlockIndex* pindex = stopIndex; pindex && pindex->nHeight >= startHeight; pindex = pindex->pprev) {
+        CFilterEntry entry;
+        if (!ReadEntry(pindex->GetBlockHash(), entry))
+            return false;
+        hashesOut[pindex->nHeight - startHeight] = entry.hash;
+    }
+    return true;
+}
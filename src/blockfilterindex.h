@@ -0,0 +1,96 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_BLOCKFILTERINDEX_H
+#define BZX_BLOCKFILTERINDEX_H
+
+#include "blockfilter.h"
+#include "dbwrapper.h"
+#include "sync.h"
+#include "threadinterrupt.h"
+#include "uint256.h"
+
+#include <atomic>
+#include <thread>
+
+class CBlockIndex;
+
+//! -blockfilterindex default
+static const bool DEFAULT_BLOCKFILTERINDEX = false;
+//! -peerblockfilters default
+static const bool DEFAULT_PEERBLOCKFILTERS = false;
+
+/** Maximum number of filters a peer may request with one getcfilters message (BIP 157) */
+static const int MAX_GETCFILTERS_SIZE = 1000;
+/** Maximum number of filter hashes a peer may request with one getcfheaders message (BIP 157) */
+static const int MAX_GETCFHEADERS_SIZE = 2000;
+/** Interval between filter header checkpoints (BIP 157) */
+static const int CFCHECKPT_INTERVAL = 1000;
+
+/**
+ * Compact block filter index. Filters are built by a background thread which
+ * follows the active chain, and are stored by block hash in their own
+ * database under <datadir>/indexes/blockfilter/<type>, so light clients can
+ * be served from precomputed data instead of per-peer block scans.
+ */
+class CBlockFilterIndex
+{
+public:
+    struct CFilterEntry
+    {
+        uint256 hash;
+        uint256 header;
+        std::vector<unsigned char> filter;
+
+        ADD_SERIALIZE_METHODS;
+
+        template <typename Stream, typename Operation>
+        inline void SerializationOp(Stream& s, Operation ser_action)
+        {
+            READWRITE(hash);
+            READWRITE(header);
+            READWRITE(filter);
+        }
+    };
+
+private:
+    BlockFilterType filterType;
+    CDBWrapper db;
+
+    //! Last block of the active chain the index has a filter for
+    std::atomic<const CBlockIndex*> bestBlockIndex;
+    std::atomic<bool> fSynced;
+
+    std::thread syncThread;
+    CThreadInterrupt syncInterrupt;
+
+    bool ReadEntry(const uint256& blockHash, CFilterEntry& entry) const;
+    //! Build and store the filter of a block whose parent is already indexed
+    bool WriteBlock(const CBlockIndex* pindex);
+    void ThreadSync();
+
+public:
+    CBlockFilterIndex(BlockFilterType filterType, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    ~CBlockFilterIndex();
+
+    //! Load the best indexed block, must be called after the block index is loaded
+    bool Init();
+    void Start();
+    void Interrupt();
+    void Stop();
+
+    BlockFilterType GetFilterType() const { return filterType; }
+    const CBlockIndex* GetBestBlockIndex() const { return bestBlockIndex; }
+    bool IsSynced() const { return fSynced; }
+
+    bool LookupFilter(const CBlockIndex* pindex, BlockFilter& filterOut) const;
+    bool LookupFilterHeader(const CBlockIndex* pindex, uint256& headerOut) const;
+    //! Filters of the blocks from startHeight up to stopIndex, all of which must be indexed
+    bool LookupFilterRange(int startHeight, const CBlockIndex* stopIndex, std::vector<BlockFilter>& filtersOut) const;
+    bool LookupFilterHashRange(int startHeight, const CBlockIndex* stopIndex, std::vector<uint256>& hashesOut) const;
+};
+
+extern CBlockFilterIndex* pblockfilterindex;
+
+#endif // BZX_BLOCKFILTERINDEX_H
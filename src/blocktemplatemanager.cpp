@@ -0,0 +1,338 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blocktemplatemanager.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "evo/deterministicmns.h"
+#include "miner.h"
+#include "script/script.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include <functional>
+
+#include <boost/bind.hpp>
+
+CBlockTemplateManager* pblocktemplatemanager = NULL;
+
+namespace {
+
+CAmount GetTemplateFees(const CBlockTemplate& blocktemplate)
+{
+    // vTxFees[0] belongs to the coinbase and holds the negated total
+    return blocktemplate.vTxFees.empty() ? 0 : -blocktemplate.vTxFees[0];
+}
+
+} // anon namespace
+
+CBlockTemplateManager::CBlockTemplateManager(const CChainParams& chainparamsIn) :
+    chainparams(chainparamsIn),
+    pindexPrev(NULL),
+    nTemplateId(0),
+    nAnnouncedFees(0),
+    nBuildTime(0),
+    fValidated(false),
+    fRebuild(false),
+    fNewTip(false),
+    nLastRequestTime(0),
+    fInterrupt(false)
+{
+    nFeeDeltaPercent = std::max<int64_t>(GetArg("-blocktemplatefeedelta", DEFAULT_BLOCKTEMPLATE_FEE_DELTA), 0);
+    nRebuildInterval = std::max<int64_t>(GetArg("-blocktemplateinterval", DEFAULT_BLOCKTEMPLATE_INTERVAL), 0);
+}
+
+CBlockTemplateManager::~CBlockTemplateManager()
+{
+    Interrupt();
+    Stop();
+}
+
+void CBlockTemplateManager::Start()
+{
+    // can't start new thread if we have one running already
+    if (updateThread.joinable()) {
+        assert(false);
+    }
+
+    RegisterValidationInterface(this);
+    mempool.NotifyEntryRemoved.connect(boost::bind(&CBlockTemplateManager::NotifyEntryRemoved, this, _1, _2));
+
+    updateThread = std::thread(&TraceThread<std::function<void()> >,
+        "blocktemplate",
+        std::function<void()>(std::bind(&CBlockTemplateManager::ThreadUpdate, this)));
+}
+
+void CBlockTemplateManager::Interrupt()
+{
+    std::unique_lock<std::mutex> lock(cs);
+    fInterrupt = true;
+    cvUpdate.notify_all();
+    cvTemplate.notify_all();
+}
+
+void CBlockTemplateManager::Stop()
+{
+    if (updateThread.joinable()) {
+        updateThread.join();
+        mempool.NotifyEntryRemoved.disconnect(boost::bind(&CBlockTemplateManager::NotifyEntryRemoved, this, _1, _2));
+        UnregisterValidationInterface(this);
+    }
+}
+
+bool CBlockTemplateManager::IsActive() const
+{
+    return nLastRequestTime != 0 && GetTime() - nLastRequestTime < BLOCKTEMPLATE_IDLE_TIMEOUT;
+}
+
+void CBlockTemplateManager::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    std::unique_lock<std::mutex> lock(cs);
+    fNewTip = true;
+    cvUpdate.notify_one();
+}
+
+void CBlockTemplateManager::SyncTransaction(const CTransaction &tx, const CBlockIndex *pindex, int posInBlock)
+{
+    // transactions of connected blocks are covered by UpdatedBlockTip
+    if (posInBlock != CMainSignals::SYNC_TRANSACTION_NOT_IN_BLOCK || tx.IsCoinBase())
+        return;
+    std::unique_lock<std::mutex> lock(cs);
+    // nothing is applied while idle, the next request builds a new template instead
+    if (IsActive())
+        vAddedTxs.push_back(tx.GetHash());
+    else
+        fRebuild = true;
+    cvUpdate.notify_one();
+}
+
+void CBlockTemplateManager::NotifyEntryRemoved(CTransactionRef tx, MemPoolRemovalReason reason)
+{
+    if (reason == MemPoolRemovalReason::BLOCK)
+        return;
+    std::unique_lock<std::mutex> lock(cs);
+    if (IsActive())
+        setRemovedTxs.insert(tx->GetHash());
+    else
+        fRebuild = true;
+    cvUpdate.notify_one();
+}
+
+void CBlockTemplateManager::Publish(std::unique_ptr<CBlockTemplate> pblocktemplateNew, const CBlockIndex* pindexPrevNew,
+                                    bool fFullBuild, bool fAnnounce, int64_t nTimeStart)
+{
+    CAmount nFees = GetTemplateFees(*pblocktemplateNew);
+    fAnnounce |= pindexPrevNew != pindexPrev || nTemplateId == 0;
+    if (!fAnnounce && nFees > nAnnouncedFees)
+        fAnnounce = nFees - nAnnouncedFees >= nAnnouncedFees * nFeeDeltaPercent / 100;
+
+    size_t nTx = pblocktemplateNew->block.vtx.size();
+    pblocktemplate = std::move(pblocktemplateNew);
+    pindexPrev = pindexPrevNew;
+    // CreateNewBlock checked full builds already
+    fValidated = fFullBuild;
+    if (fFullBuild)
+        nBuildTime = GetTimeMillis();
+    if (fAnnounce) {
+        nTemplateId++;
+        nAnnouncedFees = nFees;
+        cvTemplate.notify_all();
+    }
+
+    LogPrint("bench", "%s: %s template %d at height %d, %u txs, fees %d%s (%.2fms)\n", __func__, fFullBuild ? "built" : "updated",
+             nTemplateId, pindexPrev->nHeight + 1, nTx, nFees, fAnnounce ? ", announced" : "", 0.001 * (GetTimeMicros() - nTimeStart));
+}
+
+bool CBlockTemplateManager::Build()
+{
+    LOCK(cs_main);
+
+    const CBlockIndex* pindexPrevNew = chainActive.Tip();
+    if (!pindexPrevNew)
+        return false;
+
+    {
+        // the build covers everything in the mempool from here on
+        std::unique_lock<std::mutex> lock(cs);
+        vAddedTxs.clear();
+        setRemovedTxs.clear();
+        fRebuild = false;
+        fNewTip = false;
+    }
+
+    int64_t nTimeStart = GetTimeMicros();
+    // The coinbase is replaced by the requests, any script will do
+    CScript scriptDummy = CScript() << OP_TRUE;
+    std::unique_ptr<CBlockTemplate> pblocktemplateNew = BlockAssembler(chainparams).CreateNewBlock(scriptDummy);
+    if (!pblocktemplateNew)
+        return false;
+
+    std::unique_lock<std::mutex> lock(cs);
+    Publish(std::move(pblocktemplateNew), pindexPrevNew, true, false, nTimeStart);
+    return true;
+}
+
+bool CBlockTemplateManager::Update()
+{
+    std::shared_ptr<const CBlockTemplate> pblocktemplateOld;
+    const CBlockIndex* pindexPrevOld;
+    std::vector<uint256> vAdded;
+    std::set<uint256> setRemoved;
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        pblocktemplateOld = pblocktemplate;
+        pindexPrevOld = pindexPrev;
+        vAdded.swap(vAddedTxs);
+        setRemoved.swap(setRemovedTxs);
+    }
+    if (!pblocktemplateOld)
+        return Build();
+
+    int64_t nTimeStart = GetTimeMicros();
+    std::unique_ptr<CBlockTemplate> pblocktemplateNew;
+    bool fTipChanged = false;
+    bool fRemoved = false;
+    bool fRemoveFailed = false;
+    bool fRebuildNew = false;
+    {
+        // The transactions are checked against the tip, its masternode list and the InstantSend and ChainLocks state
+        LOCK2(cs_main, mempool.cs);
+        fTipChanged = chainActive.Tip() != pindexPrevOld;
+        if (!fTipChanged) {
+            CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(pindexPrevOld);
+            if (!setRemoved.empty()) {
+                pblocktemplateNew = BlockAssembler::RemoveFromTemplate(*pblocktemplateOld, mnList, setRemoved);
+                if (!pblocktemplateNew)
+                    fRemoveFailed = true;
+                else
+                    fRemoved = pblocktemplateNew->block.vtx.size() != pblocktemplateOld->block.vtx.size();
+            }
+            if (!fRemoveFailed && !vAdded.empty()) {
+                const CBlockTemplate& base = pblocktemplateNew ? *pblocktemplateNew : *pblocktemplateOld;
+                std::unique_ptr<CBlockTemplate> pblocktemplateAdded =
+                    BlockAssembler(chainparams).AddToTemplate(base, pindexPrevOld, mnList, vAdded, fRebuildNew);
+                if (pblocktemplateAdded)
+                    pblocktemplateNew = std::move(pblocktemplateAdded);
+            }
+        }
+    }
+
+    // The template is on an old tip or still holds a transaction which left the mempool, that can't wait for the
+    // rebuild interval
+    if (fTipChanged || fRemoveFailed)
+        return Build();
+
+    std::unique_lock<std::mutex> lock(cs);
+    fRebuild |= fRebuildNew;
+    if (pblocktemplate != pblocktemplateOld) {
+        // another template was published meanwhile, apply the changes to that one next time
+        vAddedTxs.insert(vAddedTxs.begin(), vAdded.begin(), vAdded.end());
+        setRemovedTxs.insert(setRemoved.begin(), setRemoved.end());
+        return true;
+    }
+    if (pblocktemplateNew)
+        Publish(std::move(pblocktemplateNew), pindexPrevOld, false, fRemoved, nTimeStart);
+    return true;
+}
+
+void CBlockTemplateManager::ThreadUpdate()
+{
+    while (!fInterrupt) {
+        bool fFullBuild;
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            bool fPending = !vAddedTxs.empty() || !setRemovedTxs.empty();
+            if (!IsActive() || !(fNewTip || fPending || fRebuild)) {
+                cvUpdate.wait_for(lock, std::chrono::seconds(1));
+                continue;
+            }
+
+            // a new tip is built on right away and mempool changes are applied as they come, changes which need a
+            // full build are collected for a while
+            fFullBuild = fNewTip || !pblocktemplate;
+            if (!fFullBuild && !fPending) {
+                int64_t nWait = nBuildTime + nRebuildInterval - GetTimeMillis();
+                if (nWait > 0) {
+                    cvUpdate.wait_for(lock, std::chrono::milliseconds(nWait));
+                    continue;
+                }
+                fFullBuild = true;
+            }
+        }
+
+        bool fDone = false;
+        try {
+            fDone = fFullBuild ? Build() : Update();
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+        }
+
+        if (!fDone) {
+            LogPrintf("%s: failed to create a block template\n", __func__);
+            // wait for the next change instead of retrying right away, requests still build their own
+            std::unique_lock<std::mutex> lock(cs);
+            vAddedTxs.clear();
+            setRemovedTxs.clear();
+            fRebuild = false;
+            fNewTip = false;
+        }
+    }
+}
+
+std::shared_ptr<const CBlockTemplate> CBlockTemplateManager::GetBlockTemplate(const CBlockIndex*& pindexPrevOut, uint64_t& nTemplateIdOut)
+{
+    AssertLockHeld(cs_main);
+
+    bool fBuild, fUpdate;
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        nLastRequestTime = GetTime();
+        bool fOutdated = fRebuild && GetTimeMillis() - nBuildTime > BLOCKTEMPLATE_MAX_STALE_AGE * 1000;
+        fBuild = !pblocktemplate || pindexPrev != chainActive.Tip() || fOutdated;
+        fUpdate = !vAddedTxs.empty() || !setRemovedTxs.empty();
+    }
+
+    if (fBuild ? !Build() : fUpdate && !Update())
+        return nullptr;
+
+    std::shared_ptr<const CBlockTemplate> pblocktemplateOut;
+    bool fCheck;
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        pblocktemplateOut = pblocktemplate;
+        pindexPrevOut = pindexPrev;
+        nTemplateIdOut = nTemplateId;
+        fCheck = !fValidated;
+    }
+    if (!fCheck)
+        return pblocktemplateOut;
+
+    CValidationState state;
+    if (pindexPrevOut == chainActive.Tip() && TestBlockValidity(state, chainparams, pblocktemplateOut->block, chainActive.Tip(), false, false)) {
+        std::unique_lock<std::mutex> lock(cs);
+        if (pblocktemplate == pblocktemplateOut)
+            fValidated = true;
+        return pblocktemplateOut;
+    }
+
+    LogPrintf("%s: updated template failed TestBlockValidity: %s, building a new one\n", __func__, FormatStateMessage(state));
+    if (!Build())
+        return nullptr;
+    std::unique_lock<std::mutex> lock(cs);
+    pindexPrevOut = pindexPrev;
+    nTemplateIdOut = nTemplateId;
+    return pblocktemplate;
+}
+
+bool CBlockTemplateManager::WaitForNewTemplate(const uint256& hashPrevBlock, uint64_t nKnownTemplateId, int64_t nTimeoutMs)
+{
+    std::unique_lock<std::mutex> lock(cs);
+    nLastRequestTime = GetTime();
+    return cvTemplate.wait_for(lock, std::chrono::milliseconds(nTimeoutMs), [&] {
+        return fInterrupt || !pindexPrev || pindexPrev->GetBlockHash() != hashPrevBlock || nTemplateId != nKnownTemplateId;
+    });
+}
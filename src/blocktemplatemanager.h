@@ -0,0 +1,128 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_BLOCKTEMPLATEMANAGER_H
+#define BZX_BLOCKTEMPLATEMANAGER_H
+
+#include "amount.h"
+#include "primitives/transaction.h"
+#include "txmempool.h"
+#include "validationinterface.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+class CChainParams;
+struct CBlockTemplate;
+
+//! -blocktemplatefeedelta default, in percent of the fees of the last announced template
+static const unsigned int DEFAULT_BLOCKTEMPLATE_FEE_DELTA = 1;
+//! -blocktemplateinterval default, minimum time in ms between full rebuilds for mempool changes that can't be applied incrementally
+static const int64_t DEFAULT_BLOCKTEMPLATE_INTERVAL = 5000;
+//! Templates are only kept up to date for this many seconds after the last request
+static const int64_t BLOCKTEMPLATE_IDLE_TIMEOUT = 5 * 60;
+//! Requests build a template themselves if a full rebuild is pending and the last one is older than this many seconds
+static const int64_t BLOCKTEMPLATE_MAX_STALE_AGE = 5;
+
+/**
+ * Keeps a block template on the current tip ready for getblocktemplate.
+ *
+ * The template is fully built with CreateNewBlock once per tip. After that,
+ * transactions entering or leaving the mempool are applied to it
+ * incrementally by a worker thread, without walking the mempool: new
+ * transactions whose unconfirmed parents are in the template already are
+ * appended if they fit, removed ones are taken out together with their
+ * in-template descendants. Changes that could affect the rest of the block
+ * (special transactions, spent masternode collateral, packages paying for
+ * missing parents, a full block) wait for a full rebuild, at most once every
+ * -blocktemplateinterval ms. Requests are answered from the last template,
+ * an incrementally updated one goes through TestBlockValidity before it is
+ * served for the first time.
+ *
+ * Every template has an id which only changes with the tip or once the
+ * template fees grew by -blocktemplatefeedelta percent, longpolling miners
+ * wait for the id to change instead of being woken up for every transaction.
+ *
+ * Nothing is updated in the background until the first request and after
+ * BLOCKTEMPLATE_IDLE_TIMEOUT seconds without one.
+ */
+class CBlockTemplateManager : public CValidationInterface
+{
+private:
+    const CChainParams& chainparams;
+    CAmount nFeeDeltaPercent;
+    int64_t nRebuildInterval;
+
+    mutable std::mutex cs;
+    //! Signalled when the template gets outdated or on interruption
+    std::condition_variable cvUpdate;
+    //! Signalled when a template with a new id is published or on interruption
+    std::condition_variable cvTemplate;
+
+    std::shared_ptr<const CBlockTemplate> pblocktemplate;
+    const CBlockIndex* pindexPrev;
+    uint64_t nTemplateId;
+    //! Fees of the template announced with nTemplateId
+    CAmount nAnnouncedFees;
+    //! Time of the last full build in ms
+    int64_t nBuildTime;
+    //! The published template passed TestBlockValidity
+    bool fValidated;
+    //! Mempool changes not applied to the template yet
+    std::vector<uint256> vAddedTxs;
+    std::set<uint256> setRemovedTxs;
+    //! Some change couldn't be applied incrementally
+    bool fRebuild;
+    bool fNewTip;
+    int64_t nLastRequestTime;
+
+    std::atomic<bool> fInterrupt;
+    std::thread updateThread;
+
+    //! Build a template on the current tip and publish it
+    bool Build();
+    //! Apply the pending mempool changes to the last template and publish it
+    bool Update();
+    //! Publish a template, with a new id if fAnnounce. Must be called with cs held
+    void Publish(std::unique_ptr<CBlockTemplate> pblocktemplateNew, const CBlockIndex* pindexPrevNew, bool fFullBuild, bool fAnnounce,
+                 int64_t nTimeStart);
+    bool IsActive() const;
+    void NotifyEntryRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
+    void ThreadUpdate();
+
+protected:
+    // CValidationInterface
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+    void SyncTransaction(const CTransaction &tx, const CBlockIndex *pindex, int posInBlock) override;
+
+public:
+    CBlockTemplateManager(const CChainParams& chainparams);
+    ~CBlockTemplateManager();
+
+    void Start();
+    void Interrupt();
+    void Stop();
+
+    /**
+     * Template on the current tip, built right away if there isn't one yet.
+     * The template is shared, callers modifying it have to copy it first.
+     * Must be called with cs_main held.
+     */
+    std::shared_ptr<const CBlockTemplate> GetBlockTemplate(const CBlockIndex*& pindexPrevOut, uint64_t& nTemplateIdOut);
+
+    /**
+     * Wait until the template is built on another block than hashPrevBlock or
+     * its id differs from nKnownTemplateId. Returns false on timeout.
+     */
+    bool WaitForNewTemplate(const uint256& hashPrevBlock, uint64_t nKnownTemplateId, int64_t nTimeoutMs);
+};
+
+extern CBlockTemplateManager* pblocktemplatemanager;
+
+#endif // BZX_BLOCKTEMPLATEMANAGER_H
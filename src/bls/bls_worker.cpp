@@ -4,10 +4,13 @@
 
 #include <bls/bls_worker.h>
 #include <hash.h>
+#include <random.h>
 #include <serialize.h>
 
 #include <util.h>
 
+#include <limits>
+
 template <typename T>
 bool VerifyVectorHelper(const std::vector<T>& vec, size_t start, size_t count)
 {
@@ -394,51 +397,117 @@ struct VectorAggregator {
     }
 };
 
+// Sum of weights[i] * points[i] with the bucket method. For every window of c bits of the weights the points are
+// added into the bucket of their digit, the buckets are then summed up through a running sum so that bucket b is
+// counted b times. The window sums are combined Horner style, which costs about 64 / c * (n + 2^(c + 1)) additions
+// and 64 doublings instead of n multiplications. Works for public keys as well as for secret keys, whose additions
+// are plain scalar additions
+template <typename T>
+static T WeightedSum(const std::vector<const T*>& points, const std::vector<uint64_t>& weights)
+{
+    assert(!points.empty() && points.size() == weights.size());
+
+    size_t c = 1;
+    size_t bestCost = std::numeric_limits<size_t>::max();
+    for (size_t w = 1; w <= 8; w++) {
+        size_t cost = (64 + w - 1) / w * (points.size() + (size_t(2) << w));
+        if (cost < bestCost) {
+            bestCost = cost;
+            c = w;
+        }
+    }
+    const size_t windowCount = (64 + c - 1) / c;
+    const uint64_t mask = (uint64_t(1) << c) - 1;
+
+    auto add = [](T& sum, const T& v) {
+        if (sum.IsValid()) {
+            sum.AggregateInsecure(v);
+        } else {
+            sum = v;
+        }
+    };
+
+    T sum;
+    std::vector<std::vector<T> > buckets(mask + 1);
+    for (size_t w = windowCount; w-- > 0;) {
+        // sum *= 2^c
+        for (size_t i = 0; i < c && sum.IsValid(); i++) {
+            T prev = sum;
+            sum.AggregateInsecure(prev);
+        }
+
+        for (auto& bucket : buckets) {
+            bucket.clear();
+        }
+        for (size_t i = 0; i < points.size(); i++) {
+            uint64_t digit = (weights[i] >> (w * c)) & mask;
+            if (digit != 0) {
+                buckets[digit].emplace_back(*points[i]);
+            }
+        }
+
+        T running;
+        T windowSum;
+        for (size_t b = mask; b > 0; b--) {
+            if (!buckets[b].empty()) {
+                add(running, T::AggregateInsecure(buckets[b]));
+            }
+            if (running.IsValid()) {
+                add(windowSum, running);
+            }
+        }
+        if (windowSum.IsValid()) {
+            add(sum, windowSum);
+        }
+    }
+    return sum;
+}
+
 // See comment of AsyncVerifyContributionShares for a description on what this does
 // Same rules as in Aggregator apply for the inputs
 struct ContributionVerifier {
+    // batches of this size or smaller are verified one by one instead of being split further
+    static const size_t MIN_BATCH_SIZE = 4;
+
+    // A range of candidates verified with a single randomized check. The weighted sums of every vvec entry and of
+    // the secret key shares are separate jobs, the last one to finish does the check
     struct BatchState {
         size_t start;
         size_t count;
 
-        BLSVerificationVectorPtr vvec;
-        CBLSSecretKey skShare;
-
-        // starts with 0 and is incremented if either vvec or skShare aggregation finishs. If it reaches 2, we know
-        // that aggregation for this batch is fully done. We can then start verification.
-        std::unique_ptr<std::atomic<int> > aggDone;
+        BLSVerificationVector vvec;
+        CBLSPublicKey pubKey;
 
-        // we can't directly update a vector<bool> in parallel
-        // as vector<bool> is not thread safe (uses bitsets internally)
-        // so we must use vector<char> temporarely and concatenate/convert
-        // each batch result into a final vector<bool>
-        std::vector<char> verifyResults;
+        std::atomic<size_t> pending{0};
     };
 
     CBLSId forId;
     const std::vector<BLSVerificationVectorPtr>& vvecs;
     const BLSSecretKeyVector& skShares;
-    size_t batchSize;
     bool parallel;
     bool aggregated;
 
     ctpl::thread_pool& workerPool;
 
-    size_t batchCount;
-    size_t verifyCount;
+    // random odd weights of the entries, the senders can't know them when creating their contributions
+    std::vector<uint64_t> weights;
+    // entries that take part in the batched checks
+    std::vector<size_t> candidates;
 
-    std::vector<BatchState> batchStates;
+    // we can't directly update a vector<bool> in parallel
+    // as vector<bool> is not thread safe (uses bitsets internally)
+    // so we must use vector<char> temporarely and convert it into a final vector<bool>
+    std::vector<char> verifyResults;
     std::atomic<size_t> verifyDoneCount{0};
     std::function<void(const std::vector<bool>&)> doneCallback;
 
     ContributionVerifier(const CBLSId& _forId, const std::vector<BLSVerificationVectorPtr>& _vvecs,
-                         const BLSSecretKeyVector& _skShares, size_t _batchSize,
-                         bool _parallel, bool _aggregated, ctpl::thread_pool& _workerPool,
+                         const BLSSecretKeyVector& _skShares, bool _parallel, bool _aggregated,
+                         ctpl::thread_pool& _workerPool,
                          std::function<void(const std::vector<bool>&)> _doneCallback) :
         forId(_forId),
         vvecs(_vvecs),
         skShares(_skShares),
-        batchSize(_batchSize),
         parallel(_parallel),
         aggregated(_aggregated),
         workerPool(_workerPool),
@@ -448,141 +517,158 @@ struct ContributionVerifier {
 
     void Start()
     {
-        if (!aggregated) {
-            // treat all inputs as one large batch
-            batchSize = vvecs.size();
-            batchCount = 1;
-        } else {
-            batchCount = (vvecs.size() + batchSize - 1) / batchSize;
+        size_t count = vvecs.size();
+        verifyResults.assign(count, 0);
+        if (count == 0) {
+            Finish();
+            return;
         }
-        verifyCount = vvecs.size();
 
-        batchStates.resize(batchCount);
-        for (size_t i = 0; i < batchCount; i++) {
-            auto& batchState = batchStates[i];
+        if (!aggregated) {
+            candidates.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                candidates[i] = i;
+            }
+            AsyncVerifyOneByOne(0, count);
+            return;
+        }
 
-            batchState.aggDone.reset(new std::atomic<int>(0));
-            batchState.start = i * batchSize;
-            batchState.count = std::min(batchSize, vvecs.size() - batchState.start);
-            batchState.verifyResults.assign(batchState.count, 0);
+        FastRandomContext rng;
+        weights.resize(count);
+        for (auto& w : weights) {
+            w = rng.rand64() | 1;
         }
 
-        if (aggregated) {
-            size_t batchCount2 = batchCount; // 'this' might get deleted while we're still looping
-            for (size_t i = 0; i < batchCount2; i++) {
-                AsyncAggregate(i);
+        for (size_t i = 0; i < count; i++) {
+            if (skShares[i].IsValid()) {
+                candidates.emplace_back(i);
             }
-        } else {
-            // treat all inputs as a single batch and verify one-by-one
-            AsyncVerifyBatchOneByOne(0);
+        }
+
+        // invalid contributions stay marked as failed
+        size_t candidateCount = candidates.size();
+        size_t invalidCount = count - candidateCount;
+        if (invalidCount != 0) {
+            HandleVerifyDone(invalidCount);
+        }
+        if (candidateCount != 0) {
+            AsyncVerifyBatch(0, candidateCount);
         }
     }
 
     void Finish()
     {
-        size_t batchIdx = 0;
-        std::vector<bool> result(vvecs.size());
-        for (size_t i = 0; i < vvecs.size(); i += batchSize) {
-            auto& batchState = batchStates[batchIdx++];
-            for (size_t j = 0; j < batchState.count; j++) {
-                result[batchState.start + j] = batchState.verifyResults[j] != 0;
-            }
+        std::vector<bool> result(verifyResults.size());
+        for (size_t i = 0; i < verifyResults.size(); i++) {
+            result[i] = verifyResults[i] != 0;
         }
         doneCallback(result);
         delete this;
     }
 
-    void AsyncAggregate(size_t batchIdx)
+    void HandleVerifyDone(size_t count)
     {
-        auto& batchState = batchStates[batchIdx];
-
-        // aggregate vvecs and skShares of batch in parallel
-        auto vvecAgg = new VectorAggregator<CBLSPublicKey>(vvecs, batchState.start, batchState.count, parallel, workerPool, std::bind(&ContributionVerifier::HandleAggVvecDone, this, batchIdx, std::placeholders::_1));
-        auto skShareAgg = new Aggregator<CBLSSecretKey>(skShares, batchState.start, batchState.count, parallel, workerPool, std::bind(&ContributionVerifier::HandleAggSkShareDone, this, batchIdx, std::placeholders::_1));
-
-        vvecAgg->Start();
-        skShareAgg->Start();
+        size_t c = verifyDoneCount += count;
+        if (c == verifyResults.size()) {
+            Finish();
+        }
     }
 
-    void HandleAggVvecDone(size_t batchIdx, const BLSVerificationVectorPtr& vvec)
+    // Verifies all candidates of the range at once: sum_i(w_i * vvec_i) must give the same public key share as
+    // sum_i(w_i * skShare_i) * G. The secret key shares are summed as scalars, so there is a single public key
+    // derivation per batch. Without the random weights, invalid contributions could cancel each other out
+    void AsyncVerifyBatch(size_t start, size_t count)
     {
-        auto& batchState = batchStates[batchIdx];
-        batchState.vvec = vvec;
-        if (++(*batchState.aggDone) == 2) {
-            HandleAggDone(batchIdx);
+        if (count <= MIN_BATCH_SIZE) {
+            AsyncVerifyOneByOne(start, count);
+            return;
         }
-    }
-    void HandleAggSkShareDone(size_t batchIdx, const CBLSSecretKey& skShare)
-    {
-        auto& batchState = batchStates[batchIdx];
-        batchState.skShare = skShare;
-        if (++(*batchState.aggDone) == 2) {
-            HandleAggDone(batchIdx);
+
+        auto batchState = std::make_shared<BatchState>();
+        batchState->start = start;
+        batchState->count = count;
+
+        size_t vvecSize = vvecs[candidates[start]]->size();
+        batchState->vvec.resize(vvecSize);
+        batchState->pending = vvecSize + 1;
+
+        for (size_t i = 0; i < vvecSize; i++) {
+            PushOrDoWork([this, batchState, i](int threadId) {
+                std::vector<const CBLSPublicKey*> points;
+                points.reserve(batchState->count);
+                for (size_t j = batchState->start; j < batchState->start + batchState->count; j++) {
+                    points.emplace_back(&(*vvecs[candidates[j]])[i]);
+                }
+                batchState->vvec[i] = WeightedSum(points, BatchWeights(*batchState));
+                if (--batchState->pending == 0) {
+                    HandleBatchSumsDone(batchState);
+                }
+            });
         }
+        PushOrDoWork([this, batchState](int threadId) {
+            std::vector<const CBLSSecretKey*> sks;
+            sks.reserve(batchState->count);
+            for (size_t j = batchState->start; j < batchState->start + batchState->count; j++) {
+                sks.emplace_back(&skShares[candidates[j]]);
+            }
+            batchState->pubKey = WeightedSum(sks, BatchWeights(*batchState)).GetPublicKey();
+            if (--batchState->pending == 0) {
+                HandleBatchSumsDone(batchState);
+            }
+        });
     }
 
-    void HandleVerifyDone(size_t batchIdx, size_t count)
+    std::vector<uint64_t> BatchWeights(const BatchState& batchState) const
     {
-        size_t c = verifyDoneCount += count;
-        if (c == verifyCount) {
-            Finish();
+        std::vector<uint64_t> ret;
+        ret.reserve(batchState.count);
+        for (size_t j = batchState.start; j < batchState.start + batchState.count; j++) {
+            ret.emplace_back(weights[candidates[j]]);
         }
+        return ret;
     }
 
-    void HandleAggDone(size_t batchIdx)
+    void HandleBatchSumsDone(const std::shared_ptr<BatchState>& batchState)
     {
-        auto& batchState = batchStates[batchIdx];
+        size_t start = batchState->start;
+        size_t count = batchState->count;
 
-        if (batchState.vvec == nullptr || batchState.vvec->empty() || !batchState.skShare.IsValid()) {
-            // something went wrong while aggregating and there is nothing we can do now except mark the whole batch as failed
-            // this can only happen if inputs were invalid in some way
-            batchState.verifyResults.assign(batchState.count, 0);
-            HandleVerifyDone(batchIdx, batchState.count);
+        CBLSPublicKey pk1;
+        if (pk1.PublicKeyShare(batchState->vvec, forId) && pk1 == batchState->pubKey) {
+            // whole batch is valid
+            for (size_t j = start; j < start + count; j++) {
+                verifyResults[candidates[j]] = 1;
+            }
+            HandleVerifyDone(count);
             return;
         }
 
-        AsyncAggregatedVerifyBatch(batchIdx);
+        // at least one entry in the batch is invalid, verify both halves on their own so that only the ranges
+        // containing invalid entries are split further. The weights are reused, they are still unknown to the senders
+        size_t half = count / 2;
+        AsyncVerifyBatch(start, half);
+        AsyncVerifyBatch(start + half, count - half);
     }
 
-    void AsyncAggregatedVerifyBatch(size_t batchIdx)
+    void AsyncVerifyOneByOne(size_t start, size_t count)
     {
-        auto f = [this, batchIdx](int threadId) {
-            auto& batchState = batchStates[batchIdx];
-            bool result = Verify(batchState.vvec, batchState.skShare);
-            if (result) {
-                // whole batch is valid
-                batchState.verifyResults.assign(batchState.count, 1);
-                HandleVerifyDone(batchIdx, batchState.count);
-            } else {
-                // at least one entry in the batch is invalid, revert to per-contribution verification (but parallelized)
-                AsyncVerifyBatchOneByOne(batchIdx);
-            }
-        };
-        PushOrDoWork(std::move(f));
-    }
-
-    void AsyncVerifyBatchOneByOne(size_t batchIdx)
-    {
-        size_t count = batchStates[batchIdx].count;
-        batchStates[batchIdx].verifyResults.assign(count, 0);
-        for (size_t i = 0; i < count; i++) {
-            auto f = [this, i, batchIdx](int threadId) {
-                auto& batchState = batchStates[batchIdx];
-                batchState.verifyResults[i] = Verify(vvecs[batchState.start + i], skShares[batchState.start + i]);
-                HandleVerifyDone(batchIdx, 1);
-            };
-            PushOrDoWork(std::move(f));
+        for (size_t j = start; j < start + count; j++) {
+            size_t idx = candidates[j];
+            PushOrDoWork([this, idx](int threadId) {
+                verifyResults[idx] = Verify(idx);
+                HandleVerifyDone(1);
+            });
         }
     }
 
-    bool Verify(const BLSVerificationVectorPtr& vvec, const CBLSSecretKey& skShare)
+    bool Verify(size_t idx)
     {
         CBLSPublicKey pk1;
-        if (!pk1.PublicKeyShare(*vvec, forId)) {
+        if (!pk1.PublicKeyShare(*vvecs[idx], forId)) {
             return false;
         }
 
-        CBLSPublicKey pk2 = skShare.GetPublicKey();
+        CBLSPublicKey pk2 = skShares[idx].GetPublicKey();
         return pk1 == pk2;
     }
 
@@ -733,7 +819,7 @@ void CBLSWorker::AsyncVerifyContributionShares(const CBLSId& forId, const std::v
         return;
     }
 
-    auto verifier = new ContributionVerifier(forId, vvecs, skShares, 8, parallel, aggregated, workerPool, std::move(doneCallback));
+    auto verifier = new ContributionVerifier(forId, vvecs, skShares, parallel, aggregated, workerPool, std::move(doneCallback));
     verifier->Start();
 }
 
@@ -109,11 +109,12 @@ public:
     CBLSPublicKey BuildPubKeyShare(const BLSVerificationVectorPtr& vvec, const CBLSId& id);
 
     // The following functions verify multiple verification vectors and contributions for the same id
-    // This is parallelized by performing batched verification. The verification vectors and the contributions of
-    // a batch are aggregated (in parallel, see AsyncBuildQuorumVerificationVector and AsyncBuildSecretKeyShare). The
-    // result per batch is a single aggregated verification vector and a single aggregated contribution, which are then
-    // verified with VerifyContributionShare. If verification of the aggregated inputs is successful, the whole batch
-    // is marked as valid. If the batch verification fails, the individual entries are verified in a non-aggregated manner
+    // All entries are verified in a single randomized batch: every verification vector and every contribution is
+    // multiplied with a random weight and summed up, the sums of all vector entries and of the contributions are
+    // computed in parallel. The public key share recovered from the summed vector must match the public key of the
+    // summed contribution, the weights make sure that invalid contributions can't cancel each other out. If the batch
+    // verification fails, it is split into halves which are verified the same way, down to a few entries which are
+    // verified in a non-aggregated manner. This finds a few bad entries in a large batch with a few batch checks
     void AsyncVerifyContributionShares(const CBLSId& forId, const std::vector<BLSVerificationVectorPtr>& vvecs, const BLSSecretKeyVector& skShares,
                                        bool parallel, bool aggregated, std::function<void(const std::vector<bool>&)> doneCallback);
     std::future<std::vector<bool> > AsyncVerifyContributionShares(const CBLSId& forId, const std::vector<BLSVerificationVectorPtr>& vvecs, const BLSSecretKeyVector& skShares,
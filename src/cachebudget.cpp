@@ -0,0 +1,78 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "cachebudget.h"
+
+#include "txdb.h"
+
+#include <algorithm>
+
+CCacheSizes CalculateCacheSizes(int64_t nTotalCache, bool fTxIndex, bool fBlockFilterIndex)
+{
+    CCacheSizes sizes;
+
+    if (nTotalCache < (1 << 22))
+        nTotalCache = (1 << 22);
+
+    sizes.nBlockTreeDB = nTotalCache / 8;
+    sizes.nBlockTreeDB = std::min(sizes.nBlockTreeDB, (fTxIndex ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
+    nTotalCache -= sizes.nBlockTreeDB;
+
+    sizes.nBlockFilterIndex = fBlockFilterIndex ? std::min(nTotalCache / 8, nMaxBlockFilterIndexCache << 20) : 0;
+    nTotalCache -= sizes.nBlockFilterIndex;
+
+    // use 25%-50% of the remainder for disk cache
+    sizes.nCoinDB = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23));
+    sizes.nCoinDB = std::min(sizes.nCoinDB, nMaxCoinsDBCache << 20);
+    nTotalCache -= sizes.nCoinDB;
+
+    sizes.nEvoDB = std::min(nTotalCache / 8, nMaxEvoDBCache << 20);
+    nTotalCache -= sizes.nEvoDB;
+
+    // the rest goes to in-memory cache
+    sizes.nInMemory = nTotalCache;
+    return sizes;
+}
+
+CCacheBudget::CCacheBudget() :
+    dHitRate(-1.0),
+    nWindowHits(0),
+    nWindowMisses(0)
+{
+}
+
+void CCacheBudget::AddLookups(uint64_t nHits, uint64_t nMisses)
+{
+    nWindowHits += nHits;
+    nWindowMisses += nMisses;
+
+    uint64_t nLookups = nWindowHits + nWindowMisses;
+    if (nLookups < COINS_HIT_RATE_WINDOW)
+        return;
+
+    double dRate = (double)nWindowHits / nLookups;
+    dHitRate = dHitRate < 0 ? dRate : 0.8 * dHitRate + 0.2 * dRate;
+    nWindowHits = nWindowMisses = 0;
+}
+
+double CCacheBudget::GetHitRate() const
+{
+    return std::max(dHitRate, 0.0);
+}
+
+size_t CCacheBudget::GetPrivacyStateCharge(size_t nBudget, size_t nPrivacyUsage)
+{
+    // The Spark/Lelantus state can't be evicted, charging all of it would leave nothing
+    // for the coins cache on nodes with a small -dbcache
+    return std::min(nPrivacyUsage, nBudget / 2);
+}
+
+size_t CCacheBudget::GetTrimTarget(size_t nCoinsLimit) const
+{
+    // Without a sample yet keep the unmodified coins, the cache is still warming up.
+    // A cache that hardly ever hits is emptied down to half of its limit, which
+    // postpones the next full flush the most.
+    double dRate = dHitRate < 0 ? 1.0 : dHitRate;
+    return (size_t)(nCoinsLimit * (0.5 + 0.35 * dRate));
+}
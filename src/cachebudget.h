@@ -0,0 +1,62 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_CACHEBUDGET_H
+#define BZX_CACHEBUDGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//! Max memory allocated to the evodb specific cache (MiB)
+static const int64_t nMaxEvoDBCache = 16;
+//! Max memory allocated to the block filter index specific cache (MiB)
+static const int64_t nMaxBlockFilterIndexCache = 1024;
+//! Lookups the coins cache has to see before its hit rate is sampled
+static const uint64_t COINS_HIT_RATE_WINDOW = 10000;
+
+/** Byte sizes of the caches the -dbcache budget is divided into */
+struct CCacheSizes
+{
+    int64_t nBlockTreeDB;
+    int64_t nBlockFilterIndex;
+    int64_t nCoinDB;
+    int64_t nEvoDB;
+    //! In-memory UTXO cache, shared with uncommitted evodb writes and the Spark/Lelantus state
+    int64_t nInMemory;
+};
+
+/** Divide the -dbcache budget (in bytes) among the databases, the rest goes to the in-memory caches */
+CCacheSizes CalculateCacheSizes(int64_t nTotalCache, bool fTxIndex, bool fBlockFilterIndex);
+
+/**
+ * Keeps track of how the in-memory part of -dbcache is used by the chain
+ * state. The coins cache holds both unmodified coins, which only save
+ * chainstate reads, and modified coins, which can only be released by a
+ * full flush. When the budget runs out the unmodified coins are dropped
+ * first; how many of them are kept depends on the measured hit rate of
+ * the coins cache.
+ */
+class CCacheBudget
+{
+private:
+    //! Smoothed hit rate of the coins cache, negative until the first sample
+    double dHitRate;
+    uint64_t nWindowHits;
+    uint64_t nWindowMisses;
+
+public:
+    CCacheBudget();
+
+    //! Add coins cache lookups, the hit rate is updated once per COINS_HIT_RATE_WINDOW lookups
+    void AddLookups(uint64_t nHits, uint64_t nMisses);
+    double GetHitRate() const;
+
+    //! Part of the Spark/Lelantus state usage charged to the budget, at most half of it
+    static size_t GetPrivacyStateCharge(size_t nBudget, size_t nPrivacyUsage);
+
+    //! Coins cache usage to drop unmodified coins down to when the coins cache may use up to nCoinsLimit
+    size_t GetTrimTarget(size_t nCoinsLimit) const;
+};
+
+#endif // BZX_CACHEBUDGET_H
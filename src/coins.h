@@ -162,6 +162,9 @@ public:
     //! Get a cursor to iterate over the whole state
     virtual CCoinsViewCursor *Cursor() const;
 
+    //! Get a cursor positioned at the first coin whose txid is not below hashFrom
+    virtual CCoinsViewCursor *Cursor(const uint256 &hashFrom) const;
+
     //! As we use CCoinsViews polymorphically, have a virtual destructor
     virtual ~CCoinsView() {}
 
@@ -184,6 +187,7 @@ public:
     void SetBackend(CCoinsView &viewIn);
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
+    CCoinsViewCursor *Cursor(const uint256 &hashFrom) const override;
     size_t EstimateSize() const override;
 };
 
@@ -202,6 +206,10 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    /* Lookups answered from the cache and lookups that went to the backing view. */
+    mutable uint64_t nCacheHits;
+    mutable uint64_t nCacheMisses;
+
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
@@ -252,6 +260,16 @@ public:
      */
     void Uncache(const COutPoint &outpoint);
 
+    /**
+     * Drop unmodified entries until the cache uses at most nTargetUsage bytes.
+     * Modified entries are kept, so this never writes to the backing view.
+     * Returns the number of entries removed.
+     */
+    size_t UncacheUnmodified(size_t nTargetUsage);
+
+    //! Return the lookup counters collected since the last call and reset them
+    void PopHitStats(uint64_t& nHits, uint64_t& nMisses);
+
     //! Calculate the size of the cache (in number of transaction outputs)
     unsigned int GetCacheSize() const;
 
@@ -0,0 +1,217 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "liblelantus/threadpool.h"
+#include "coinstats.h"
+
+#include "chain.h"
+#include "coins.h"
+#include "hash.h"
+#include "init.h"
+#include "serialize.h"
+#include "streams.h"
+#include "sync.h"
+#include "util.h"
+#include "validation.h"
+#include "version.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+
+namespace {
+
+/** Statistics and serialized coins of one txid range of the chainstate */
+struct CCoinsPartitionStats
+{
+    uint64_t nTransactions;
+    uint64_t nTransactionOutputs;
+    CAmount nTotalAmount;
+    std::vector<unsigned char> vSerialized;
+
+    CCoinsPartitionStats() : nTransactions(0), nTransactionOutputs(0), nTotalAmount(0) {}
+};
+
+void ApplyStats(CCoinsPartitionStats &stats, CVectorWriter *ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    assert(!outputs.empty());
+    if (ss)
+        SerializeTxOutputsForHash(*ss, hash, outputs);
+    stats.nTransactions++;
+    for (const auto& output : outputs) {
+        stats.nTransactionOutputs++;
+        stats.nTotalAmount += output.second.out.nValue;
+    }
+}
+
+//! First byte of the txids in partition nPartition
+unsigned int GetPartitionStart(int nPartition)
+{
+    return (unsigned int)nPartition * 256 / COINSTATS_PARTITIONS;
+}
+
+bool ScanPartition(CCoinsViewCursor *pcursor, int nPartition, bool fHash, const std::atomic<bool>& fAbort, CCoinsPartitionStats &stats)
+{
+    const unsigned int nEnd = GetPartitionStart(nPartition + 1);
+    CVectorWriter writer(SER_GETHASH, PROTOCOL_VERSION, stats.vSerialized, 0);
+    CVectorWriter *ss = fHash ? &writer : nullptr;
+
+    uint256 prevkey;
+    std::map<uint32_t, Coin> outputs;
+    while (pcursor->Valid()) {
+        if (fAbort || ShutdownRequested())
+            return false;
+        COutPoint key;
+        Coin coin;
+        if (!pcursor->GetKey(key) || !pcursor->GetValue(coin))
+            return error("%s: unable to read value", __func__);
+        if (*key.hash.begin() >= nEnd)
+            break;
+        if (!outputs.empty() && key.hash != prevkey) {
+            ApplyStats(stats, ss, prevkey, outputs);
+            outputs.clear();
+        }
+        prevkey = key.hash;
+        outputs[key.n] = std::move(coin);
+        pcursor->Next();
+    }
+    if (!outputs.empty()) {
+        ApplyStats(stats, ss, prevkey, outputs);
+    }
+    return true;
+}
+
+//! Private spends don't show up in the UTXO set, their amounts come from the address index
+CAmount GetPrivateSpendAmount()
+{
+    // We need to remove amount of private spends from nTotalAmount;
+    // There are 3 type of private spend transactions
+    std::vector<std::pair<uint160, AddressType> > addresses;
+    addresses.push_back(std::make_pair(uint160(), AddressType::lelantusJSplit));
+    addresses.push_back(std::make_pair(uint160(), AddressType::sparkSpend));
+
+    CAmount nAmount = 0;
+    // Iterate over all types of transactions
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    for (std::vector<std::pair<uint160, AddressType> >::iterator itr = addresses.begin(); itr != addresses.end(); itr++) {
+        // Get address index for each transaction type
+        if (GetAddressIndex((*itr).first, (*itr).second, addressIndex)) {
+            for (std::vector < std::pair < CAddressIndexKey, CAmount > > ::const_iterator it = addressIndex.begin();
+                    it != addressIndex.end(); it++) {
+                nAmount += it->second;
+            }
+        }
+        addressIndex.clear();
+    }
+    return nAmount;
+}
+
+CCriticalSection cs_coinstats;
+//! Result of the last scan, valid for lastStats.hashBlock
+CCoinsStats lastStats;
+bool fLastStatsHashed = false;
+
+} // anon namespace
+
+bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats, bool fHash)
+{
+    // One scan at a time, concurrent callers reuse its result
+    LOCK(cs_coinstats);
+
+    // Every cursor pins the database state at its creation, take them all at once
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors(COINSTATS_PARTITIONS);
+    {
+        LOCK(cs_main);
+        for (int i = 0; i < COINSTATS_PARTITIONS; i++) {
+            uint256 hashFrom;
+            *hashFrom.begin() = (unsigned char)GetPartitionStart(i);
+            cursors[i].reset(view->Cursor(hashFrom));
+            if (!cursors[i])
+                return false;
+        }
+        stats.hashBlock = cursors[0]->GetBestBlock();
+        BlockMap::const_iterator it = mapBlockIndex.find(stats.hashBlock);
+        if (it == mapBlockIndex.end())
+            return error("%s: best block %s of the coins database not found", __func__, stats.hashBlock.ToString());
+        stats.nHeight = it->second->nHeight;
+    }
+
+    if (lastStats.hashBlock == stats.hashBlock && (fLastStatsHashed || !fHash)) {
+        stats = lastStats;
+        if (!fHash)
+            stats.hashSerialized.SetNull();
+        return true;
+    }
+
+    int nThreads = std::max(std::min(GetNumCores(), MAX_COINSTATS_THREADS), 1);
+    int64_t nStart = GetTimeMillis();
+
+    std::vector<CCoinsPartitionStats> partitions(COINSTATS_PARTITIONS);
+    std::atomic<bool> fAbort(false);
+    std::vector<boost::future<bool>> results;
+    results.reserve(COINSTATS_PARTITIONS);
+
+    // Declared last so that its destructor waits for the tasks before the state they use goes away
+    ParallelOpThreadPool<bool> threadPool(nThreads);
+    auto postPartition = [&](int i) {
+        CCoinsViewCursor *pcursor = cursors[i].get();
+        CCoinsPartitionStats *partition = &partitions[i];
+        std::atomic<bool> *pfAbort = &fAbort;
+        results.push_back(threadPool.PostTask([pcursor, i, fHash, pfAbort, partition]() {
+            try {
+                return ScanPartition(pcursor, i, fHash, *pfAbort, *partition);
+            } catch (const std::exception& e) {
+                return error("ScanPartition: %s", e.what());
+            }
+        }));
+    };
+    // Serialized partitions wait in memory until they are hashed in order, only keep a few per thread in
+    // flight instead of the whole serialized UTXO set
+    const int nMaxInFlight = std::min(nThreads * COINSTATS_PARTITIONS_PER_THREAD, COINSTATS_PARTITIONS);
+    for (int i = 0; i < nMaxInFlight; i++)
+        postPartition(i);
+
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << stats.hashBlock;
+    stats.nTransactions = 0;
+    stats.nTransactionOutputs = 0;
+    stats.nTotalAmount = 0;
+    try {
+        // The partitions are ordered by key, hashing them in order gives the hash of a sequential scan
+        for (int i = 0; i < COINSTATS_PARTITIONS; i++) {
+            boost::this_thread::interruption_point();
+            if (!results[i].get()) {
+                fAbort = true;
+                return false;
+            }
+            CCoinsPartitionStats &partition = partitions[i];
+            stats.nTransactions += partition.nTransactions;
+            stats.nTransactionOutputs += partition.nTransactionOutputs;
+            stats.nTotalAmount += partition.nTotalAmount;
+            if (fHash)
+                ss.write((const char*)partition.vSerialized.data(), partition.vSerialized.size());
+            std::vector<unsigned char>().swap(partition.vSerialized);
+            if (i + nMaxInFlight < COINSTATS_PARTITIONS)
+                postPartition(i + nMaxInFlight);
+        }
+    } catch (...) {
+        fAbort = true;
+        throw;
+    }
+
+    stats.nTotalAmount += GetPrivateSpendAmount();
+    if (fHash)
+        stats.hashSerialized = ss.GetHash();
+    else
+        stats.hashSerialized.SetNull();
+    stats.nDiskSize = view->EstimateSize();
+
+    LogPrint("bench", "%s: scanned %u outputs at height %d using %d threads in %dms\n", __func__,
+             stats.nTransactionOutputs, stats.nHeight, nThreads, GetTimeMillis() - nStart);
+
+    lastStats = stats;
+    fLastStatsHashed = fHash;
+    return true;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_COINSTATS_H
+#define BZX_COINSTATS_H
+
+#include "amount.h"
+#include "coins.h"
+#include "serialize.h"
+#include "uint256.h"
+
+#include <map>
+#include <stdint.h>
+
+//! Number of txid ranges the chainstate is split into for the statistics scan
+static const int COINSTATS_PARTITIONS = 256;
+//! Maximum number of threads scanning the chainstate
+static const int MAX_COINSTATS_THREADS = 16;
+//! Number of partitions per thread scanned ahead of the one being hashed
+static const int COINSTATS_PARTITIONS_PER_THREAD = 2;
+
+struct CCoinsStats
+{
+    int nHeight;
+    uint256 hashBlock;
+    uint64_t nTransactions;
+    uint64_t nTransactionOutputs;
+    uint256 hashSerialized;
+    uint64_t nDiskSize;
+    CAmount nTotalAmount;
+
+    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nDiskSize(0), nTotalAmount(0) {}
+};
+
+/** Serialize the unspent outputs of one transaction the way hash_serialized_2 hashes them */
+template <typename Stream>
+void SerializeTxOutputsForHash(Stream& s, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    assert(!outputs.empty());
+    s << hash;
+    s << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
+    for (const auto& output : outputs) {
+        s << VARINT(output.first + 1);
+        s << *(const CScriptBase*)(&output.second.out.scriptPubKey);
+        s << VARINT(output.second.out.nValue);
+    }
+    s << VARINT(0);
+}
+
+/**
+ * Calculate statistics about the unspent transaction output set.
+ *
+ * The chainstate is split into COINSTATS_PARTITIONS txid ranges which are
+ * read and serialized in parallel from one consistent database state. The
+ * serialized ranges are hashed in key order, so hash_serialized_2 is the
+ * same as for a sequential scan; fHash=false skips hashing altogether.
+ * At most COINSTATS_PARTITIONS_PER_THREAD ranges per thread are scanned
+ * ahead of the one being hashed, which bounds the memory held by the
+ * serialized ranges.
+ *
+ * Results are remembered per best block, asking again before the next
+ * block is connected returns immediately.
+ */
+bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats, bool fHash = true);
+
+#endif // BZX_COINSTATS_H
@@ -187,3 +187,21 @@ CSHA256& CSHA256::Reset()
     sha256::Initialize(s);
     return *this;
 }
+
+void SHA256Batch64(unsigned char* output, const unsigned char* input, size_t blocks)
+{
+    // the second block of every hash is the same padding, for a 512 bit message
+    static const unsigned char padding[64] = {0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0};
+    uint32_t s[8];
+    for (size_t i = 0; i < blocks; i++) {
+        sha256::Initialize(s);
+        sha256::Transform(s, input + 64 * i);
+        sha256::Transform(s, padding);
+        for (int j = 0; j < 8; j++) {
+            WriteBE32(output + 32 * i + 4 * j, s[j]);
+        }
+    }
+}
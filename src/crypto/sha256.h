@@ -25,4 +25,11 @@ public:
     CSHA256& Reset();
 };
 
+/** Compute the single SHA-256 of multiple 64-byte blobs.
+ *  output: pointer to a blocks*32 byte output buffer
+ *  input: pointer to a blocks*64 byte input buffer
+ *  blocks: the number of hashes to compute
+ */
+void SHA256Batch64(unsigned char* output, const unsigned char* input, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
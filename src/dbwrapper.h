@@ -53,11 +53,28 @@ private:
     const CDBWrapper &parent;
     leveldb::WriteBatch batch;
 
-    CDataStream ssKey;
-    CDataStream ssValue;
+    CPublicDataStream ssKey;
+    CPublicDataStream ssValue;
 
     size_t size_estimate;
 
+    template <typename Stream, typename K, typename V>
+    void WriteWithStream(const K& key, const V& value, Stream& ssValueIn)
+    {
+        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+        ssKey << key;
+        leveldb::Slice slKey(ssKey.data(), ssKey.size());
+
+        ssValueIn.reserve(DBWRAPPER_PREALLOC_VALUE_SIZE);
+        ssValueIn << value;
+        ssValueIn.Xor(dbwrapper_private::GetObfuscateKey(parent));
+        leveldb::Slice slValue(ssValueIn.data(), ssValueIn.size());
+
+        batch.Put(slKey, slValue);
+        ssKey.clear();
+        ssValueIn.clear();
+    }
+
 public:
     /**
      * @param[in] _parent   CDBWrapper that this batch is to be submitted to
@@ -73,22 +90,19 @@ public:
     template <typename K, typename V>
     void Write(const K& key, const V& value)
     {
-        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
-        ssKey << key;
-        leveldb::Slice slKey(ssKey.data(), ssKey.size());
-
-        ssValue.reserve(DBWRAPPER_PREALLOC_VALUE_SIZE);
-        ssValue << value;
-        ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
-        leveldb::Slice slValue(ssValue.data(), ssValue.size());
+        WriteWithStream(key, value, ssValue);
+    }
 
-        batch.Put(slKey, slValue);
-        ssKey.clear();
-        ssValue.clear();
+    /** Write a value holding secret material, it doesn't go through the pooled buffers that aren't cleared */
+    template <typename K, typename V>
+    void WriteSecret(const K& key, const V& value)
+    {
+        CDataStream ssSecret(SER_DISK, CLIENT_VERSION);
+        WriteWithStream(key, value, ssSecret);
     }
 
     template <typename V>
-    void Write(const CDataStream& _ssKey, const V& value)
+    void Write(const CPublicDataStream& _ssKey, const V& value)
     {
         leveldb::Slice slKey(_ssKey.data(), _ssKey.size());
 
@@ -118,7 +132,7 @@ public:
         ssKey.clear();
     }
 
-    void Erase(const CDataStream& _ssKey) {
+    void Erase(const CPublicDataStream& _ssKey) {
         leveldb::Slice slKey(_ssKey.data(), _ssKey.size());
 
         batch.Delete(slKey);
@@ -153,7 +167,7 @@ public:
     void SeekToFirst();
 
     template<typename K> void Seek(const K& key) {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPublicDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
@@ -165,7 +179,7 @@ public:
     template<typename K> bool GetKey(K& key) {
         leveldb::Slice slKey = piter->key();
         try {
-            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            CPublicDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
             ssKey >> key;
         } catch (const std::exception&) {
             return false;
@@ -173,9 +187,9 @@ public:
         return true;
     }
 
-    CDataStream GetKey() {
+    CPublicDataStream GetKey() {
         leveldb::Slice slKey = piter->key();
-        return CDataStream(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        return CPublicDataStream(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
     }
 
     unsigned int GetKeySize() {
@@ -185,7 +199,7 @@ public:
     template<typename V> bool GetValue(V& value) {
         leveldb::Slice slValue = piter->value();
         try {
-            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CPublicDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
             ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
             ssValue >> value;
         } catch (const std::exception&) {
@@ -236,6 +250,32 @@ private:
 
     std::vector<unsigned char> CreateObfuscateKey() const;
 
+    template <typename Stream, typename K, typename V>
+    bool ReadWithStream(const K& key, V& value) const
+    {
+        CPublicDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+        ssKey << key;
+        leveldb::Slice slKey(ssKey.data(), ssKey.size());
+
+        std::string strValue;
+        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        if (!status.ok()) {
+            if (status.IsNotFound())
+                return false;
+            LogPrintf("LevelDB read failure: %s\n", status.ToString());
+            dbwrapper_private::HandleError(status);
+        }
+        try {
+            Stream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
+            ssValue.Xor(obfuscate_key);
+            ssValue >> value;
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
 public:
     /**
      * @param[in] path        Location in the filesystem where leveldb data will be stored.
@@ -249,15 +289,15 @@ public:
     ~CDBWrapper();
 
     template <typename K>
-    bool ReadDataStream(const K& key, CDataStream& ssValue) const
+    bool ReadDataStream(const K& key, CPublicDataStream& ssValue) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPublicDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         return ReadDataStream(ssKey, ssValue);
     }
 
-    bool ReadDataStream(const CDataStream& ssKey, CDataStream& ssValue) const
+    bool ReadDataStream(const CPublicDataStream& ssKey, CPublicDataStream& ssValue) const
     {
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 
@@ -269,7 +309,7 @@ public:
             LogPrintf("LevelDB read failure: %s\n", status.ToString());
             dbwrapper_private::HandleError(status);
         }
-        CDataStream ssValueTmp(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
+        CPublicDataStream ssValueTmp(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
         ssValueTmp.Xor(obfuscate_key);
         ssValue = std::move(ssValueTmp);
         return true;
@@ -278,27 +318,14 @@ public:
     template <typename K, typename V>
     bool Read(const K& key, V& value) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
-        ssKey << key;
-        leveldb::Slice slKey(ssKey.data(), ssKey.size());
+        return ReadWithStream<CPublicDataStream>(key, value);
+    }
 
-        std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
-        if (!status.ok()) {
-            if (status.IsNotFound())
-                return false;
-            LogPrintf("LevelDB read failure: %s\n", status.ToString());
-            dbwrapper_private::HandleError(status);
-        }
-        try {
-            CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
-            ssValue.Xor(obfuscate_key);
-            ssValue >> value;
-        } catch (const std::exception&) {
-            return false;
-        }
-        return true;
+    /** Read a value holding secret material, it doesn't go through the pooled buffers that aren't cleared */
+    template <typename K, typename V>
+    bool ReadSecret(const K& key, V& value) const
+    {
+        return ReadWithStream<CDataStream>(key, value);
     }
 
     template <typename K, typename V>
@@ -309,10 +336,19 @@ public:
         return WriteBatch(batch, fSync);
     }
 
+    /** Write a value holding secret material, see CDBBatch::WriteSecret */
+    template <typename K, typename V>
+    bool WriteSecret(const K& key, const V& value, bool fSync = false)
+    {
+        CDBBatch batch(*this);
+        batch.WriteSecret(key, value);
+        return WriteBatch(batch, fSync);
+    }
+
     template <typename K>
     bool Exists(const K& key) const
     {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CPublicDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
@@ -363,7 +399,7 @@ public:
     template<typename K>
     size_t EstimateSize(const K& key_begin, const K& key_end) const
     {
-        CDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
+        CPublicDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
         ssKey1.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey2.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey1 << key_begin;
@@ -382,7 +418,7 @@ public:
     template<typename K>
     void CompactRange(const K& key_begin, const K& key_end) const
     {
-        CDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
+        CPublicDataStream ssKey1(SER_DISK, CLIENT_VERSION), ssKey2(SER_DISK, CLIENT_VERSION);
         ssKey1.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey2.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey1 << key_begin;
@@ -413,7 +449,7 @@ private:
     // is advanced.
     typename CDBTransaction::WritesMap::iterator transactionIt;
     std::unique_ptr<ParentIterator> parentIt;
-    CDataStream parentKey;
+    CPublicDataStream parentKey;
     bool curIsParent{false};
 
 public:
@@ -437,7 +473,7 @@ public:
         Seek(CDBTransaction::KeyToDataStream(key));
     }
 
-    void Seek(const CDataStream& ssKey) {
+    void Seek(const CPublicDataStream& ssKey) {
         transactionIt = transaction.writes.lower_bound(ssKey);
         parentIt->Seek(ssKey);
         SkipDeletedAndOverwritten();
@@ -472,7 +508,7 @@ public:
         if (curIsParent) {
             try {
                 // TODO try to avoid this copy (we need a stream that allows reading from external buffers)
-                CDataStream ssKey = parentKey;
+                CPublicDataStream ssKey = parentKey;
                 ssKey >> key;
             } catch (const std::exception&) {
                 return false;
@@ -481,7 +517,7 @@ public:
         } else {
             try {
                 // TODO try to avoid this copy (we need a stream that allows reading from external buffers)
-                CDataStream ssKey = transactionIt->first;
+                CPublicDataStream ssKey = transactionIt->first;
                 ssKey >> key;
             } catch (const std::exception&) {
                 return false;
@@ -490,9 +526,9 @@ public:
         }
     }
 
-    CDataStream GetKey() {
+    CPublicDataStream GetKey() {
         if (!Valid()) {
-            return CDataStream(SER_DISK, CLIENT_VERSION);
+            return CPublicDataStream(SER_DISK, CLIENT_VERSION);
         }
         if (curIsParent) {
             return parentKey;
@@ -560,12 +596,12 @@ protected:
     ssize_t memoryUsage{0}; // signed, just in case we made an error in the calculations so that we don't get an overflow
 
     struct DataStreamCmp {
-        static bool less(const CDataStream& a, const CDataStream& b) {
+        static bool less(const CPublicDataStream& a, const CPublicDataStream& b) {
             return std::lexicographical_compare(
                     (const uint8_t*)a.data(), (const uint8_t*)a.data() + a.size(),
                     (const uint8_t*)b.data(), (const uint8_t*)b.data() + b.size());
         }
-        bool operator()(const CDataStream& a, const CDataStream& b) const {
+        bool operator()(const CPublicDataStream& a, const CPublicDataStream& b) const {
             return less(a, b);
         }
     };
@@ -574,7 +610,7 @@ protected:
         size_t memoryUsage;
         ValueHolder(size_t _memoryUsage) : memoryUsage(_memoryUsage) {}
         virtual ~ValueHolder() = default;
-        virtual void Write(const CDataStream& ssKey, CommitTarget &parent) = 0;
+        virtual void Write(const CPublicDataStream& ssKey, CommitTarget &parent) = 0;
     };
     typedef std::unique_ptr<ValueHolder> ValueHolderPtr;
 
@@ -582,7 +618,7 @@ protected:
     struct ValueHolderImpl : ValueHolder {
         ValueHolderImpl(const V &_value, size_t _memoryUsage) : ValueHolder(_memoryUsage), value(_value) {}
 
-        virtual void Write(const CDataStream& ssKey, CommitTarget &commitTarget) override {
+        virtual void Write(const CPublicDataStream& ssKey, CommitTarget &commitTarget) override {
             // we're moving the value instead of copying it. This means that Write() can only be called once per
             // ValueHolderImpl instance. Commit() clears the write maps, so this ok.
             commitTarget.Write(ssKey, std::move(value));
@@ -591,15 +627,15 @@ protected:
     };
 
     template<typename K>
-    static CDataStream KeyToDataStream(const K& key) {
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    static CPublicDataStream KeyToDataStream(const K& key) {
+        CPublicDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         return ssKey;
     }
 
-    typedef std::map<CDataStream, ValueHolderPtr, DataStreamCmp> WritesMap;
-    typedef std::set<CDataStream, DataStreamCmp> DeletesSet;
+    typedef std::map<CPublicDataStream, ValueHolderPtr, DataStreamCmp> WritesMap;
+    typedef std::set<CPublicDataStream, DataStreamCmp> DeletesSet;
 
     WritesMap writes;
     DeletesSet deletes;
@@ -613,7 +649,7 @@ public:
     }
 
     template <typename V>
-    void Write(const CDataStream& ssKey, const V& v) {
+    void Write(const CPublicDataStream& ssKey, const V& v) {
         auto valueMemoryUsage = ::GetSerializeSize(v, SER_DISK, CLIENT_VERSION);
 
         if (deletes.erase(ssKey)) {
@@ -634,7 +670,7 @@ public:
     }
 
     template <typename V>
-    bool Read(const CDataStream& ssKey, V& value) {
+    bool Read(const CPublicDataStream& ssKey, V& value) {
         if (deletes.count(ssKey)) {
             return false;
         }
@@ -657,7 +693,7 @@ public:
         return Exists(KeyToDataStream(key));
     }
 
-    bool Exists(const CDataStream& ssKey) {
+    bool Exists(const CPublicDataStream& ssKey) {
         if (deletes.count(ssKey)) {
             return false;
         }
@@ -674,7 +710,7 @@ public:
         return Erase(KeyToDataStream(key));
     }
 
-    void Erase(const CDataStream& ssKey) {
+    void Erase(const CPublicDataStream& ssKey) {
         auto it = writes.find(ssKey);
         if (it != writes.end()) {
             memoryUsage -= ssKey.size() + it->second->memoryUsage;
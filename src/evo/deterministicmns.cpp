@@ -8,8 +8,10 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "core_io.h"
+#include "crypto/sha256.h"
 #include "script/standard.h"
 #include "ui_interface.h"
+#include "unordered_lru_cache.h"
 #include "validation.h"
 #include "validationinterface.h"
 
@@ -235,17 +237,21 @@ CDeterministicMNCPtr CDeterministicMNList::GetMNPayee() const
 
 std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int nCount) const
 {
+    if (nCount <= 0) {
+        return {};
+    }
     if (cmp::greater(nCount, GetValidMNsCount())) {
         nCount = GetValidMNsCount();
     }
 
     std::vector<CDeterministicMNCPtr> result;
-    result.reserve(nCount);
+    result.reserve(GetValidMNsCount());
 
     ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
         result.emplace_back(dmn);
     });
-    std::sort(result.begin(), result.end(), [&](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+    // only the first nCount payees are needed in order
+    std::partial_sort(result.begin(), result.begin() + nCount, result.end(), [&](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
         return CompareByLastPaid(a, b);
     });
 
@@ -254,51 +260,82 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int
     return result;
 }
 
+// Quorums of lists that belong to a block never change, they are kept by hash of (block hash, modifier, size)
+static CCriticalSection cs_quorumsCache;
+static unordered_lru_cache<uint256, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher, 256> quorumsCache;
+
 std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t maxSize, const uint256& modifier) const
 {
+    // lists that are still being built have a null block hash
+    uint256 cacheKey;
+    if (!blockHash.IsNull()) {
+        cacheKey = ::SerializeHash(std::make_tuple(blockHash, modifier, (uint64_t)maxSize));
+        LOCK(cs_quorumsCache);
+        std::vector<CDeterministicMNCPtr> result;
+        if (quorumsCache.get(cacheKey, result)) {
+            return result;
+        }
+    }
+
     auto scores = CalculateScores(modifier);
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+    // only the top maxSize entries are needed, in descending order
+    size_t count = std::min(maxSize, scores.size());
+    std::partial_sort(scores.begin(), scores.begin() + count, scores.end(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
         if (a.first == b.first) {
             // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+            return b.second->collateralOutpoint < a.second->collateralOutpoint;
         }
-        return a.first < b.first;
+        return b.first < a.first;
     });
 
     // take top maxSize entries and return it
     std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
+    result.resize(count);
     for (size_t i = 0; i < result.size(); i++) {
         result[i] = std::move(scores[i].second);
     }
+
+    if (!cacheKey.IsNull()) {
+        LOCK(cs_quorumsCache);
+        quorumsCache.insert(cacheKey, result);
+    }
     return result;
 }
 
 std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> CDeterministicMNList::CalculateScores(const uint256& modifier) const
 {
-    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
-    scores.reserve(GetAllMNsCount());
+    std::vector<CDeterministicMNCPtr> mns;
+    mns.reserve(GetAllMNsCount());
     ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
         if (dmn->pdmnState->confirmedHash.IsNull()) {
             // we only take confirmed MNs into account to avoid hash grinding on the ProRegTxHash to sneak MNs into a
             // future quorums
             return;
         }
-        // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
-        // Please note that this is not a double-sha256 but a single-sha256
-        // The first part is already precalculated (confirmedHashWithProRegTxHash)
-        // TODO When https://github.com/bitcoin/bitcoin/pull/13191 gets backported, implement something that is similar but for single-sha256
-        uint256 h;
-        CSHA256 sha256;
-        sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), dmn->pdmnState->confirmedHashWithProRegTxHash.size());
-        sha256.Write(modifier.begin(), modifier.size());
-        sha256.Finalize(h.begin());
-
-        scores.emplace_back(UintToArith256(h), dmn);
+        mns.emplace_back(dmn);
     });
 
+    // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
+    // Please note that this is not a double-sha256 but a single-sha256
+    // The first part is already precalculated (confirmedHashWithProRegTxHash), all MNs are hashed in one batch
+    std::vector<unsigned char> input(mns.size() * 64);
+    std::vector<unsigned char> output(mns.size() * 32);
+    for (size_t i = 0; i < mns.size(); i++) {
+        const uint256& confirmedHashWithProRegTxHash = mns[i]->pdmnState->confirmedHashWithProRegTxHash;
+        memcpy(&input[i * 64], confirmedHashWithProRegTxHash.begin(), 32);
+        memcpy(&input[i * 64 + 32], modifier.begin(), 32);
+    }
+    SHA256Batch64(output.data(), input.data(), mns.size());
+
+    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
+    scores.reserve(mns.size());
+    for (size_t i = 0; i < mns.size(); i++) {
+        uint256 h;
+        memcpy(h.begin(), &output[i * 32], 32);
+        scores.emplace_back(UintToArith256(h), std::move(mns[i]));
+    }
+
     return scores;
 }
 
@@ -991,7 +1028,7 @@ void CDeterministicMNManager::CleanupCache(int nHeight)
 
 bool CDeterministicMNManager::UpgradeDiff(CDBBatch& batch, const CBlockIndex* pindexNext, const CDeterministicMNList& curMNList, CDeterministicMNList& newMNList)
 {
-    CDataStream oldDiffData(SER_DISK, CLIENT_VERSION);
+    CPublicDataStream oldDiffData(SER_DISK, CLIENT_VERSION);
     if (!evoDb.GetRawDB().ReadDataStream(std::make_pair(DB_LIST_DIFF, pindexNext->GetBlockHash()), oldDiffData)) {
         LogPrintf("CDeterministicMNManager::%s -- no diff found for %s\n", __func__, pindexNext->GetBlockHash().ToString());
         newMNList = curMNList;
@@ -44,7 +44,7 @@ void CMNAuth::PushMNAUTH(CNode* pnode, CConnman& connman)
     connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::MNAUTH, mnauth));
 }
 
-void CMNAuth::ProcessMessage(CNode* pnode, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+void CMNAuth::ProcessMessage(CNode* pnode, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman)
 {
     if (strCommand != NetMsgType::MNAUTH)
         return;
@@ -11,6 +11,10 @@
 
 #include "addrman.h"
 #include "amount.h"
+#include "blockfilemapper.h"
+#include "blockfilterindex.h"
+#include "blocktemplatemanager.h"
+#include "cachebudget.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
@@ -24,7 +28,9 @@
 #include "netbase.h"
 #include "net.h"
 #include "net_processing.h"
+#include "perfstats.h"
 #include "policy/policy.h"
+#include "reindex.h"
 #include "rpc/server.h"
 #include "rpc/register.h"
 #include "script/standard.h"
@@ -224,6 +230,10 @@ void Interrupt(boost::thread_group& threadGroup)
     InterruptREST();
     InterruptTorControl();
     llmq::InterruptLLMQSystem();
+    if (pblockfilterindex)
+        pblockfilterindex->Interrupt();
+    if (pblocktemplatemanager)
+        pblocktemplatemanager->Interrupt();
     if (g_connman)
         g_connman->Interrupt();
     threadGroup.interrupt_all();
@@ -320,6 +330,16 @@ void Shutdown()
     StopRPC();
     StopHTTPServer();
     llmq::StopLLMQSystem();
+    if (pblocktemplatemanager) {
+        pblocktemplatemanager->Stop();
+        delete pblocktemplatemanager;
+        pblocktemplatemanager = NULL;
+    }
+    if (pblockfilterindex) {
+        pblockfilterindex->Stop();
+        delete pblockfilterindex;
+        pblockfilterindex = NULL;
+    }
 
     BatchProofContainer::get_instance()->finalize();
     BatchProofContainer::get_instance()->verify();
@@ -362,6 +382,8 @@ void Shutdown()
         pcoinsdbview = NULL;
         delete pblocktree;
         pblocktree = NULL;
+        delete pblockfilemapper;
+        pblockfilemapper = NULL;
         llmq::DestroyLLMQSystem();
         delete deterministicMNManager;
         deterministicMNManager = NULL;
@@ -410,6 +432,7 @@ void Shutdown()
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    StopDebugLogWriter();
 }
 
 /**
@@ -489,12 +512,16 @@ std::string HelpMessage(HelpMessageMode mode)
 #endif
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
+    strUsage += HelpMessageOpt("-blockmmap", strprintf(_("Read blocks and undo data through memory mapped block files, needs a 64 bit system (default: %u)"), DEFAULT_BLOCKMMAP));
+    if (showDebug)
+        strUsage += HelpMessageOpt("-blockmmapfiles=<n>", strprintf("Maximum number of block files mapped at a time with -blockmmap (default: %u)", DEFAULT_BLOCKMMAP_FILES));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
     if (showDebug)
         strUsage += HelpMessageOpt("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file on startup"));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
+    strUsage += HelpMessageOpt("-maxstempool=<n>", _("Keep the Dandelion stem transaction pool below <n> megabytes, at least -maxmempool (default: -maxmempool)"));
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
@@ -507,12 +534,14 @@ std::string HelpMessage(HelpMessageMode mode)
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >%u = automatically prune block files to stay under the specified target size in MiB)"), MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024));
     strUsage += HelpMessageOpt("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks");
     strUsage += HelpMessageOpt("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk");
+    strUsage += HelpMessageOpt("-reindexthreads=<n>", strprintf(_("Number of threads parsing block files ahead of -reindex (1 to %d, 0 = one per core, default: %d)"), MAX_REINDEX_THREADS, DEFAULT_REINDEX_THREADS));
     strUsage += HelpMessageOpt("-resync", "Delete blockchain folders and resync from scratch on startup");
     strUsage += HelpMessageOpt("-reset", "Deletes invalidated flags on startup");
 #ifndef WIN32
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
+    strUsage += HelpMessageOpt("-blockfilterindex", strprintf(_("Maintain an index of compact block filters (BIP 157/158) covering scripts and Spark/Lelantus spend and mint data, used by the getblockfilter rpc call and the REST interface (default: %u)"), DEFAULT_BLOCKFILTERINDEX));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
     strUsage += HelpMessageOpt("-addnode=<ip>", _("Add a node to connect to and attempt to keep the connection open"));
@@ -533,6 +562,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-maxtimeadjustment", strprintf(_("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)"), DEFAULT_MAX_TIME_ADJUSTMENT));
     strUsage += HelpMessageOpt("-onion=<ip:port>", strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy"));
     strUsage += HelpMessageOpt("-onlynet=<net>", _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)"));
+    strUsage += HelpMessageOpt("-peerblockfilters", strprintf(_("Serve compact block filters to peers per BIP 157, requires -blockfilterindex (default: %u)"), DEFAULT_PEERBLOCKFILTERS));
     strUsage += HelpMessageOpt("-permitbaremultisig", strprintf(_("Relay non-P2SH multisig (default: %u)"), DEFAULT_PERMIT_BAREMULTISIG));
     strUsage += HelpMessageOpt("-port=<port>", strprintf(_("Listen for connections on <port> (default: %u or testnet: %u)"), Params(CBaseChainParams::MAIN).GetDefaultPort(), Params(CBaseChainParams::TESTNET).GetDefaultPort()));
     strUsage += HelpMessageOpt("-proxy=<ip:port>", _("Connect through SOCKS5 proxy"));
@@ -594,8 +624,11 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-help-debug", _("Show all debugging options (usage: --help -help-debug)"));
     strUsage += HelpMessageOpt("-logips", strprintf(_("Include IP addresses in debug output (default: %u)"), DEFAULT_LOGIPS));
     strUsage += HelpMessageOpt("-logtimestamps", strprintf(_("Prepend debug output with timestamp (default: %u)"), DEFAULT_LOGTIMESTAMPS));
+    strUsage += HelpMessageOpt("-perfstats", strprintf(_("Record latency histograms and counters of hot code paths, see getperfstats (default: %u)"), DEFAULT_PERFSTATS));
+    strUsage += HelpMessageOpt("-logasync", strprintf(_("Write debug.log from a background thread (default: %u)"), DEFAULT_LOGASYNC));
     if (showDebug)
     {
+        strUsage += HelpMessageOpt("-logqueuesize=<n>", strprintf("Number of debug.log messages waiting for the background writer before further ones are dropped (default: %u)", DEFAULT_LOGQUEUESIZE));
         strUsage += HelpMessageOpt("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS));
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default: %u)", DEFAULT_LIMITFREERELAY));
         strUsage += HelpMessageOpt("-relaypriority", strprintf("Require high priority for relaying free or low-fee transactions (default: %u)", DEFAULT_RELAYPRIORITY));
@@ -634,6 +667,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-blockmaxsize=<n>", strprintf(_("Set maximum block size in bytes (default: %d)"), DEFAULT_BLOCK_MAX_SIZE));
     strUsage += HelpMessageOpt("-blockprioritysize=<n>", strprintf(_("Set maximum size of high-priority/low-fee transactions in bytes (default: %d)"), DEFAULT_BLOCK_PRIORITY_SIZE));
     strUsage += HelpMessageOpt("-blockmintxfee=<amt>", strprintf(_("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)"), CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)));
+    strUsage += HelpMessageOpt("-blocktemplatefeedelta=<n>", strprintf(_("Notify longpolling getblocktemplate clients once the template fees grew by this many percent (default: %u)"), DEFAULT_BLOCKTEMPLATE_FEE_DELTA));
+    strUsage += HelpMessageOpt("-blocktemplateinterval=<n>", strprintf(_("Minimum time in milliseconds between full block template rebuilds for mempool changes that cannot be applied to the template incrementally (default: %d)"), DEFAULT_BLOCKTEMPLATE_INTERVAL));
     if (showDebug)
         strUsage += HelpMessageOpt("-blockversion=<n>", "Override block version to test forking scenarios");
 
@@ -788,23 +823,17 @@ void ThreadImport(std::vector <boost::filesystem::path> vImportFiles) {
 
     // -reindex
     if (fReindex) {
-        int nFile = 0;
-        while (true) {
-            CDiskBlockPos pos(nFile, 0);
-            if (!boost::filesystem::exists(GetBlockPosFilename(pos, "blk")))
-                break; // No block files left to reindex
-            FILE *file = OpenBlockFile(pos, true);
-            if (!file)
-                break; // This error is logged in OpenBlockFile
-            LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            LoadExternalBlockFile(chainparams, file, &pos);
-            nFile++;
+        int nThreads = GetArg("-reindexthreads", DEFAULT_REINDEX_THREADS);
+        if (nThreads <= 0)
+            nThreads = GetNumCores();
+        nThreads = std::max(1, std::min(nThreads, MAX_REINDEX_THREADS));
+        if (ReindexBlockFiles(chainparams, nThreads)) {
+            pblocktree->WriteReindexing(false);
+            fReindex = false;
+            LogPrintf("Reindexing finished\n");
+            // To avoid ending up in a situation without genesis block, re-try initializing (no-op if reindexing worked):
+            InitBlockIndex(chainparams);
         }
-        pblocktree->WriteReindexing(false);
-        fReindex = false;
-        LogPrintf("Reindexing finished\n");
-        // To avoid ending up in a situation without genesis block, re-try initializing (no-op if reindexing worked):
-        InitBlockIndex(chainparams);
     }
 
     // hardcoded $DATADIR/bootstrap.dat
@@ -923,6 +952,7 @@ void InitParameterInteraction()
         fs::path databaseDir = GetDataDir() / "database";
         fs::path evodbDir = GetDataDir() / "evodb";
         fs::path llmqDir = GetDataDir() / "llmq";
+        fs::path indexesDir = GetDataDir() / "indexes";
         fs::path torDir = GetDataDir() / "tor";
 
         LogPrintf("Deleting blockchain folders blocks, chainstate, sporks\n");
@@ -953,6 +983,11 @@ void InitParameterInteraction()
                 LogPrintf("-resync: folder deleted: %s\n", llmqDir.string().c_str());
             }
 
+            if (fs::exists(indexesDir)){
+                fs::remove_all(indexesDir);
+                LogPrintf("-resync: folder deleted: %s\n", indexesDir.string().c_str());
+            }
+
             if (fs::exists(torDir)){
                 fs::remove_all(torDir);
                 LogPrintf("-resync: folder deleted: %s\n", torDir.string().c_str());
@@ -1057,6 +1092,12 @@ void InitParameterInteraction()
             LogPrintf("%s: parameter interaction: -whitelistforcerelay=1 -> setting -whitelistrelay=1\n", __func__);
     }
 
+    // The stem pool holds a copy of every mempool transaction, it gets at least as much memory
+    if (IsArgSet("-maxmempool")) {
+        if (SoftSetArg("-maxstempool", GetArg("-maxmempool", "")))
+            LogPrintf("%s: parameter interaction: -maxmempool=%s -> setting -maxstempool=%s\n", __func__, GetArg("-maxmempool", ""), GetArg("-maxmempool", ""));
+    }
+
 #ifdef ENABLE_WALLET
     // Set arg "-newwallet" false by default for wallet scaning.
     SoftSetBoolArg("-newwallet", false);
@@ -1173,6 +1214,7 @@ void StopTorEnabled()
 void InitLogging() {
     fPrintToConsole = GetBoolArg("-printtoconsole", false);
     fLogTimestamps = GetBoolArg("-logtimestamps", DEFAULT_LOGTIMESTAMPS);
+    fPerfStats = GetBoolArg("-perfstats", DEFAULT_PERFSTATS);
     fLogTimeMicros = GetBoolArg("-logtimemicros", DEFAULT_LOGTIMEMICROS);
     fLogIPs = GetBoolArg("-logips", DEFAULT_LOGIPS);
 
@@ -1275,6 +1317,15 @@ bool AppInitParameterInteraction()
     if (GetArg("-prune", 0)) {
         if (GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+            return InitError(_("Prune mode is incompatible with -blockfilterindex."));
+    }
+
+    // Serving filters to peers needs the filter index
+    if (GetBoolArg("-peerblockfilters", DEFAULT_PEERBLOCKFILTERS)) {
+        if (!GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+            return InitError(_("Cannot set -peerblockfilters without -blockfilterindex."));
+        nLocalServices = ServiceFlags(nLocalServices | NODE_COMPACT_FILTERS);
     }
 
     // Make sure enough file descriptors are available
@@ -1343,6 +1394,10 @@ bool AppInitParameterInteraction()
     int64_t nMempoolSizeMin = GetArg("-limitdescendantsize", DEFAULT_DESCENDANT_SIZE_LIMIT) * 1000 * 40;
     if (nMempoolSizeMax < 0 || nMempoolSizeMax < nMempoolSizeMin)
         return InitError(strprintf(_("-maxmempool must be at least %d MB"), std::ceil(nMempoolSizeMin / 1000000.0)));
+    // a smaller stem pool would evict the mempool parents of stem transactions and raise its minimum fee above the mempool's
+    int64_t nStempoolSizeMax = GetArg("-maxstempool", DEFAULT_MAX_STEMPOOL_SIZE) * 1000000;
+    if (nStempoolSizeMax < nMempoolSizeMax)
+        return InitError(strprintf(_("-maxstempool must be at least -maxmempool (%d MB)"), nMempoolSizeMax / 1000000));
     // incremental relay fee sets the minimimum feerate increase necessary for BIP 125 replacement in the mempool
     // and the amount the mempool min fee increases above the feerate of txs evicted due to mempool limiting.
     if (IsArgSet("-incrementalrelayfee"))
@@ -1515,8 +1570,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         ShrinkDebugFile();
     }
 
-    if (fPrintToDebugLog)
+    if (fPrintToDebugLog) {
         OpenDebugLog();
+        if (GetBoolArg("-logasync", DEFAULT_LOGASYNC))
+            StartDebugLogWriter(GetArg("-logqueuesize", DEFAULT_LOGQUEUESIZE));
+    }
 
     if (!fLogTimestamps)
         LogPrintf("Startup time: %s\n", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime()));
@@ -1749,29 +1807,31 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     boost::filesystem::create_directories(GetDataDir() / "blocks");
 
+    if (GetBoolArg("-blockmmap", DEFAULT_BLOCKMMAP) && sizeof(void*) < 8) {
+        InitWarning(_("-blockmmap needs a 64 bit system, reading block files through stdio."));
+    } else if (GetBoolArg("-blockmmap", DEFAULT_BLOCKMMAP)) {
+        int nMapFiles = std::max(1, (int)GetArg("-blockmmapfiles", DEFAULT_BLOCKMMAP_FILES));
+        pblockfilemapper = new CBlockFileMapper(nMapFiles);
+        LogPrintf("Reading block files through memory mappings, up to %d files mapped\n", nMapFiles);
+    }
+
     // cache size calculations
-    int64_t nTotalCache = (GetArg("-dbcache", nDefaultDbCache) << 20);
-//    nTotalCache = std::max(nTotalCache, nMinDbCache << 20); // total cache cannot be less than nMinDbCache
-//    nTotalCache = std::min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbcache
-    if (nTotalCache < (1 << 22))
-        nTotalCache = (1 << 22);
-    int64_t nBlockTreeDBCache = nTotalCache / 8;
-//    nBlockTreeDBCache = std::min(nBlockTreeDBCache, (GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
-    if (nBlockTreeDBCache > (1 << 21) && !GetBoolArg("-txindex", false))
-        nBlockTreeDBCache = (1 << 21); // block tree db cache shouldn't be larger than 2 MiB
-    nTotalCache -= nBlockTreeDBCache;
-    int64_t nCoinDBCache = std::min(nTotalCache / 2,
-                                    (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
-    nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
-    nTotalCache -= nCoinDBCache;
-//    nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
-    nCoinCacheUsage = nTotalCache / 300;
+    CCacheSizes cacheSizes = CalculateCacheSizes(GetArg("-dbcache", nDefaultDbCache) << 20,
+                                                 GetBoolArg("-txindex", DEFAULT_TXINDEX),
+                                                 GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX));
+    int64_t nBlockTreeDBCache = cacheSizes.nBlockTreeDB;
+    int64_t nBlockFilterIndexCache = cacheSizes.nBlockFilterIndex;
+    int64_t nCoinDBCache = cacheSizes.nCoinDB;
+    int64_t nEvoDbCache = cacheSizes.nEvoDB;
+    nCoinCacheUsage = cacheSizes.nInMemory; // shared by the UTXO cache, pending evodb writes and the Spark/Lelantus state
     int64_t nMempoolSizeMax = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-    int64_t nEvoDbCache = 1024 * 1024 * 16; // TODO
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
+    if (nBlockFilterIndexCache > 0)
+        LogPrintf("* Using %.1fMiB for block filter index database\n", nBlockFilterIndexCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
-    LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for evo database\n", nEvoDbCache * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for in-memory UTXO set and privacy state (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
     while (!fLoaded) {
@@ -1920,6 +1980,15 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         mempool.ReadFeeEstimates(est_filein);
     fFeeEstimatesInitialized = true;
 
+    if (GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX)) {
+        pblockfilterindex = new CBlockFilterIndex(BlockFilterType::BASIC, nBlockFilterIndexCache, false, fReindex);
+        if (!pblockfilterindex->Init())
+            return InitError(_("Error opening block filter index database"));
+        pblockfilterindex->Start();
+    }
+
+    pblocktemplatemanager = new CBlockTemplateManager(chainparams);
+    pblocktemplatemanager->Start();
 
     // ********************************************************* Step 8: load wallet
 
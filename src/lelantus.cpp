@@ -19,6 +19,9 @@
 #include "policy/policy.h"
 #include "coins.h"
 #include "batchproof_container.h"
+#include "memusage.h"
+#include "hash.h"
+#include "perfstats.h"
 
 #include <atomic>
 #include <sstream>
@@ -35,6 +38,37 @@ namespace lelantus {
 
 static CLelantusState lelantusState;
 
+// Lets block validation (in particular TestBlockValidity on new block templates) skip
+// proofs already verified on mempool entry
+static const size_t MAX_VERIFIED_JOINSPLIT_PROOFS = 20000;
+static CVerifiedJoinSplitCache verifiedJoinSplitProofs(MAX_VERIFIED_JOINSPLIT_PROOFS);
+
+bool CVerifiedJoinSplitCache::Contains(const uint256& hashTx, const uint256& anonymitySetHash) const {
+    LOCK(cs);
+    auto it = verified.find(hashTx);
+    return it != verified.end() && it->second == anonymitySetHash;
+}
+
+void CVerifiedJoinSplitCache::Add(const uint256& hashTx, const uint256& anonymitySetHash) {
+    LOCK(cs);
+    auto result = verified.emplace(hashTx, anonymitySetHash);
+    if (!result.second) {
+        // verified again against other sets, keeps its place in the eviction order
+        result.first->second = anonymitySetHash;
+        return;
+    }
+    order.push_back(hashTx);
+    while (order.size() > nMaxSize) {
+        verified.erase(order.front());
+        order.pop_front();
+    }
+}
+
+size_t CVerifiedJoinSplitCache::Size() const {
+    LOCK(cs);
+    return verified.size();
+}
+
 static bool CheckLelantusSpendSerial(
         CValidationState &state,
         CLelantusTxInfo *lelantusTxInfo,
@@ -172,8 +206,9 @@ void ParseLelantusMintScript(const CScript& script, secp_primitives::GroupElemen
 
     pubcoin.deserialize(serialized.data());
 
-    CDataStream stream(
-            std::vector<unsigned char>(serialized.begin() + pubcoin.memoryRequired(), serialized.end()),
+    CPublicDataStream stream(
+            (const char *)serialized.data() + pubcoin.memoryRequired(),
+            (const char *)serialized.data() + serialized.size(),
             SER_NETWORK,
             PROTOCOL_VERSION
     );
@@ -227,24 +262,37 @@ void ParseLelantusMintScript(const CScript& script, secp_primitives::GroupElemen
     }
 }
 
-std::unique_ptr<JoinSplit> ParseLelantusJoinSplit(const CTransaction &tx)
+std::shared_ptr<const JoinSplit> GetParsedLelantusJoinSplit(const CTransaction &tx)
 {
+    std::shared_ptr<const JoinSplit> joinsplit = tx.parsedJoinSplit.Get();
+    if (joinsplit)
+        return joinsplit;
+
     if (tx.vin.size() != 1 || tx.vin[0].scriptSig.size() < 1) {
         throw CBadTxIn();
     }
 
-    CDataStream serialized(SER_NETWORK, PROTOCOL_VERSION);
-
+    const unsigned char *begin, *end;
     if (tx.vin[0].scriptSig[0] == OP_LELANTUSJOINSPLIT) {
-        serialized.write((const char *)tx.vin[0].scriptSig.data()+1, tx.vin[0].scriptSig.size()-1);
+        begin = tx.vin[0].scriptSig.data() + 1;
+        end = tx.vin[0].scriptSig.data() + tx.vin[0].scriptSig.size();
     }
     else if (tx.vin[0].scriptSig[0] == OP_LELANTUSJOINSPLITPAYLOAD && tx.nVersion >= 3 && tx.nType == TRANSACTION_LELANTUS) {
-        serialized.write((const char *)tx.vExtraPayload.data(), tx.vExtraPayload.size());
+        begin = tx.vExtraPayload.data();
+        end = tx.vExtraPayload.data() + tx.vExtraPayload.size();
     }
     else
         throw CBadTxIn();
 
-    return std::make_unique<lelantus::JoinSplit>(lelantus::Params::get_default(), serialized);
+    SpanReader serialized(SER_NETWORK, PROTOCOL_VERSION, begin, end);
+    joinsplit = std::make_shared<lelantus::JoinSplit>(lelantus::Params::get_default(), serialized);
+    tx.parsedJoinSplit.Set(joinsplit);
+    return joinsplit;
+}
+
+std::unique_ptr<JoinSplit> ParseLelantusJoinSplit(const CTransaction &tx)
+{
+    return std::make_unique<lelantus::JoinSplit>(*GetParsedLelantusJoinSplit(tx));
 }
 
 bool CheckLelantusBlock(CValidationState &state, const CBlock& block) {
@@ -449,59 +497,76 @@ bool CheckLelantusJoinSplitTransaction(
 
     std::vector<std::vector<unsigned char>> anonymity_set_hashes;
     const std::vector<uint32_t>& ids = joinsplit->getCoinGroupIds();
-	
-    for (auto& idAndHash : joinsplit->getIdAndBlockHashes()) {
-        auto& anonymity_set = anonymity_sets[idAndHash.first];
-        {
-            CLelantusState::LelantusCoinGroupInfo coinGroup;
-            if (!lelantusState.GetCoinGroupInfo(idAndHash.first, coinGroup))
-                return state.DoS(100, false, NO_MINT_PRIVCOIN,
-                                 "CheckLelantusJoinSplitTransaction: Error: no coins were minted with such parameters");
+    // first and last block of every anonymity set, they determine the coins in it
+    std::vector<std::pair<CBlockIndex*, CBlockIndex*>> anonymity_set_blocks;
+    CHashWriter anonymitySetHasher(SER_GETHASH, PROTOCOL_VERSION);
 
-            CBlockIndex *index = coinGroup.lastBlock;
+    for (auto& idAndHash : joinsplit->getIdAndBlockHashes()) {
+        CLelantusState::LelantusCoinGroupInfo coinGroup;
+        if (!lelantusState.GetCoinGroupInfo(idAndHash.first, coinGroup))
+            return state.DoS(100, false, NO_MINT_PRIVCOIN,
+                             "CheckLelantusJoinSplitTransaction: Error: no coins were minted with such parameters");
+
+        CBlockIndex *index = coinGroup.lastBlock;
+
+        // find index for block with hash of accumulatorBlockHash or set index to the coinGroup.firstBlock if not found
+        while (index != coinGroup.firstBlock && index->GetBlockHash() != idAndHash.second)
+            index = index->pprev;
+
+        // take the hash from last block of anonymity set, it is used at challenge generation if nLelantusStartBlock is passed
+        std::vector<unsigned char> set_hash;
+        if (nHeight >= params.nLelantusStartBlock) {
+            set_hash = GetAnonymitySetHash(index, idAndHash.first);
+            if (!set_hash.empty())
+                anonymity_set_hashes.push_back(set_hash);
+        }
 
+        anonymity_sets[idAndHash.first];
+        anonymity_set_blocks.push_back(std::make_pair(index, coinGroup.firstBlock));
+        anonymitySetHasher << idAndHash.first << index->GetBlockHash() << coinGroup.firstBlock->GetBlockHash() << set_hash;
+    }
 
-            // find index for block with hash of accumulatorBlockHash or set index to the coinGroup.firstBlock if not found
-            while (index != coinGroup.firstBlock && index->GetBlockHash() != idAndHash.second)
-                index = index->pprev;
+    uint256 anonymitySetHash = anonymitySetHasher.GetHash();
+    bool fVerified = verifiedJoinSplitProofs.Contains(hashTx, anonymitySetHash);
 
-            // take the hash from last block of anonymity set, it is used at challenge generation if nLelantusStartBlock is passed
-            if (nHeight >= params.nLelantusStartBlock) {
-                std::vector<unsigned char> set_hash = GetAnonymitySetHash(index, idAndHash.first);
-                if (!set_hash.empty())
-                    anonymity_set_hashes.push_back(set_hash);
+    // Build a vector with all the public coins with given id before
+    // the block on which the spend occured.
+    // This list of public coins is required by function "Verify" of JoinSplit.
+    // It isn't needed if the proof was already verified against the same sets.
+    size_t nSet = 0;
+    for (auto& idAndHash : joinsplit->getIdAndBlockHashes()) {
+        if (fVerified)
+            break;
+        auto& anonymity_set = anonymity_sets[idAndHash.first];
+        CBlockIndex *index = anonymity_set_blocks[nSet].first;
+        CBlockIndex *firstBlock = anonymity_set_blocks[nSet].second;
+        nSet++;
+
+        while (true) {
+            int id = 0;
+            if (CountCoinInBlock(index, idAndHash.first)) {
+                id = idAndHash.first;
+            } else if (CountCoinInBlock(index, idAndHash.first - 1)) {
+                id = idAndHash.first - 1;
             }
-            // Build a vector with all the public coins with given id before
-            // the block on which the spend occured.
-            // This list of public coins is required by function "Verify" of JoinSplit.
-
-            while (true) {
-                int id = 0;
-                if (CountCoinInBlock(index, idAndHash.first)) {
-                    id = idAndHash.first;
-                } else if (CountCoinInBlock(index, idAndHash.first - 1)) {
-                    id = idAndHash.first - 1;
-                }
-                if (id) {
-                    if(index->lelantusMintedPubCoins.count(id) > 0) {
-                        BOOST_FOREACH(
-                        const auto& pubCoinValue,
-                        index->lelantusMintedPubCoins[id]) {
-                            {
-                                if (::Params().GetConsensus().lelantusBlacklist.count(pubCoinValue.first.getValue()) > 0) {
-                                    continue;
-                                }
+            if (id) {
+                if(index->lelantusMintedPubCoins.count(id) > 0) {
+                    BOOST_FOREACH(
+                    const auto& pubCoinValue,
+                    index->lelantusMintedPubCoins[id]) {
+                        {
+                            if (::Params().GetConsensus().lelantusBlacklist.count(pubCoinValue.first.getValue()) > 0) {
+                                continue;
                             }
-                            anonymity_set.push_back(pubCoinValue.first);
                         }
+                        anonymity_set.push_back(pubCoinValue.first);
                     }
                 }
-                if (index == coinGroup.firstBlock)
-                    break;
-                index = index->pprev;
             }
+            if (index == firstBlock)
+                break;
+            index = index->pprev;
         }
-        anonymity_sets[idAndHash.first] = anonymity_set;
     }
 
     {
@@ -514,18 +579,30 @@ bool CheckLelantusJoinSplitTransaction(
         BatchProofContainer* batchProofContainer = BatchProofContainer::get_instance();
         bool useBatching = batchProofContainer->fCollectProofs && !isVerifyDB && !isCheckWallet && lelantusTxInfo && !lelantusTxInfo->fInfoIsComplete;
 
-        Scalar challenge;
-        // if we are collecting proofs, skip verification and collect proofs
-        passVerify = joinsplit->Verify(anonymity_sets, anonymity_set_hashes, Cout, Vout, txHashForMetadata, challenge, useBatching);
-
-        // add proofs into container
-        if(useBatching) {
-            std::map<uint32_t, size_t> idAndSizes;
-
-            for(auto itr : anonymity_sets)
-                idAndSizes[itr.first] = itr.second.size();
-
-            batchProofContainer->add(joinsplit.get(), Cout);
+        if (fVerified) {
+            // only the stateful checks below remain
+            LogPrint("lelantus", "CheckLelantusJoinSplitTransaction: already verified tx %s\n", hashTx.ToString());
+            PERF_COUNT("lelantus_proof_cache_hits", 1);
+            passVerify = true;
+        } else {
+            Scalar challenge;
+            // if we are collecting proofs, skip verification and collect proofs
+            int64_t nVerifyStart = GetTimeMicros();
+            passVerify = joinsplit->Verify(anonymity_sets, anonymity_set_hashes, Cout, Vout, txHashForMetadata, challenge, useBatching);
+            if (!useBatching)
+                PERF_RECORD("lelantus_verify_joinsplit", GetTimeMicros() - nVerifyStart);
+
+            // add proofs into container
+            if(useBatching) {
+                std::map<uint32_t, size_t> idAndSizes;
+
+                for(auto itr : anonymity_sets)
+                    idAndSizes[itr.first] = itr.second.size();
+
+                batchProofContainer->add(joinsplit.get(), Cout);
+            } else if (passVerify) {
+                verifiedJoinSplitProofs.Add(hashTx, anonymitySetHash);
+            }
         }
     }
 
@@ -746,10 +823,10 @@ void RemoveLelantusJoinSplitReferencingBlock(CTxMemPool& pool, CBlockIndex* bloc
             // block removed. If any one is equal, remove txn from mempool.
             for (const CTxIn& txin : tx.vin) {
                 if (txin.IsLelantusJoinSplit()) {
-                    std::unique_ptr<lelantus::JoinSplit> joinsplit;
+                    std::shared_ptr<const lelantus::JoinSplit> joinsplit;
 
                     try {
-                        joinsplit = ParseLelantusJoinSplit(tx);
+                        joinsplit = GetParsedLelantusJoinSplit(tx);
                     }
                     catch (const std::exception &) {
                         txn_to_remove.push_back(tx);
@@ -788,7 +865,7 @@ std::vector<Scalar> GetLelantusJoinSplitSerialNumbers(const CTransaction &tx, co
         return std::vector<Scalar>();
 
     try {
-        return ParseLelantusJoinSplit(tx)->getCoinSerialNumbers();
+        return GetParsedLelantusJoinSplit(tx)->getCoinSerialNumbers();
     }
     catch (const std::exception &) {
         return std::vector<Scalar>();
@@ -800,7 +877,7 @@ std::vector<uint32_t> GetLelantusJoinSplitIds(const CTransaction &tx, const CTxI
         return std::vector<uint32_t>();
 
     try {
-        return ParseLelantusJoinSplit(tx)->getCoinGroupIds();
+        return GetParsedLelantusJoinSplit(tx)->getCoinGroupIds();
     }
     catch (const std::exception &) {
         return std::vector<uint32_t>();
@@ -1079,7 +1156,7 @@ void CLelantusState::Containers::AddSpend(Scalar const & serial, int coinGroupId
 void CLelantusState::Containers::RemoveSpend(Scalar const & serial) {
     auto iter = usedCoinSerials.find(serial);
     if (iter != usedCoinSerials.end()) {
-        spendMetaInfo[iter->second] -= 1;
+        spendMetaInfo[iter.value()] -= 1;
         usedCoinSerials.erase(iter);
         CheckSurgeCondition();
     }
@@ -1103,7 +1180,7 @@ std::unordered_map<uint256, lelantus::PublicCoin>&  CLelantusState::Containers::
     return tagToPublicCoin;
 }
 
-std::unordered_map<Scalar, int> const & CLelantusState::Containers::GetSpends() const {
+CTagMap<Scalar, int> const & CLelantusState::Containers::GetSpends() const {
     return usedCoinSerials;
 }
 
@@ -1364,9 +1441,11 @@ bool CLelantusState::IsUsedCoinSerial(const Scalar &coinSerial) {
 }
 
 bool CLelantusState::IsUsedCoinSerialHash(Scalar &coinSerial, const uint256 &coinSerialHash) {
-    for ( auto it = GetSpends().begin(); it != GetSpends().end(); ++it ){
-        if(primitives::GetSerialHash(it->first)==coinSerialHash){
-            coinSerial = it->first;
+    // the serial hash is the hash of the serialized serial, the key encoding
+    // of the spends map, so only the matching serial needs to be decoded
+    for (auto it = GetSpends().begin(); it != GetSpends().end(); ++it) {
+        if (Hash(it.data(), it.data() + Scalar::memoryRequired()) == coinSerialHash) {
+            coinSerial = it.key();
             return true;
         }
     }
@@ -1664,7 +1743,13 @@ mint_info_container const & CLelantusState::GetMints() const {
     return containers.GetMints();
 }
 
-std::unordered_map<Scalar, int> const & CLelantusState::GetSpends() const {
+std::size_t CLelantusState::GetMemoryUsage() const {
+    return memusage::DynamicUsage(containers.GetMints())
+        + memusage::DynamicUsage(containers.GetSpends())
+        + memusage::DynamicUsage(coinGroups);
+}
+
+CTagMap<Scalar, int> const & CLelantusState::GetSpends() const {
     return containers.GetSpends();
 }
 
@@ -1672,7 +1757,7 @@ std::unordered_map<int, CLelantusState::LelantusCoinGroupInfo> const & CLelantus
     return coinGroups;
 }
 
-std::unordered_map<Scalar, uint256, lelantus::CScalarHash> const & CLelantusState::GetMempoolCoinSerials() const {
+CTagMap<Scalar, uint256> const & CLelantusState::GetMempoolCoinSerials() const {
     LOCK(mempool.cs);
     return mempool.lelantusState.GetMempoolCoinSerials();
 }
@@ -1713,7 +1798,7 @@ bool CLelantusMempoolState::HasMint(const GroupElement& pubCoin) {
 }
 
 bool CLelantusMempoolState::AddSpendToMempool(const Scalar &coinSerial, uint256 txHash) {
-    return mempoolCoinSerials.insert({coinSerial, txHash}).second;
+    return mempoolCoinSerials.insert(coinSerial, txHash);
 }
 
 void CLelantusMempoolState::AddMintToMempool(const GroupElement& pubCoin) {
@@ -1725,10 +1810,11 @@ void CLelantusMempoolState::RemoveMintFromMempool(const GroupElement& pubCoin) {
 }
 
 uint256 CLelantusMempoolState::GetMempoolConflictingTxHash(const Scalar& coinSerial) {
-    if (mempoolCoinSerials.count(coinSerial) == 0)
+    auto iter = mempoolCoinSerials.find(coinSerial);
+    if (iter == mempoolCoinSerials.end())
         return uint256();
 
-    return mempoolCoinSerials[coinSerial];
+    return iter.value();
 }
 
 void CLelantusMempoolState::RemoveSpendFromMempool(const Scalar &coinSerial) {
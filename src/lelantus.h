@@ -13,6 +13,9 @@
 #include <unordered_map>
 #include <functional>
 #include "coin_containers.h"
+#include "sync.h"
+#include "tagmap.h"
+#include <deque>
 
 namespace lelantus_mintspend { struct lelantus_mintspend_test; }
 
@@ -53,6 +56,9 @@ void ParseLelantusMintScript(const CScript& script, secp_primitives::GroupElemen
 void ParseLelantusJMintScript(const CScript& script, secp_primitives::GroupElement& pubcoin, std::vector<unsigned char>& encryptedValue);
 void ParseLelantusJMintScript(const CScript& script, secp_primitives::GroupElement& pubcoin, std::vector<unsigned char>& encryptedValue, uint256& mintTag);
 void ParseLelantusMintScript(const CScript& script, secp_primitives::GroupElement& pubcoin);
+// Parsed once per transaction and shared, throws like ParseLelantusJoinSplit
+std::shared_ptr<const JoinSplit> GetParsedLelantusJoinSplit(const CTransaction& tx);
+// Modifiable copy of the parsed joinsplit
 std::unique_ptr<JoinSplit> ParseLelantusJoinSplit(const CTransaction& tx);
 
 size_t GetSpendInputs(const CTransaction &tx, const CTxIn& in);
@@ -104,10 +110,28 @@ std::vector<uint32_t> GetLelantusJoinSplitIds(const CTransaction &tx, const CTxI
  */
 size_t CountCoinInBlock(CBlockIndex const *index, int id);
 
+// Joinsplit transactions whose proofs passed verification, mapped to the hash of the
+// anonymity sets they were verified against. The oldest entries are evicted first
+class CVerifiedJoinSplitCache {
+private:
+    mutable CCriticalSection cs;
+    size_t nMaxSize;
+    std::map<uint256, uint256> verified;
+    // transaction hashes in insertion order
+    std::deque<uint256> order;
+
+public:
+    explicit CVerifiedJoinSplitCache(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn) {}
+
+    bool Contains(const uint256& hashTx, const uint256& anonymitySetHash) const;
+    void Add(const uint256& hashTx, const uint256& anonymitySetHash);
+    size_t Size() const;
+};
+
 class CLelantusMempoolState {
 private:
     // serials of spends currently in the mempool mapped to tx hashes
-    std::unordered_map<Scalar, uint256, lelantus::CScalarHash> mempoolCoinSerials;
+    CTagMap<Scalar, uint256> mempoolCoinSerials;
     // mints in the mempool
     std::unordered_set<GroupElement> mempoolMints;
 
@@ -129,7 +153,7 @@ public:
     // Remove spend from the mempool (usually as the result of adding tx to the block)
     void RemoveSpendFromMempool(const Scalar& coinSerial);
 
-    std::unordered_map<Scalar, uint256, lelantus::CScalarHash> const & GetMempoolCoinSerials() const { return mempoolCoinSerials; }
+    CTagMap<Scalar, uint256> const & GetMempoolCoinSerials() const { return mempoolCoinSerials; }
 
     void Reset();
 };
@@ -239,11 +263,13 @@ public:
     int GetLatestCoinID() const;
 
     mint_info_container const & GetMints() const;
-    std::unordered_map<Scalar, int> const & GetSpends() const;
+    CTagMap<Scalar, int> const & GetSpends() const;
     std::unordered_map<int, LelantusCoinGroupInfo> const & GetCoinGroups() const ;
-    std::unordered_map<Scalar, uint256, lelantus::CScalarHash> const & GetMempoolCoinSerials() const;
+    CTagMap<Scalar, uint256> const & GetMempoolCoinSerials() const;
 
     std::size_t GetTotalCoins() const { return GetMints().size(); }
+    //! Approximate heap usage of the state maps, used to account the state against -dbcache
+    std::size_t GetMemoryUsage() const;
 
     bool IsSurgeConditionDetected() const;
 
@@ -278,7 +304,7 @@ private:
         void Reset();
 
         mint_info_container const & GetMints() const;
-        std::unordered_map<Scalar, int> const & GetSpends() const;
+        CTagMap<Scalar, int> const & GetSpends() const;
         std::unordered_map<uint256, lelantus::PublicCoin>& GetTagToPublicCoin();
         bool IsSurgeCondition() const;
     private:
@@ -286,7 +312,7 @@ private:
         // Used for checking if the given coin already exists.
         mint_info_container mintedPubCoins;
         // Set of all used coin serials.
-        std::unordered_map<Scalar, int> usedCoinSerials;
+        CTagMap<Scalar, int> usedCoinSerials;
 
         //this map keeps hash(G^s*H0^r|seedId) to G^s*H0^r*H1^v
         std::unordered_map<uint256, lelantus::PublicCoin> tagToPublicCoin;
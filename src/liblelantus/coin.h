@@ -7,6 +7,9 @@
 #include "openssl_context.h"
 #include "crypto/sha256.h"
 
+#include <map>
+#include <memory>
+
 // keep this just to not break old index
 namespace sigma {
 enum class CoinDenomination : std::uint8_t {
@@ -178,6 +181,9 @@ private:
     void mintCoin(uint64_t v);
 };
 
+// anonymity sets by group id, shared by the joinsplits proven against them
+using shared_anonymity_sets = std::map<uint32_t, std::shared_ptr<const std::vector<PublicCoin>>>;
+
 }// namespace lelantus
 
 #endif //BZX_LIBLELANTUS_COIN_H
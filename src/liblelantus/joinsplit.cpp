@@ -9,7 +9,7 @@ namespace lelantus {
 
 JoinSplit::JoinSplit(const Params *p,
              const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin,
-             const std::map<uint32_t, std::vector<PublicCoin>>& anonymity_sets,
+             const shared_anonymity_sets& anonymity_sets,
              const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
              const Scalar& Vout,
              const std::vector<PrivateCoin>& Cout,
@@ -38,7 +38,7 @@ JoinSplit::JoinSplit(const Params *p,
         if(set == anonymity_sets.end())
             throw std::invalid_argument("No such anonymity set");
 
-        if(!getIndex(Cin[i].first.getPublicCoin(), set->second, index))
+        if(!getIndex(Cin[i].first.getPublicCoin(), *set->second, index))
             throw std::invalid_argument("No such coin in this anonymity set");
 
         groupIds.push_back(Cin[i].second);
@@ -127,6 +127,29 @@ bool JoinSplit::Verify(
         const uint256& txHash,
         Scalar& challenge,
         bool fSkipVerification ) const {
+    if (!VerifySignatures(Cout.size(), txHash))
+        return false;
+
+    // Now verify lelantus proof
+    LelantusVerifier verifier(params, version);
+    return verifier.verify(anonymity_sets, anonymity_set_hashes, serialNumbers, ecdsaPubkeys, groupIds, uint64_t(0),Vout, fee, Cout, lelantusProof, qkSchnorrProof, challenge, fSkipVerification);
+}
+
+bool JoinSplit::Verify(
+        const shared_anonymity_sets& anonymity_sets,
+        const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
+        const std::vector<PublicCoin>& Cout,
+        uint64_t Vout,
+        const uint256& txHash) const {
+    if (!VerifySignatures(Cout.size(), txHash))
+        return false;
+
+    Scalar challenge;
+    LelantusVerifier verifier(params, version);
+    return verifier.verify(anonymity_sets, anonymity_set_hashes, serialNumbers, ecdsaPubkeys, groupIds, uint64_t(0),Vout, fee, Cout, lelantusProof, qkSchnorrProof, challenge);
+}
+
+bool JoinSplit::VerifySignatures(size_t coutSize, const uint256& txHash) const {
     std::map<uint32_t, uint256> groupBlockHashes;
 
     for(const auto& idAndHash : coinGroupIdAndBlockHash) {
@@ -136,7 +159,7 @@ bool JoinSplit::Verify(
 
     SpendMetaData m(groupBlockHashes, txHash);
 
-    uint256 metahash = signatureHash(m, Cout.size());
+    uint256 metahash = signatureHash(m, coutSize);
 
     if(serialNumbers.size() != ecdsaSignatures.size() || serialNumbers.size() != ecdsaPubkeys.size()) {
         LogPrintf("Sigma spend failed due to serialNumbers and ecdsaSignatures/ecdsaPubkeys number mismatch.");
@@ -179,9 +202,7 @@ bool JoinSplit::Verify(
         }
     }
 
-    // Now verify lelantus proof
-    LelantusVerifier verifier(params, version);
-    return verifier.verify(anonymity_sets, anonymity_set_hashes, serialNumbers, ecdsaPubkeys, groupIds, uint64_t(0),Vout, fee, Cout, lelantusProof, qkSchnorrProof, challenge, fSkipVerification);
+    return true;
 }
 
 
@@ -191,23 +212,23 @@ uint256 JoinSplit::signatureHash(const SpendMetaData& m, size_t coutSize) const
     return h.GetHash();
 }
 
-const std::vector<uint32_t>& JoinSplit::getCoinGroupIds() {
+const std::vector<uint32_t>& JoinSplit::getCoinGroupIds() const {
     return this->groupIds;
 }
 
-const std::vector<std::pair<uint32_t, uint256>>& JoinSplit::getIdAndBlockHashes() {
+const std::vector<std::pair<uint32_t, uint256>>& JoinSplit::getIdAndBlockHashes() const {
     return this->coinGroupIdAndBlockHash;
 }
 
-const std::vector<Scalar>& JoinSplit::getCoinSerialNumbers() {
+const std::vector<Scalar>& JoinSplit::getCoinSerialNumbers() const {
     return this->serialNumbers;
 }
 
-const LelantusProof& JoinSplit::getLelantusProof() {
+const LelantusProof& JoinSplit::getLelantusProof() const {
     return this->lelantusProof;
 }
 
-uint64_t JoinSplit::getFee() {
+uint64_t JoinSplit::getFee() const {
     return this->fee;
 }
 
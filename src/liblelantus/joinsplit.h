@@ -17,7 +17,7 @@ public:
 
     JoinSplit(const Params* p,
               const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin,
-              const std::map<uint32_t, std::vector<PublicCoin>>& anonymity_sets,
+              const shared_anonymity_sets& anonymity_sets,
               const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
               const Scalar& Vout,
               const std::vector<PrivateCoin>& Cout,
@@ -40,6 +40,13 @@ public:
                 Scalar& challenge,
                 bool fSkipVerification = false) const;
 
+    // verifies against sets shared with the prover, without copying them
+    bool Verify(const shared_anonymity_sets& anonymity_sets,
+                const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
+                const std::vector<PublicCoin>& Cout,
+                uint64_t Vout,
+                const uint256& txHash) const;
+
     void generatePubKeys(const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin);
 
     void signMetaData(const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin, const SpendMetaData& m, size_t coutSize);
@@ -50,15 +57,15 @@ public:
         version = nVersion;
     }
 
-    const std::vector<Scalar>& getCoinSerialNumbers();
+    const std::vector<Scalar>& getCoinSerialNumbers() const;
 
-    const LelantusProof& getLelantusProof();
+    const LelantusProof& getLelantusProof() const;
 
-    uint64_t getFee();
+    uint64_t getFee() const;
 
-    const std::vector<uint32_t>& getCoinGroupIds();
+    const std::vector<uint32_t>& getCoinGroupIds() const;
 
-    const std::vector<std::pair<uint32_t, uint256>>& getIdAndBlockHashes();
+    const std::vector<std::pair<uint32_t, uint256>>& getIdAndBlockHashes() const;
 
     int getVersion() const {
         return version;
@@ -124,6 +131,8 @@ public:
     }
 
 private:
+    bool VerifySignatures(size_t coutSize, const uint256& txHash) const;
+
     const Params* params;
     unsigned int version = 0;
     LelantusProof lelantusProof;
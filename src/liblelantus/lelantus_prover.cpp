@@ -8,7 +8,7 @@ LelantusProver::LelantusProver(const Params* p, unsigned int v) : params(p), ver
 }
 
 void LelantusProver::proof(
-        const std::map<uint32_t, std::vector<PublicCoin>>& anonymity_sets,
+        const shared_anonymity_sets& anonymity_sets,
         const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
         const Scalar& Vin,
         const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin,
@@ -74,7 +74,7 @@ void LelantusProver::proof(
 }
 
 void LelantusProver::generate_sigma_proofs(
-        const std::map<uint32_t, std::vector<PublicCoin>>& c,
+        const shared_anonymity_sets& c,
         const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
         const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin,
         const std::vector<PrivateCoin>& Cout,
@@ -127,7 +127,7 @@ void LelantusProver::generate_sigma_proofs(
                 if (set == c.end())
                     throw std::invalid_argument("No such anonymity set");
 
-                for (auto const &coin : set->second)
+                for (auto const &coin : *set->second)
                     C_[i].emplace_back(coin.getValue() + gs);
 
                 rA[i].randomize();
@@ -12,7 +12,7 @@ class LelantusProver {
 public:
     LelantusProver(const Params* p, unsigned int v);
     void proof(
-            const std::map<uint32_t, std::vector<PublicCoin>>& anonymity_sets,
+            const shared_anonymity_sets& anonymity_sets,
             const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
             const Scalar& Vin,
             const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin,
@@ -26,7 +26,7 @@ public:
 
 private:
     void generate_sigma_proofs(
-            const std::map<uint32_t, std::vector<PublicCoin>>& c,
+            const shared_anonymity_sets& c,
             const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
             const std::vector<std::pair<PrivateCoin, uint32_t>>& Cin,
             const std::vector<PrivateCoin>& Cout,
@@ -39,6 +39,48 @@ bool LelantusVerifier::verify(
         const SchnorrProof& qkSchnorrProof,
         Scalar& x,
         bool fSkipVerification) {
+    anonymity_set_refs sets;
+    sets.reserve(anonymity_sets.size());
+    for (const auto& set : anonymity_sets)
+        sets.emplace_back(set.first, &set.second);
+    return verify_sets(sets, anonymity_set_hashes, serialNumbers, ecdsaPubkeys, groupIds, Vin, Vout, fee, Cout, proof, qkSchnorrProof, x, fSkipVerification);
+}
+
+bool LelantusVerifier::verify(
+        const shared_anonymity_sets& anonymity_sets,
+        const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
+        const std::vector<Scalar>& serialNumbers,
+        const std::vector<std::vector<unsigned char>>& ecdsaPubkeys,
+        const std::vector<uint32_t>& groupIds,
+        const Scalar& Vin,
+        uint64_t Vout,
+        uint64_t fee,
+        const std::vector<PublicCoin>& Cout,
+        const LelantusProof& proof,
+        const SchnorrProof& qkSchnorrProof,
+        Scalar& x,
+        bool fSkipVerification) {
+    anonymity_set_refs sets;
+    sets.reserve(anonymity_sets.size());
+    for (const auto& set : anonymity_sets)
+        sets.emplace_back(set.first, set.second.get());
+    return verify_sets(sets, anonymity_set_hashes, serialNumbers, ecdsaPubkeys, groupIds, Vin, Vout, fee, Cout, proof, qkSchnorrProof, x, fSkipVerification);
+}
+
+bool LelantusVerifier::verify_sets(
+        const anonymity_set_refs& anonymity_sets,
+        const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
+        const std::vector<Scalar>& serialNumbers,
+        const std::vector<std::vector<unsigned char>>& ecdsaPubkeys,
+        const std::vector<uint32_t>& groupIds,
+        const Scalar& Vin,
+        uint64_t Vout,
+        uint64_t fee,
+        const std::vector<PublicCoin>& Cout,
+        const LelantusProof& proof,
+        const SchnorrProof& qkSchnorrProof,
+        Scalar& x,
+        bool fSkipVerification) {
     //check the overflow of Vout and fee
     if (!(Vout <= uint64_t(::Params().GetConsensus().nMaxValueLelantusSpendPerTransaction) && fee < (1000 * CENT))) { // 1000 * CENT is the value of max fee defined at validation.h
         LogPrintf("Lelantus verification failed due to transparent values check failed.");
@@ -57,7 +99,7 @@ bool LelantusVerifier::verify(
         return false;
     }
 
-    std::vector<std::vector<PublicCoin>> vAnonymity_sets;
+    std::vector<const std::vector<PublicCoin>*> vAnonymity_sets;
     std::vector<std::vector<Scalar>> vSin;
     vAnonymity_sets.reserve(anonymity_sets.size());
     vSin.resize(anonymity_sets.size());
@@ -89,7 +131,7 @@ bool LelantusVerifier::verify(
 }
 
 bool LelantusVerifier::verify_sigma(
-        const std::vector<std::vector<PublicCoin>>& anonymity_sets,
+        const std::vector<const std::vector<PublicCoin>*>& anonymity_sets,
         const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
         const std::vector<std::vector<Scalar>>& Sin,
         const std::vector<Scalar>& serialNumbers,
@@ -138,9 +180,10 @@ bool LelantusVerifier::verify_sigma(
             continue;
 
         std::vector<GroupElement> C_;
-        C_.reserve(anonymity_sets[k].size());
-        for (std::size_t j = 0; j < anonymity_sets[k].size(); ++j)
-            C_.emplace_back(anonymity_sets[k][j].getValue());
+        const std::vector<PublicCoin>& set = *anonymity_sets[k];
+        C_.reserve(set.size());
+        for (std::size_t j = 0; j < set.size(); ++j)
+            C_.emplace_back(set[j].getValue());
 
         if (!sigmaVerifier.batchverify(C_, x, Sin[k], sigma_proofs_k)) {
             LogPrintf("Lelantus verification failed due sigma verification failed.");
@@ -40,9 +40,41 @@ public:
             Scalar& x,
             bool fSkipVerification = false);
 
+    bool verify(
+            const shared_anonymity_sets& anonymity_sets,
+            const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
+            const std::vector<Scalar>& serialNumbers,
+            const std::vector<std::vector<unsigned char>>& ecdsaPubkeys,
+            const std::vector<uint32_t>& groupIds,
+            const Scalar& Vin,
+            uint64_t Vout,
+            uint64_t fee,
+            const std::vector<PublicCoin>& Cout,
+            const LelantusProof& proof,
+            const SchnorrProof& qkSchnorrProof,
+            Scalar& x,
+            bool fSkipVerification = false);
+
 private:
+    // anonymity sets by group id, pointing into the caller's sets instead of copying them
+    typedef std::vector<std::pair<uint32_t, const std::vector<PublicCoin>*>> anonymity_set_refs;
+
+    bool verify_sets(
+            const anonymity_set_refs& anonymity_sets,
+            const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
+            const std::vector<Scalar>& serialNumbers,
+            const std::vector<std::vector<unsigned char>>& ecdsaPubkeys,
+            const std::vector<uint32_t>& groupIds,
+            const Scalar& Vin,
+            uint64_t Vout,
+            uint64_t fee,
+            const std::vector<PublicCoin>& Cout,
+            const LelantusProof& proof,
+            const SchnorrProof& qkSchnorrProof,
+            Scalar& x,
+            bool fSkipVerification);
     bool verify_sigma(
-            const std::vector<std::vector<PublicCoin>>& anonymity_sets,
+            const std::vector<const std::vector<PublicCoin>*>& anonymity_sets,
             const std::vector<std::vector<unsigned char>>& anonymity_set_hashes,
             const std::vector<std::vector<Scalar>>& Sin,
             const std::vector<Scalar>& serialNumbers,
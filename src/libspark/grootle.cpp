@@ -316,6 +316,11 @@ void Grootle::prove(
         proof.X1.emplace_back(mult_V.get_multiple() + H*rho_V[j]);
     }
 
+    // X and X1 are hashed here and serialized with the proof, convert them
+    // to affine coordinates once
+    GroupElement::normalize_batch(proof.X.data(), proof.X.size());
+    GroupElement::normalize_batch(proof.X1.data(), proof.X1.size());
+
     // Challenge
     transcript.add("A", proof.A);
     transcript.add("B", proof.B);
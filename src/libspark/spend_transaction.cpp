@@ -1,5 +1,9 @@
 #include "spend_transaction.h"
 
+#include "../liblelantus/threadpool.h"
+
+#include <boost/thread.hpp>
+
 namespace spark {
 
 // Generate a spend transaction that consumes existing coins and generates new ones
@@ -31,7 +35,6 @@ SpendTransaction::SpendTransaction(
     this->setCoverSets(cover_set_data);
 	this->S1.reserve(w); // serial commitment offsets
 	this->C1.reserve(w); // value commitment offsets
-	this->grootle_proofs.reserve(w); // Grootle one-of-many proofs
 	this->T.reserve(w); // linking tags
 
 	this->f = f; // fee
@@ -52,6 +55,10 @@ SpendTransaction::SpendTransaction(
 		this->params->get_n_grootle(),
 		this->params->get_m_grootle()
 	);
+	// Inputs spending from the same cover set share its commitment vectors
+	std::unordered_map<uint64_t, std::pair<std::vector<GroupElement>, std::vector<GroupElement>>> cover_set_commitments;
+	std::vector<Scalar> grootle_s, grootle_v; // Grootle witnesses
+	std::vector<const std::vector<unsigned char>*> grootle_roots; // cover set representations
 	for (std::size_t u = 0; u < w; u++) {
 		// Parse out cover set data for this spend
         uint64_t set_id = inputs[u].cover_set_id;
@@ -64,49 +71,87 @@ SpendTransaction::SpendTransaction(
         if (set_size > N)
             throw std::invalid_argument("Wrong set size");
 
-        std::vector<GroupElement> S, C;
-		S.reserve(set_size);
-		C.reserve(set_size);
-		for (std::size_t i = 0; i < set_size; i++) {
-			S.emplace_back(cover_set[i].S);
-			C.emplace_back(cover_set[i].C);
-		}
+        if (cover_set_commitments.count(set_id) == 0) {
+            auto& commitments = cover_set_commitments[set_id];
+            commitments.first.reserve(set_size);
+            commitments.second.reserve(set_size);
+            for (std::size_t i = 0; i < set_size; i++) {
+                commitments.first.emplace_back(cover_set[i].S);
+                commitments.second.emplace_back(cover_set[i].C);
+            }
+        }
+
+		Scalar ser1 = SparkUtils::hash_ser1(inputs[u].s, full_view_key.get_D());
+		Scalar val1 = SparkUtils::hash_val1(inputs[u].s, full_view_key.get_D());
 
 		// Serial commitment offset
 		this->S1.emplace_back(
 			this->params->get_F()*inputs[u].s
-			+ this->params->get_H().inverse()*SparkUtils::hash_ser1(inputs[u].s, full_view_key.get_D())
+			+ this->params->get_H().inverse()*ser1
 			+ full_view_key.get_D()
 		);
 
 		// Value commitment offset
 		this->C1.emplace_back(
 			this->params->get_G()*Scalar(inputs[u].v)
-			+ this->params->get_H()*SparkUtils::hash_val1(inputs[u].s, full_view_key.get_D())
+			+ this->params->get_H()*val1
 		);
 
 		// Tags
 		this->T.emplace_back(inputs[u].T);
 
-		// Grootle proof
-		this->grootle_proofs.emplace_back();
-		std::size_t l = inputs[u].index;
-		grootle.prove(
-			l,
-			SparkUtils::hash_ser1(inputs[u].s, full_view_key.get_D()),
-			S,
-			this->S1.back(),
-			SparkUtils::hash_val(inputs[u].k) - SparkUtils::hash_val1(inputs[u].s, full_view_key.get_D()),
-			C,
-			this->C1.back(),
-			this->cover_set_representations[set_id],
-			this->grootle_proofs.back()
-		);
+		// Grootle witnesses
+		grootle_s.emplace_back(ser1);
+		grootle_v.emplace_back(SparkUtils::hash_val(inputs[u].k) - val1);
+		grootle_roots.emplace_back(&this->cover_set_representations[set_id]);
 
 		// Chaum data
 		chaum_x.emplace_back(inputs[u].s);
 		chaum_y.emplace_back(spend_key.get_r());
-		chaum_z.emplace_back(SparkUtils::hash_ser1(inputs[u].s, full_view_key.get_D()).negate());
+		chaum_z.emplace_back(ser1.negate());
+	}
+
+	// Grootle proofs are independent of each other, generate them concurrently
+	this->grootle_proofs.resize(w);
+	auto prove = [&](std::size_t u) {
+		const auto& commitments = cover_set_commitments.at(this->cover_set_ids[u]);
+		grootle.prove(
+			inputs[u].index,
+			grootle_s[u],
+			commitments.first,
+			this->S1[u],
+			grootle_v[u],
+			commitments.second,
+			this->C1[u],
+			*grootle_roots[u],
+			this->grootle_proofs[u]
+		);
+	};
+	std::size_t threadsMaxCount = std::min((unsigned int)w, boost::thread::hardware_concurrency());
+	if (threadsMaxCount <= 1) {
+		for (std::size_t u = 0; u < w; u++)
+			prove(u);
+	} else {
+		ParallelOpThreadPool<void> threadPool(threadsMaxCount);
+		std::vector<boost::future<void>> parallelTasks;
+		std::vector<std::exception_ptr> errors(w);
+		parallelTasks.reserve(w);
+		DoNotDisturb dnd;
+		for (std::size_t u = 0; u < w; u++) {
+			parallelTasks.emplace_back(threadPool.PostTask([&, u]() {
+				try {
+					prove(u);
+				} catch (...) {
+					errors[u] = std::current_exception();
+				}
+			}));
+		}
+		for (auto& task : parallelTasks)
+			task.get();
+		for (const auto& error : errors) {
+			if (error)
+				std::rethrow_exception(error);
+		}
 	}
 
 	// Generate output coins and prepare range proof vectors
@@ -208,7 +253,7 @@ SpendTransaction::SpendTransaction(
 	);
 }
 
-uint64_t SpendTransaction::getFee() {
+uint64_t SpendTransaction::getFee() const {
     return f;
 }
 
@@ -216,11 +261,11 @@ const std::vector<GroupElement>& SpendTransaction::getUsedLTags() const {
     return T;
 }
 
-const std::vector<uint64_t>& SpendTransaction::getCoinGroupIds() {
+const std::vector<uint64_t>& SpendTransaction::getCoinGroupIds() const {
     return cover_set_ids;
 }
 
-const std::vector<Coin>& SpendTransaction::getOutCoins() {
+const std::vector<Coin>& SpendTransaction::getOutCoins() const {
     return out_coins;
 }
 
@@ -456,7 +501,7 @@ void SpendTransaction::setBlockHashes(const std::map<uint64_t, uint256>& idAndHa
     set_id_blockHash = idAndHashes;
 }
 
-const std::map<uint64_t, uint256>& SpendTransaction::getBlockHashes() {
+const std::map<uint64_t, uint256>& SpendTransaction::getBlockHashes() const {
     return set_id_blockHash;
 }
 
@@ -53,10 +53,10 @@ public:
 		const std::vector<OutputCoinData>& outputs
 	);
 
-	uint64_t getFee();
+	uint64_t getFee() const;
     const std::vector<GroupElement>& getUsedLTags() const;
-    const std::vector<Coin>& getOutCoins();
-    const std::vector<uint64_t>& getCoinGroupIds();
+    const std::vector<Coin>& getOutCoins() const;
+    const std::vector<uint64_t>& getCoinGroupIds() const;
 
 	static bool verify(const Params* params, const std::vector<SpendTransaction>& transactions, const std::unordered_map<uint64_t, std::vector<Coin>>& cover_sets);
 	static bool verify(const SpendTransaction& transaction, const std::unordered_map<uint64_t, std::vector<Coin>>& cover_sets);
@@ -109,7 +109,7 @@ public:
 
     void setBlockHashes(const std::map<uint64_t, uint256>& idAndHashes);
 
-    const std::map<uint64_t, uint256>& getBlockHashes();
+    const std::map<uint64_t, uint256>& getBlockHashes() const;
 private:
 	const Params* params;
     // We need to construct and pass this data before running verification
@@ -56,10 +56,12 @@ void Transcript::add(const std::string label, const std::vector<GroupElement>& g
     include_flag(FLAG_VECTOR);
     size(group_elements.size());
     include_label(label);
+    std::vector<unsigned char> buffer(group_elements.size() * GroupElement::serialize_size);
+    GroupElement::serialize_batch(group_elements.data(), group_elements.size(), buffer.data());
     for (std::size_t i = 0; i < group_elements.size(); i++) {
-        std::vector<unsigned char> data;
-        data.resize(GroupElement::serialize_size);
-        group_elements[i].serialize(data.data());
+        std::vector<unsigned char> data(
+            buffer.begin() + i * GroupElement::serialize_size,
+            buffer.begin() + (i + 1) * GroupElement::serialize_size);
         include_data(data);
     }
 }
@@ -26,6 +26,8 @@ namespace llmq
 
 static const std::string DB_QUORUM_SK_SHARE = "q_Qsk";
 static const std::string DB_QUORUM_QUORUM_VVEC = "q_Qqvvec";
+static const std::string DB_QUORUM_MEMBERS = "q_Qmembers";
+static const std::string DB_QUORUM_PUBKEY_SHARES = "q_Qpkshares";
 
 CQuorumManager* quorumManager;
 
@@ -84,6 +86,9 @@ CBLSPublicKey CQuorum::GetPubKeyShare(size_t memberIdx) const
     if (quorumVvec == nullptr || memberIdx >= members.size() || !qc.validMembers[memberIdx]) {
         return CBLSPublicKey();
     }
+    if (!pubKeyShares.empty()) {
+        return pubKeyShares[memberIdx];
+    }
     auto& m = members[memberIdx];
     return blsCache.BuildPubKeyShare(m->proTxHash, quorumVvec, CBLSId(m->proTxHash));
 }
@@ -133,9 +138,35 @@ bool CQuorum::ReadContributions(CEvoDB& evoDb)
     return true;
 }
 
-void CQuorum::StartCachePopulatorThread(std::shared_ptr<CQuorum> _this)
+void CQuorum::WritePubKeyShares(CEvoDB& evoDb) const
 {
-    if (_this->quorumVvec == nullptr) {
+    std::vector<CBLSPublicKey> shares(members.size());
+    for (size_t i = 0; i < members.size(); i++) {
+        if (qc.validMembers[i]) {
+            shares[i] = GetPubKeyShare(i);
+        }
+    }
+    evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_PUBKEY_SHARES, MakeQuorumKey(*this)), shares);
+}
+
+bool CQuorum::ReadPubKeyShares(CEvoDB& evoDb)
+{
+    std::vector<CBLSPublicKey> shares;
+    if (!evoDb.Read(std::make_pair(DB_QUORUM_PUBKEY_SHARES, MakeQuorumKey(*this)), shares) || shares.size() != members.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < members.size(); i++) {
+        if (qc.validMembers[i] && !shares[i].IsValid()) {
+            return false;
+        }
+    }
+    pubKeyShares = std::move(shares);
+    return true;
+}
+
+void CQuorum::StartCachePopulatorThread(std::shared_ptr<CQuorum> _this, CEvoDB& evoDb)
+{
+    if (_this->quorumVvec == nullptr || !_this->pubKeyShares.empty()) {
         return;
     }
 
@@ -144,13 +175,19 @@ void CQuorum::StartCachePopulatorThread(std::shared_ptr<CQuorum> _this)
 
     // this thread will exit after some time
     // when then later some other thread tries to get keys, it will be much faster
-    _this->cachePopulatorThread = std::thread([_this, t]() {
+    CEvoDB* pEvoDb = &evoDb;
+    _this->cachePopulatorThread = std::thread([_this, t, pEvoDb]() {
         RenameThread("BZX-q-cachepop");
-        for (size_t i = 0; i < _this->members.size() && !_this->stopCachePopulatorThread && !ShutdownRequested(); i++) {
+        size_t i = 0;
+        for (; i < _this->members.size() && !_this->stopCachePopulatorThread && !ShutdownRequested(); i++) {
             if (_this->qc.validMembers[i]) {
                 _this->GetPubKeyShare(i);
             }
         }
+        if (i == _this->members.size()) {
+            // all shares are in blsCache by now, keep them for the next start
+            _this->WritePubKeyShares(*pEvoDb);
+        }
         LogPrint("llmq", "CQuorum::StartCachePopulatorThread -- done. time=%d\n", t.count());
     });
 }
@@ -158,10 +195,50 @@ void CQuorum::StartCachePopulatorThread(std::shared_ptr<CQuorum> _this)
 CQuorumManager::CQuorumManager(CEvoDB& _evoDb, CBLSWorker& _blsWorker, CDKGSessionManager& _dkgManager) :
     evoDb(_evoDb),
     blsWorker(_blsWorker),
-    dkgManager(_dkgManager)
+    dkgManager(_dkgManager),
+    stopCacheWarmerThread(false)
 {
 }
 
+void CQuorumManager::Start()
+{
+    if (cacheWarmerThread.joinable()) {
+        assert(false);
+    }
+    stopCacheWarmerThread = false;
+    cacheWarmerThread = std::thread(&TraceThread<std::function<void()> >, "q-warmer", std::function<void()>(std::bind(&CQuorumManager::WarmCaches, this)));
+}
+
+void CQuorumManager::Stop()
+{
+    stopCacheWarmerThread = true;
+    if (cacheWarmerThread.joinable()) {
+        cacheWarmerThread.join();
+    }
+}
+
+void CQuorumManager::WarmCaches()
+{
+    // load the quorums that verify signatures now instead of on the first signature after a restart, this reads their
+    // members, vvecs and public key shares from evoDb and recovers the shares that weren't written yet
+    cxxtimer::Timer t(true);
+    for (auto& p : Params().GetConsensus().llmqs) {
+        if (stopCacheWarmerThread || ShutdownRequested()) {
+            return;
+        }
+        const CBlockIndex* pindex;
+        {
+            LOCK(cs_main);
+            pindex = chainActive.Tip();
+        }
+        if (pindex == nullptr) {
+            return;
+        }
+        ScanQuorums(p.first, pindex, (size_t)p.second.signingActiveQuorumCount + 1);
+    }
+    LogPrint("llmq", "CQuorumManager::%s -- done. time=%d\n", __func__, t.count());
+}
+
 void CQuorumManager::UpdatedBlockTip(const CBlockIndex* pindexNew, bool fInitialDownload)
 {
     if (!masternodeSync.IsBlockchainSynced()) {
@@ -228,12 +305,30 @@ void CQuorumManager::EnsureQuorumConnections(Consensus::LLMQType llmqType, const
     }
 }
 
+std::vector<CDeterministicMNCPtr> CQuorumManager::GetQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum) const
+{
+    // the members only depend on the quorum block, so they can be kept forever. They are stored with their state at
+    // that block, which spares loading the masternode list of the block and scoring all its masternodes
+    auto dbKey = std::make_pair(DB_QUORUM_MEMBERS, std::make_pair((uint8_t)llmqType, pindexQuorum->GetBlockHash()));
+
+    std::vector<CDeterministicMNCPtr> members;
+    if (evoDb.Read(dbKey, members) && !members.empty()) {
+        return members;
+    }
+
+    members = CLLMQUtils::GetAllQuorumMembers(llmqType, pindexQuorum);
+    if (!members.empty()) {
+        evoDb.GetRawDB().Write(dbKey, members);
+    }
+    return members;
+}
+
 bool CQuorumManager::BuildQuorumFromCommitment(const CFinalCommitment& qc, const CBlockIndex* pindexQuorum, const uint256& minedBlockHash, std::shared_ptr<CQuorum>& quorum) const
 {
     assert(pindexQuorum);
     assert(qc.quorumHash == pindexQuorum->GetBlockHash());
 
-    auto members = CLLMQUtils::GetAllQuorumMembers((Consensus::LLMQType)qc.llmqType, pindexQuorum);
+    auto members = GetQuorumMembers((Consensus::LLMQType)qc.llmqType, pindexQuorum);
 
     quorum->Init(qc, pindexQuorum, minedBlockHash, members);
 
@@ -249,11 +344,11 @@ bool CQuorumManager::BuildQuorumFromCommitment(const CFinalCommitment& qc, const
         }
     }
 
-    if (hasValidVvec) {
+    if (hasValidVvec && !quorum->ReadPubKeyShares(evoDb)) {
         // pre-populate caches in the background
         // recovering public key shares is quite expensive and would result in serious lags for the first few signing
         // sessions if the shares would be calculated on-demand
-        CQuorum::StartCachePopulatorThread(quorum);
+        CQuorum::StartCachePopulatorThread(quorum, evoDb);
     }
 
     return true;
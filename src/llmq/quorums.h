@@ -47,8 +47,10 @@ public:
 
 private:
     // Recovery of public key shares is very slow, so we start a background thread that pre-populates a cache so that
-    // the public key shares are ready when needed later
+    // the public key shares are ready when needed later. Once all shares were recovered they are written to evoDb and
+    // later instances of the quorum read them into pubKeyShares, which is not changed after Init
     mutable CBLSWorkerCache blsCache;
+    std::vector<CBLSPublicKey> pubKeyShares;
     std::atomic<bool> stopCachePopulatorThread;
     std::thread cachePopulatorThread;
 
@@ -67,7 +69,9 @@ public:
 private:
     void WriteContributions(CEvoDB& evoDb);
     bool ReadContributions(CEvoDB& evoDb);
-    static void StartCachePopulatorThread(std::shared_ptr<CQuorum> _this);
+    void WritePubKeyShares(CEvoDB& evoDb) const;
+    bool ReadPubKeyShares(CEvoDB& evoDb);
+    static void StartCachePopulatorThread(std::shared_ptr<CQuorum> _this, CEvoDB& evoDb);
 };
 typedef std::shared_ptr<CQuorum> CQuorumPtr;
 typedef std::shared_ptr<const CQuorum> CQuorumCPtr;
@@ -77,6 +81,9 @@ typedef std::shared_ptr<const CQuorum> CQuorumCPtr;
  * it will lookup the commitment (through CQuorumBlockProcessor) and build a CQuorum object from it.
  *
  * It is also responsible for initialization of the inter-quorum connections for new quorums.
+ *
+ * Quorum members, the quorum verification vector and the public key shares are kept in evoDb, so after a restart
+ * quorums are rebuilt without recalculating them. Start() loads the active quorums in the background.
  */
 class CQuorumManager
 {
@@ -89,9 +96,15 @@ private:
     std::map<std::pair<Consensus::LLMQType, uint256>, CQuorumPtr> quorumsCache;
     unordered_lru_cache<std::pair<Consensus::LLMQType, uint256>, std::vector<CQuorumCPtr>, StaticSaltedHasher, 32> scanQuorumsCache;
 
+    std::thread cacheWarmerThread;
+    std::atomic<bool> stopCacheWarmerThread;
+
 public:
     CQuorumManager(CEvoDB& _evoDb, CBLSWorker& _blsWorker, CDKGSessionManager& _dkgManager);
 
+    void Start();
+    void Stop();
+
     void UpdatedBlockTip(const CBlockIndex *pindexNew, bool fInitialDownload);
 
     bool HasQuorum(Consensus::LLMQType llmqType, const uint256& quorumHash);
@@ -108,10 +121,13 @@ private:
     // all private methods here are cs_main-free
     void EnsureQuorumConnections(Consensus::LLMQType llmqType, const CBlockIndex *pindexNew);
 
+    std::vector<CDeterministicMNCPtr> GetQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum) const;
     bool BuildQuorumFromCommitment(const CFinalCommitment& qc, const CBlockIndex* pindexQuorum, const uint256& minedBlockHash, std::shared_ptr<CQuorum>& quorum) const;
     bool BuildQuorumContributions(const CFinalCommitment& fqc, std::shared_ptr<CQuorum>& quorum) const;
 
     CQuorumCPtr GetQuorum(Consensus::LLMQType llmqType, const CBlockIndex* pindex);
+
+    void WarmCaches();
 };
 
 extern CQuorumManager* quorumManager;
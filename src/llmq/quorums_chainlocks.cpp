@@ -10,12 +10,17 @@
 #include "evo/spork.h"
 
 #include "chain.h"
+#include "clientversion.h"
 #include "masternode-sync.h"
 #include "net_processing.h"
 #include "scheduler.h"
+#include "streams.h"
 #include "txmempool.h"
+#include "util.h"
 #include "validation.h"
 
+#include <algorithm>
+
 namespace llmq
 {
 
@@ -39,6 +44,7 @@ CChainLocksHandler::~CChainLocksHandler()
 
 void CChainLocksHandler::Start()
 {
+    LoadBlockTxs();
     {
         LOCK(cs_main);
         if (chainActive.Tip())
@@ -56,6 +62,7 @@ void CChainLocksHandler::Start()
 void CChainLocksHandler::Stop()
 {
     quorumSigningManager->UnregisterRecoveredSigsListener(this);
+    DumpBlockTxs();
 }
 
 bool CChainLocksHandler::AlreadyHave(const CInv& inv)
@@ -77,7 +84,7 @@ bool CChainLocksHandler::GetChainLockByHash(const uint256& hash, llmq::CChainLoc
     return true;
 }
 
-void CChainLocksHandler::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+void CChainLocksHandler::ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman)
 {
     if(!IsChainlocksEnabled())
         return;
@@ -320,7 +327,7 @@ void CChainLocksHandler::TrySignChainTip()
                     LOCK(cs);
                     auto it = txFirstSeenTime.find(txid);
                     if (it != txFirstSeenTime.end()) {
-                        txAge = GetAdjustedTime() - it->second;
+                        txAge = GetAdjustedTime() - it.value();
                     }
                 }
 
@@ -366,7 +373,7 @@ void CChainLocksHandler::SyncTransaction(const CTransaction& tx, const CBlockInd
                 return;
             }
             LOCK(cs);
-            txFirstSeenTime.emplace(tx.GetHash(), info.nTime);
+            txFirstSeenTime.insert(tx.GetHash(), info.nTime);
         }
         return;
     }
@@ -375,7 +382,7 @@ void CChainLocksHandler::SyncTransaction(const CTransaction& tx, const CBlockInd
 
     if (handleTx) {
         int64_t curTime = GetAdjustedTime();
-        txFirstSeenTime.emplace(tx.GetHash(), curTime);
+        txFirstSeenTime.insert(tx.GetHash(), curTime);
     }
 
     // We listen for SyncTransaction so that we can collect all TX ids of all included TXs of newly received blocks
@@ -385,7 +392,10 @@ void CChainLocksHandler::SyncTransaction(const CTransaction& tx, const CBlockInd
         auto it = blockTxs.find(pindex->GetBlockHash());
         if (it == blockTxs.end()) {
             // we want this to be run even if handleTx == false, so that the coinbase TX triggers creation of an empty entry
-            it = blockTxs.emplace(pindex->GetBlockHash(), std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>()).first;
+            if (!AddBlockTxs(pindex->GetBlockHash(), pindex->nHeight, std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>())) {
+                return;
+            }
+            it = blockTxs.find(pindex->GetBlockHash());
         }
         if (handleTx) {
             auto& txs = *it->second;
@@ -414,35 +424,140 @@ CChainLocksHandler::BlockTxs::mapped_type CChainLocksHandler::GetBlockTxs(const
         LogPrint("chainlocks", "CChainLocksHandler::%s -- blockTxs for %s not found. Trying ReadBlockFromDisk\n", __func__,
                  blockHash.ToString());
 
-        uint32_t blockTime;
+        CDiskBlockPos pos;
+        int nHeight;
         {
             LOCK(cs_main);
             auto pindex = mapBlockIndex.at(blockHash);
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
-                return nullptr;
-            }
+            pos = pindex->GetBlockPos();
+            nHeight = pindex->nHeight;
+        }
 
-            ret = std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>();
-            for (auto& tx : block.vtx) {
-                if (tx->IsCoinBase() || tx->vin.empty()) {
-                    continue;
-                }
-                ret->emplace(tx->GetHash());
-            }
+        // don't hold cs_main while reading from disk
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pos, nHeight, Params().GetConsensus()) || block.GetHash() != blockHash) {
+            return nullptr;
+        }
 
-            blockTime = block.nTime;
+        ret = std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>();
+        for (auto& tx : block.vtx) {
+            if (tx->IsCoinBase() || tx->vin.empty()) {
+                continue;
+            }
+            ret->emplace(tx->GetHash());
         }
 
         LOCK(cs);
-        blockTxs.emplace(blockHash, ret);
+        AddBlockTxs(blockHash, nHeight, ret);
         for (auto& txid : *ret) {
-            txFirstSeenTime.emplace(txid, blockTime);
+            txFirstSeenTime.insert(txid, block.nTime);
         }
     }
     return ret;
 }
 
+bool CChainLocksHandler::AddBlockTxs(const uint256& blockHash, int nHeight, const BlockTxs::mapped_type& txids)
+{
+    AssertLockHeld(cs);
+
+    // TrySignChainTip walks down from the tip, so the highest blocks are kept. Blocks read from disk for a deep
+    // walk must not push out the ones at the tip
+    if (blockTxsByHeight.size() >= BLOCK_TXS_RING_SIZE && nHeight <= blockTxsByHeight.begin()->first) {
+        return false;
+    }
+    if (!blockTxs.emplace(blockHash, txids).second) {
+        return true;
+    }
+    blockTxsByHeight.emplace(nHeight, blockHash);
+    while (blockTxsByHeight.size() > BLOCK_TXS_RING_SIZE) {
+        blockTxs.erase(blockTxsByHeight.begin()->second);
+        blockTxsByHeight.erase(blockTxsByHeight.begin());
+    }
+    return true;
+}
+
+void CChainLocksHandler::LoadBlockTxs()
+{
+    FILE* filestr = fopen((GetDataDir() / "chainlocks.dat").string().c_str(), "rb");
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return;
+    }
+
+    std::vector<std::pair<uint256, std::vector<uint256>>> blocks;
+    std::vector<std::pair<uint256, int64_t>> firstSeen;
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != BLOCK_TXS_DUMP_VERSION) {
+            return;
+        }
+        file >> blocks;
+        file >> firstSeen;
+    } catch (const std::exception& e) {
+        LogPrintf("CChainLocksHandler::%s -- failed to deserialize chainlocks data on disk: %s\n", __func__, e.what());
+        return;
+    }
+
+    LOCK2(cs_main, cs);
+
+    size_t loaded = 0;
+    for (auto& p : blocks) {
+        // only the active chain is walked when signing, ignore blocks that got reorged away while we were down
+        auto mi = mapBlockIndex.find(p.first);
+        if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second)) {
+            continue;
+        }
+        auto txids = std::make_shared<std::unordered_set<uint256, StaticSaltedHasher>>(p.second.begin(), p.second.end());
+        if (AddBlockTxs(p.first, mi->second->nHeight, txids)) {
+            loaded++;
+        }
+    }
+    for (auto& p : firstSeen) {
+        txFirstSeenTime.insert(p.first, p.second);
+    }
+
+    LogPrintf("CChainLocksHandler::%s -- loaded txids of %d recent blocks and %d first seen times\n", __func__, loaded, firstSeen.size());
+}
+
+void CChainLocksHandler::DumpBlockTxs()
+{
+    std::vector<std::pair<uint256, std::vector<uint256>>> blocks;
+    std::vector<std::pair<uint256, int64_t>> firstSeen;
+    {
+        LOCK(cs);
+        blocks.reserve(blockTxsByHeight.size());
+        for (auto& p : blockTxsByHeight) {
+            auto it = blockTxs.find(p.second);
+            if (it != blockTxs.end()) {
+                blocks.emplace_back(p.second, std::vector<uint256>(it->second->begin(), it->second->end()));
+            }
+        }
+        firstSeen.reserve(txFirstSeenTime.size());
+        for (auto it = txFirstSeenTime.begin(); it != txFirstSeenTime.end(); ++it) {
+            firstSeen.emplace_back(it.key(), it.value());
+        }
+    }
+
+    try {
+        FILE* filestr = fopen((GetDataDir() / "chainlocks.dat.new").string().c_str(), "wb");
+        if (!filestr) {
+            return;
+        }
+
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+        uint64_t version = BLOCK_TXS_DUMP_VERSION;
+        file << version;
+        file << blocks;
+        file << firstSeen;
+        FileCommit(file.Get());
+        file.fclose();
+        RenameOver(GetDataDir() / "chainlocks.dat.new", GetDataDir() / "chainlocks.dat");
+    } catch (const std::exception& e) {
+        LogPrintf("CChainLocksHandler::%s -- failed to dump chainlocks data: %s\n", __func__, e.what());
+    }
+}
+
 bool CChainLocksHandler::IsTxSafeForMining(const uint256& txid)
 {
     AssertLockHeld(cs_main);
@@ -462,7 +577,7 @@ bool CChainLocksHandler::IsTxSafeForMining(const uint256& txid)
         }
         auto it = txFirstSeenTime.find(txid);
         if (it != txFirstSeenTime.end()) {
-            txAge = GetAdjustedTime() - it->second;
+            txAge = GetAdjustedTime() - it.value();
         }
     }
 
@@ -706,22 +821,27 @@ void CChainLocksHandler::Cleanup()
             ++it;
         }
     }
-    for (auto it = txFirstSeenTime.begin(); it != txFirstSeenTime.end(); ) {
+    for (auto it = blockTxsByHeight.begin(); it != blockTxsByHeight.end(); ) {
+        if (blockTxs.count(it->second) == 0) {
+            it = blockTxsByHeight.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // erasing only marks the slot as deleted, so the iterator stays valid
+    for (auto it = txFirstSeenTime.begin(); it != txFirstSeenTime.end(); ++it) {
         CTransactionRef tx;
         uint256 hashBlock;
-        if (!GetTransaction(it->first, tx, Params().GetConsensus(), hashBlock)) {
+        if (!GetTransaction(it.key(), tx, Params().GetConsensus(), hashBlock)) {
             // tx has vanished, probably due to conflicts
-            it = txFirstSeenTime.erase(it);
+            txFirstSeenTime.erase(it);
         } else if (!hashBlock.IsNull()) {
             auto pindex = mapBlockIndex.at(hashBlock);
             if (chainActive.Tip()->GetAncestor(pindex->nHeight) == pindex && chainActive.Height() - pindex->nHeight >= 6) {
                 // tx got confirmed >= 6 times, so we can stop keeping track of it
-                it = txFirstSeenTime.erase(it);
-            } else {
-                ++it;
+                txFirstSeenTime.erase(it);
             }
-        } else {
-            ++it;
         }
     }
 
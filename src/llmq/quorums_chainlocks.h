@@ -10,8 +10,10 @@
 
 #include "net.h"
 #include "chainparams.h"
+#include "tagmap.h"
 
 #include <atomic>
+#include <set>
 #include <unordered_set>
 
 class CBlockIndex;
@@ -49,6 +51,10 @@ class CChainLocksHandler : public CRecoveredSigsListener
     // how long to wait for ixlocks until we consider a block with non-ixlocked TXs to be safe to sign
     static const int64_t WAIT_FOR_ISLOCK_TIMEOUT = 10 * 60;
 
+    // number of recent blocks for which we keep the txids
+    static const size_t BLOCK_TXS_RING_SIZE = 32;
+    static const uint64_t BLOCK_TXS_DUMP_VERSION = 1;
+
 private:
     CScheduler* scheduler;
     CCriticalSection cs;
@@ -70,7 +76,12 @@ private:
     // We keep track of txids from recently received blocks so that we can check if all TXs got ixlocked
     typedef std::unordered_map<uint256, std::shared_ptr<std::unordered_set<uint256, StaticSaltedHasher>>> BlockTxs;
     BlockTxs blockTxs;
-    std::unordered_map<uint256, int64_t> txFirstSeenTime;
+    // blocks of blockTxs by height, the lowest ones are dropped from blockTxs when there are more than
+    // BLOCK_TXS_RING_SIZE. Written to disk on shutdown together with txFirstSeenTime, so that we don't have to read
+    // the recent blocks from disk after a restart
+    std::set<std::pair<int, uint256>> blockTxsByHeight;
+    // looked up for every block template candidate
+    CTagMap<uint256, int64_t> txFirstSeenTime;
 
     std::map<uint256, int64_t> seenChainLocks;
 
@@ -88,7 +99,7 @@ public:
     bool AlreadyHave(const CInv& inv);
     bool GetChainLockByHash(const uint256& hash, CChainLockSig& ret);
 
-    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
+    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman);
     void ProcessNewChainLock(NodeId from, const CChainLockSig& clsig, const uint256& hash);
     void AcceptedBlockHeader(const CBlockIndex* pindexNew);
     void UpdatedBlockTip(const CBlockIndex* pindexNew);
@@ -113,6 +124,11 @@ private:
     void DoInvalidateBlock(const CBlockIndex* pindex, bool activateBestChain);
 
     BlockTxs::mapped_type GetBlockTxs(const uint256& blockHash);
+    // requires cs, returns false if the block is below all cached ones and the ring is full
+    bool AddBlockTxs(const uint256& blockHash, int nHeight, const BlockTxs::mapped_type& txids);
+
+    void LoadBlockTxs();
+    void DumpBlockTxs();
 
     void Cleanup();
 };
@@ -11,7 +11,7 @@
 
 #include <set>
 
-class CDataStream;
+#include "streams.h"
 class CInv;
 class CScheduler;
 
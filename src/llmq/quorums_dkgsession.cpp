@@ -351,9 +351,9 @@ void CDKGSession::ReceiveMessage(const uint256& hash, const CDKGContribution& qc
 }
 
 // Verifies all pending secret key contributions in one batch
-// This is done by aggregating the verification vectors belonging to the secret key contributions
+// This is done by aggregating the randomly weighted verification vectors belonging to the secret key contributions
 // The resulting aggregated vvec is then used to recover a public key share
-// The public key share must match the public key belonging to the aggregated secret key contributions
+// The public key share must match the equally weighted aggregation of the public keys of the secret key contributions
 // See CBLSWorker::VerifyContributionShares for more details.
 void CDKGSession::VerifyPendingContributions()
 {
@@ -22,10 +22,10 @@ CDKGPendingMessages::CDKGPendingMessages(size_t _maxMessagesPerNode) :
 {
 }
 
-void CDKGPendingMessages::PushPendingMessage(NodeId from, CDataStream& vRecv)
+void CDKGPendingMessages::PushPendingMessage(NodeId from, CPublicDataStream& vRecv)
 {
     // this will also consume the data, even if we bail out early
-    auto pm = std::make_shared<CDataStream>(std::move(vRecv));
+    auto pm = std::make_shared<CPublicDataStream>(std::move(vRecv));
 
     {
         LOCK(cs);
@@ -125,7 +125,7 @@ void CDKGSessionHandler::UpdatedBlockTip(const CBlockIndex* pindexNew)
     }
 }
 
-void CDKGSessionHandler::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+void CDKGSessionHandler::ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman)
 {
     // We don't handle messages in the calling thread as deserialization/processing of these would block everything
     if (strCommand == NetMsgType::QCONTRIB) {
@@ -36,7 +36,7 @@ enum QuorumPhase {
 class CDKGPendingMessages
 {
 public:
-    typedef std::pair<NodeId, std::shared_ptr<CDataStream>> BinaryMessage;
+    typedef std::pair<NodeId, std::shared_ptr<CPublicDataStream>> BinaryMessage;
 
 private:
     mutable CCriticalSection cs;
@@ -48,7 +48,7 @@ private:
 public:
     CDKGPendingMessages(size_t _maxMessagesPerNode);
 
-    void PushPendingMessage(NodeId from, CDataStream& vRecv);
+    void PushPendingMessage(NodeId from, CPublicDataStream& vRecv);
     std::list<BinaryMessage> PopPendingMessages(size_t maxCount);
     bool HasSeen(const uint256& hash) const;
     void Clear();
@@ -56,7 +56,7 @@ public:
     template<typename Message>
     void PushPendingMessage(NodeId from, Message& msg)
     {
-        CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+        CPublicDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
         ds << msg;
         PushPendingMessage(from, ds);
     }
@@ -122,7 +122,7 @@ public:
     ~CDKGSessionHandler();
 
     void UpdatedBlockTip(const CBlockIndex *pindexNew);
-    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
+    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman);
 
 private:
     bool InitNewQuorum(const CBlockIndex* pindexQuorum);
@@ -70,6 +70,9 @@ void StartLLMQSystem()
     if (blsWorker) {
         blsWorker->Start();
     }
+    if (quorumManager) {
+        quorumManager->Start();
+    }
     if (quorumDKGSessionManager) {
         quorumDKGSessionManager->StartMessageHandlerPool();
     }
@@ -100,6 +103,9 @@ void StopLLMQSystem()
     if (quorumDKGSessionManager) {
         quorumDKGSessionManager->StopMessageHandlerPool();
     }
+    if (quorumManager) {
+        quorumManager->Stop();
+    }
     if (blsWorker) {
         blsWorker->Stop();
     }
@@ -699,7 +699,7 @@ void CInstantSendManager::HandleNewInstantSendLockRecoveredSig(const llmq::CReco
     ProcessInstantSendLock(-1, ::SerializeHash(islock), islock);
 }
 
-void CInstantSendManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+void CInstantSendManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman)
 {
     if (!IsNewInstantSendEnabled()) {
         return;
@@ -1582,9 +1582,9 @@ CTransaction AdaptJsplitTx(CTransaction const & tx)
     static size_t const jsplitSerialSize = 32;
 
     CTransaction result{tx};
-    std::unique_ptr <lelantus::JoinSplit> jsplit;
+    std::shared_ptr<const lelantus::JoinSplit> jsplit;
     try {
-        jsplit = lelantus::ParseLelantusJoinSplit(tx);
+        jsplit = lelantus::GetParsedLelantusJoinSplit(tx);
     }
     catch (...) {
         return result;
@@ -1608,9 +1608,9 @@ CTransaction AdaptSparkTx(CTransaction const & tx)
     static size_t const lTagSerialSize = 34;
 
     CTransaction result{tx};
-    std::unique_ptr<spark::SpendTransaction> spend;
+    std::shared_ptr<const spark::SpendTransaction> spend;
     try {
-        spend = std::make_unique<spark::SpendTransaction>(spark::ParseSparkSpend(tx));
+        spend = spark::GetParsedSparkSpend(tx);
     }
     catch (...) {
         return result;
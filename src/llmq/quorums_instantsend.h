@@ -132,7 +132,7 @@ public:
     void UpdatedBlockTip(const CBlockIndex* pindexNew);
 
     void NotifyChainLock(const CBlockIndex* pindexChainLock);
-    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
+    void ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman);
     size_t GetInstantSendLockCount();
     bool AlreadyHave(const CInv& inv);
 
@@ -191,7 +191,7 @@ bool CRecoveredSigsDb::ReadRecoveredSig(Consensus::LLMQType llmqType, const uint
 {
     auto k = std::make_tuple(std::string("rs_r"), (uint8_t)llmqType, id);
 
-    CDataStream ds(SER_DISK, CLIENT_VERSION);
+    CPublicDataStream ds(SER_DISK, CLIENT_VERSION);
     if (!db.ReadDataStream(k, ds)) {
         return false;
     }
@@ -280,7 +280,7 @@ void CRecoveredSigsDb::RemoveRecoveredSig(CDBBatch& batch, Consensus::LLMQType l
     batch.Erase(k4);
 
     if (deleteTimeKey) {
-        CDataStream writeTimeDs(SER_DISK, CLIENT_VERSION);
+        CPublicDataStream writeTimeDs(SER_DISK, CLIENT_VERSION);
         // TODO remove the size() == sizeof(uint32_t) in a future version (when we stop supporting upgrades from < 0.14.1)
         if (db.ReadDataStream(k2, writeTimeDs) && writeTimeDs.size() == sizeof(uint32_t)) {
             uint32_t writeTime;
@@ -447,7 +447,7 @@ bool CSigningManager::GetRecoveredSigForGetData(const uint256& hash, CRecoveredS
     return true;
 }
 
-void CSigningManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+void CSigningManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman)
 {
     if (strCommand == NetMsgType::QSIGREC) {
         CRecoveredSig recoveredSig;
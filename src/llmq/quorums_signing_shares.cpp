@@ -11,6 +11,7 @@
 #include "init.h"
 #include "net_processing.h"
 #include "netmessagemaker.h"
+#include "perfstats.h"
 #include "validation.h"
 
 #include "cxxtimer.hpp"
@@ -230,7 +231,7 @@ void CSigSharesManager::InterruptWorkerThread()
     workInterrupt();
 }
 
-void CSigSharesManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+void CSigSharesManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, CConnman& connman)
 {
     // non-masternodes are not interested in sigshares
     if (!fMasternodeMode || activeMasternodeInfo.proTxHash.IsNull()) {
@@ -572,6 +573,8 @@ void CSigSharesManager::CollectPendingSigSharesToVerify(
 
 bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
 {
+    PERF_SCOPE("llmq_process_sig_shares");
+
     std::unordered_map<NodeId, std::vector<CSigShare>> sigSharesByNodes;
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher> quorums;
 
@@ -1379,6 +1382,8 @@ void CSigSharesManager::AsyncSign(const CQuorumCPtr& quorum, const uint256& id,
 
 bool CSigSharesManager::SignPendingSigShares()
 {
+    PERF_SCOPE("llmq_sign_sig_shares");
+
     std::vector<std::tuple<const CQuorumCPtr, uint256, uint256>> v;
     {
         LOCK(cs);
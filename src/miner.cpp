@@ -16,6 +16,7 @@
 #include "base58.h"
 #include "validation.h"
 #include "net.h"
+#include "perfstats.h"
 #include "policy/policy.h"
 #include "pow.h"
 #include "primitives/transaction.h"
@@ -143,6 +144,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 {
     // Create new block
     LogPrintf("BlockAssembler::CreateNewBlock()\n");
+    PERF_SCOPE("miner_create_new_block");
 
     int64_t nTimeStart = GetTimeMicros();
 
@@ -272,6 +274,155 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     return std::move(pblocktemplate);
 }
 
+// The masternode list merkle root in the coinbase of a template covers special transactions and spent collateral,
+// other transactions can be added to or removed from a finished template
+static bool IsNeutralForMNList(const CTransaction& tx, const CDeterministicMNList& mnList)
+{
+    if (tx.nVersion == 3 && tx.nType != TRANSACTION_NORMAL && tx.nType != TRANSACTION_LELANTUS && tx.nType != TRANSACTION_SPARK)
+        return false;
+    for (const CTxIn& in : tx.vin) {
+        if (mnList.HasMNByCollateral(in.prevout))
+            return false;
+    }
+    return true;
+}
+
+static void UpdateCoinbaseFees(CBlockTemplate& blocktemplate, CAmount nFees)
+{
+    CAmount nFeesOld = -blocktemplate.vTxFees[0];
+    CMutableTransaction coinbaseTx(*blocktemplate.block.vtx[0]);
+    coinbaseTx.vout[0].nValue += nFees - nFeesOld;
+    blocktemplate.block.vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+    blocktemplate.vTxFees[0] = -nFees;
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::AddToTemplate(const CBlockTemplate& blocktemplate, const CBlockIndex* pindexPrev,
+        const CDeterministicMNList& mnList, const std::vector<uint256>& vHashes, bool& fRebuild)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(mempool.cs);
+
+    // FillBlackListForBlockTemplate restricts transactions under active sporks, leave that to a full build
+    if (!pindexPrev->activeDisablingSporks.empty()) {
+        fRebuild = true;
+        return nullptr;
+    }
+
+    resetBlock();
+    pblocktemplate.reset(new CBlockTemplate(blocktemplate));
+    pblock = &pblocktemplate->block;
+    nHeight = pindexPrev->nHeight + 1;
+    nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
+                       ? pindexPrev->GetMedianTimePast()
+                       : pblock->GetBlockTime();
+
+    // Pick up the state of the finished block
+    bool fHasProRegTx = false;
+    const auto &params = chainparams.GetConsensus();
+    for (size_t i = 1; i < pblock->vtx.size(); i++) {
+        const CTransaction &tx = *pblock->vtx[i];
+        nBlockSize += GetTransactionWeight(tx);
+        if (fNeedSizeAccounting)
+            nBlockSize += ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
+        nBlockSigOpsCost += pblocktemplate->vTxSigOpsCost[i];
+        nFees += pblocktemplate->vTxFees[i];
+        ++nBlockTx;
+        fHasProRegTx |= tx.nVersion == 3 && tx.nType == TRANSACTION_PROVIDER_REGISTER;
+        if (tx.nVersion == 3 && tx.nType == TRANSACTION_QUORUM_COMMITMENT)
+            continue;
+
+        CTxMemPool::txiter iter = mempool.mapTx.find(tx.GetHash());
+        if (iter == mempool.mapTx.end()) {
+            // removed from the mempool since, the caller didn't take it out of the template yet
+            fRebuild = true;
+            return nullptr;
+        }
+        inBlock.insert(iter);
+
+        const CPrivateSpendInfo *info = iter->GetPrivateSpendInfo();
+        if (tx.IsLelantusJoinSplit()) {
+            nLelantusSpendAmount += info ? info->nTransparentAmount : lelantus::GetSpendTransparentAmount(tx);
+            nLelantusSpendInputs += info ? info->GetInputCount() : lelantus::GetSpendInputs(tx);
+        }
+        if (tx.IsSparkSpend())
+            nSparkSpendAmount += info ? info->nTransparentAmount : spark::GetSpendTransparentAmount(tx);
+    }
+    const size_t nTxBefore = pblock->vtx.size();
+
+    for (const uint256& hash : vHashes) {
+        CTxMemPool::txiter iter = mempool.mapTx.find(hash);
+        if (iter == mempool.mapTx.end() || inBlock.count(iter))
+            continue;
+        const CTransaction &tx = iter->GetTx();
+
+        // Same cutoff as addPackageTxs, all unconfirmed ancestors are in the block already
+        if (iter->GetModifiedFee() < blockMinFeeRate.GetFee(iter->GetTxSize()))
+            continue;
+
+        // Transactions depending on spends in the mempool are never included together with them
+        bool fMissingParent = false;
+        bool fSpendParent = false;
+        BOOST_FOREACH(CTxMemPool::txiter parent, mempool.GetMemPoolParents(iter))
+        {
+            fMissingParent |= !inBlock.count(parent);
+            fSpendParent |= parent->GetTx().IsLelantusJoinSplit() || parent->GetTx().IsSparkSpend();
+        }
+        if (fSpendParent)
+            continue;
+
+        // ProRegTx collateral rules depend on the whole mempool, so do the special transactions
+        if (fMissingParent || fHasProRegTx || !IsNeutralForMNList(tx, mnList) || !TestForBlock(iter) ||
+                !llmq::chainLocksHandler->IsTxSafeForMining(hash)) {
+            fRebuild = true;
+            continue;
+        }
+
+        AddToBlock(iter);
+    }
+
+    if (pblock->vtx.size() == nTxBefore)
+        return nullptr;
+
+    UpdateCoinbaseFees(*pblocktemplate, nFees);
+    return std::move(pblocktemplate);
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::RemoveFromTemplate(const CBlockTemplate& blocktemplate, const CDeterministicMNList& mnList,
+        const std::set<uint256>& setHashes)
+{
+    std::unique_ptr<CBlockTemplate> pblocktemplateNew(new CBlockTemplate(blocktemplate));
+    CBlockTemplate& result = *pblocktemplateNew;
+    std::set<uint256> setRemoved(setHashes);
+    CAmount nFees = -blocktemplate.vTxFees[0];
+
+    // Spending transactions follow the ones they spend, one pass finds all of them
+    size_t nKept = 1;
+    for (size_t i = 1; i < result.block.vtx.size(); i++) {
+        const CTransaction &tx = *result.block.vtx[i];
+        bool fRemove = setRemoved.count(tx.GetHash()) > 0;
+        for (const CTxIn& in : tx.vin)
+            fRemove |= setRemoved.count(in.prevout.hash) > 0;
+
+        if (!fRemove) {
+            result.block.vtx[nKept] = result.block.vtx[i];
+            result.vTxFees[nKept] = result.vTxFees[i];
+            result.vTxSigOpsCost[nKept] = result.vTxSigOpsCost[i];
+            nKept++;
+            continue;
+        }
+        if (!IsNeutralForMNList(tx, mnList))
+            return nullptr;
+        setRemoved.insert(tx.GetHash());
+        nFees -= result.vTxFees[i];
+    }
+
+    result.block.vtx.resize(nKept);
+    result.vTxFees.resize(nKept);
+    result.vTxSigOpsCost.resize(nKept);
+    UpdateCoinbaseFees(result, nFees);
+    return pblocktemplateNew;
+}
+
 bool BlockAssembler::isStillDependent(CTxMemPool::txiter iter)
 {
     BOOST_FOREACH(CTxMemPool::txiter parent, mempool.GetMemPoolParents(iter))
@@ -375,8 +526,9 @@ bool BlockAssembler::TestForBlock(CTxMemPool::txiter iter)
 
     // Check transaction against lelantus limits
     if(tx.IsLelantusJoinSplit()) {
-        CAmount spendAmount = lelantus::GetSpendTransparentAmount(tx);
-        size_t spendNumber = lelantus::GetSpendInputs(tx);
+        const CPrivateSpendInfo *info = iter->GetPrivateSpendInfo();
+        CAmount spendAmount = info ? info->nTransparentAmount : lelantus::GetSpendTransparentAmount(tx);
+        size_t spendNumber = info ? info->GetInputCount() : lelantus::GetSpendInputs(tx);
         const auto &params = chainparams.GetConsensus();
 
         if (spendNumber > params.nMaxLelantusInputPerTransaction || spendAmount > params.nMaxValueLelantusSpendPerTransaction)
@@ -391,7 +543,8 @@ bool BlockAssembler::TestForBlock(CTxMemPool::txiter iter)
 
     // Check transaction against spark limits
     if(tx.IsSparkSpend()) {
-        CAmount spendAmount = spark::GetSpendTransparentAmount(tx);
+        const CPrivateSpendInfo *info = iter->GetPrivateSpendInfo();
+        CAmount spendAmount = info ? info->nTransparentAmount : spark::GetSpendTransparentAmount(tx);
         const auto &params = chainparams.GetConsensus();
 
         if (spendAmount > params.nMaxValueSparkSpendPerTransaction)
@@ -407,9 +560,10 @@ bool BlockAssembler::TestForBlock(CTxMemPool::txiter iter)
 void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
 {
     const CTransaction &tx = iter->GetTx();
+    const CPrivateSpendInfo *info = iter->GetPrivateSpendInfo();
     if(tx.IsLelantusJoinSplit()) {
-        CAmount spendAmount = lelantus::GetSpendTransparentAmount(tx);
-        size_t spendNumber = lelantus::GetSpendInputs(tx);
+        CAmount spendAmount = info ? info->nTransparentAmount : lelantus::GetSpendTransparentAmount(tx);
+        size_t spendNumber = info ? info->GetInputCount() : lelantus::GetSpendInputs(tx);
         const auto &params = chainparams.GetConsensus();
 
         if (spendAmount > params.nMaxValueLelantusSpendPerTransaction)
@@ -423,7 +577,7 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     }
 
     if(tx.IsSparkSpend()) {
-        CAmount spendAmount = spark::GetSpendTransparentAmount(tx);
+        CAmount spendAmount = info ? info->nTransparentAmount : spark::GetSpendTransparentAmount(tx);
         const auto &params = chainparams.GetConsensus();
 
         if (spendAmount > params.nMaxValueSparkSpendPerTransaction)
@@ -16,6 +16,7 @@
 
 class CBlockIndex;
 class CChainParams;
+class CDeterministicMNList;
 class CReserveKey;
 class CScript;
 class CWallet;
@@ -184,6 +185,27 @@ public:
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn);
 
+    /**
+     * Add mempool transactions to a copy of a template CreateNewBlock made on
+     * pindexPrev without going through the whole mempool again. Only
+     * transactions whose unconfirmed parents are in the template already and
+     * which can't affect the other transactions or the coinbase payload are
+     * added, with the same limit checks as in CreateNewBlock. fRebuild is set
+     * if a transaction was left out which a full build might include.
+     * Returns nullptr if nothing was added.
+     * Must be called with cs_main and mempool.cs held.
+     */
+    std::unique_ptr<CBlockTemplate> AddToTemplate(const CBlockTemplate& blocktemplate, const CBlockIndex* pindexPrev,
+                                                  const CDeterministicMNList& mnList, const std::vector<uint256>& vHashes, bool& fRebuild);
+
+    /**
+     * Copy of a template without the given transactions and the ones spending
+     * them. Returns nullptr if that would change the masternode list the
+     * coinbase commits to, the template has to be built again then.
+     */
+    static std::unique_ptr<CBlockTemplate> RemoveFromTemplate(const CBlockTemplate& blocktemplate, const CDeterministicMNList& mnList,
+                                                              const std::set<uint256>& setHashes);
+
 private:
     // utility functions
     /** Clear the block's state and prepare for assembling a new block */
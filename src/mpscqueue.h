@@ -0,0 +1,101 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_MPSCQUEUE_H
+#define BZX_MPSCQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Bounded lock-free queue for many producers and a single consumer.
+ *
+ * Every slot carries a sequence number telling whether it is free for the
+ * producer claiming position pos (sequence == pos) or holds an element for
+ * the consumer (sequence == pos + 1). Producers claim positions with a CAS
+ * on the enqueue position and never wait, a full queue makes TryPush fail.
+ * TryPop must only ever be called from one thread at a time.
+ */
+template <typename T>
+class CMPSCQueue
+{
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    const size_t mask;
+
+    // keep the positions on their own cache lines, producers hammer the first one
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) size_t dequeuePos;
+
+    static size_t RoundUpToPowerOfTwo(size_t n)
+    {
+        size_t r = 2;
+        while (r < n)
+            r <<= 1;
+        return r;
+    }
+
+public:
+    explicit CMPSCQueue(size_t nCapacity) :
+        slots(new Slot[RoundUpToPowerOfTwo(nCapacity)]),
+        mask(RoundUpToPowerOfTwo(nCapacity) - 1),
+        enqueuePos(0),
+        dequeuePos(0)
+    {
+        for (size_t i = 0; i <= mask; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    CMPSCQueue(const CMPSCQueue&) = delete;
+    CMPSCQueue& operator=(const CMPSCQueue&) = delete;
+
+    size_t Capacity() const { return mask + 1; }
+
+    //! Add value to the queue, returns false without touching value if the queue is full
+    bool TryPush(T&& value)
+    {
+        Slot* slot;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            slot = &slots[pos & mask];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                // the consumer hasn't freed this slot yet
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->data = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Take the oldest element, returns false if there is none (single consumer only)
+    bool TryPop(T& value)
+    {
+        Slot* slot = &slots[dequeuePos & mask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(dequeuePos + 1) < 0)
+            return false;
+        value = std::move(slot->data);
+        slot->sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+};
+
+#endif // BZX_MPSCQUEUE_H
@@ -20,6 +20,7 @@
 #include "sync.h"
 #include "uint256.h"
 #include "threadinterrupt.h"
+#include "timerwheel.h"
 #include "util.h"
 #include "consensus/params.h"
 
@@ -670,11 +671,11 @@ private:
 public:
     bool in_data;                   // parsing header (false) or data (true)
 
-    CDataStream hdrbuf;             // partially received header
+    CPublicDataStream hdrbuf;       // partially received header
     CMessageHeader hdr;             // complete header
     unsigned int nHdrPos;
 
-    CDataStream vRecv;              // received message data
+    CPublicDataStream vRecv;        // received message data
     unsigned int nDataPos;
 
     int64_t nTime;                  // time (in microseconds) of message receipt.
@@ -1022,8 +1023,8 @@ public:
     // in case of no limit, it will always response 0
     static uint64_t GetMaxOutboundTimeLeftInCycle();
 
-    // Public Dandelion field.
-    static std::map<uint256, int64_t> mDandelionEmbargo;
+    // Public Dandelion field, embargo timers of the transactions we stemmed.
+    static CTimerWheel timerDandelionEmbargo;
 
     // Dandelion methods, they all must be static, as they do not belong to any CNode, they belong
 		// to the currently running node.
@@ -8,6 +8,7 @@
 #include "addrman.h"
 #include "arith_uint256.h"
 #include "blockencodings.h"
+#include "blockfilterindex.h"
 #include "chainparams.h"
 #include "consensus/validation.h"
 #include "hash.h"
@@ -17,6 +18,7 @@
 #include "net.h"
 #include "netmessagemaker.h"
 #include "netbase.h"
+#include "perfstats.h"
 #include "policy/fees.h"
 #include "policy/policy.h"
 #include "primitives/block.h"
@@ -1143,7 +1145,7 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                 // Send stream from relay memory
                 bool pushed = false;
                 {
-                    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+                    CPublicDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
                     auto mi = mapRelay.find(inv.hash);
                     if (mi != mapRelay.end()) {
                         ss << (*mi).second;
@@ -1256,14 +1258,154 @@ inline void static SendBlockTransactions(const CBlock& block, const BlockTransac
     connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCKTXN, resp));
 }
 
-bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
+/**
+ * Validate that the filter request can be served, and find the stop block.
+ * Peers asking for filters we don't advertise, or for blocks outside of the
+ * active chain, are disconnected as described by BIP 157.
+ */
+static bool PrepareBlockFilterRequest(CNode* pfrom, BlockFilterType filterType, uint32_t startHeight,
+                                      const uint256& stopHash, uint32_t maxHeightDiff, const CBlockIndex*& stopIndex)
 {
-    LogPrint("net", "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->id);
+    if (!(pfrom->GetLocalServices() & NODE_COMPACT_FILTERS) || !pblockfilterindex ||
+        pblockfilterindex->GetFilterType() != filterType) {
+        LogPrint("net", "peer %d requested unsupported block filter type: %d\n", pfrom->id, static_cast<uint8_t>(filterType));
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
     {
         LOCK(cs_main);
-        CNode::CheckDandelionEmbargoes();
+        BlockMap::const_iterator it = mapBlockIndex.find(stopHash);
+        stopIndex = it != mapBlockIndex.end() ? it->second : nullptr;
+        if (!stopIndex || !chainActive.Contains(stopIndex)) {
+            LogPrint("net", "peer %d requested invalid block hash: %s\n", pfrom->id, stopHash.ToString());
+            pfrom->fDisconnect = true;
+            return false;
+        }
+    }
+
+    uint32_t stopHeight = stopIndex->nHeight;
+    if (startHeight > stopHeight) {
+        LogPrint("net", "peer %d sent invalid getcfilters/getcfheaders with start height %d and stop height %d\n",
+                 pfrom->id, startHeight, stopHeight);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+    if (stopHeight - startHeight >= maxHeightDiff) {
+        LogPrint("net", "peer %d requested too many cfilters/cfheaders: %d / %d\n",
+                 pfrom->id, stopHeight - startHeight + 1, maxHeightDiff);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    return true;
+}
+
+static void ProcessGetCFilters(CNode* pfrom, CPublicDataStream& vRecv, CConnman& connman)
+{
+    uint8_t filterTypeSer;
+    uint32_t startHeight;
+    uint256 stopHash;
+    vRecv >> filterTypeSer >> startHeight >> stopHash;
+
+    const BlockFilterType filterType = static_cast<BlockFilterType>(filterTypeSer);
+
+    const CBlockIndex* stopIndex;
+    if (!PrepareBlockFilterRequest(pfrom, filterType, startHeight, stopHash, MAX_GETCFILTERS_SIZE, stopIndex))
+        return;
+
+    std::vector<BlockFilter> filters;
+    if (!pblockfilterindex->LookupFilterRange(startHeight, stopIndex, filters)) {
+        LogPrint("net", "Failed to find block filter in index: filter_type=%s, start_height=%d, stop_hash=%s\n",
+                 BlockFilterTypeName(filterType), startHeight, stopHash.ToString());
+        return;
+    }
+
+    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    for (const BlockFilter& filter : filters) {
+        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::CFILTER, filter));
+    }
+}
+
+static void ProcessGetCFHeaders(CNode* pfrom, CPublicDataStream& vRecv, CConnman& connman)
+{
+    uint8_t filterTypeSer;
+    uint32_t startHeight;
+    uint256 stopHash;
+    vRecv >> filterTypeSer >> startHeight >> stopHash;
+
+    const BlockFilterType filterType = static_cast<BlockFilterType>(filterTypeSer);
+
+    const CBlockIndex* stopIndex;
+    if (!PrepareBlockFilterRequest(pfrom, filterType, startHeight, stopHash, MAX_GETCFHEADERS_SIZE, stopIndex))
+        return;
+
+    uint256 prevHeader;
+    if (startHeight > 0) {
+        const CBlockIndex* prevBlock = stopIndex->GetAncestor(static_cast<int>(startHeight - 1));
+        if (!pblockfilterindex->LookupFilterHeader(prevBlock, prevHeader)) {
+            LogPrint("net", "Failed to find block filter header in index: filter_type=%s, block_hash=%s\n",
+                     BlockFilterTypeName(filterType), prevBlock->GetBlockHash().ToString());
+            return;
+        }
     }
 
+    std::vector<uint256> filterHashes;
+    if (!pblockfilterindex->LookupFilterHashRange(startHeight, stopIndex, filterHashes)) {
+        LogPrint("net", "Failed to find block filter hashes in index: filter_type=%s, start_height=%d, stop_hash=%s\n",
+                 BlockFilterTypeName(filterType), startHeight, stopHash.ToString());
+        return;
+    }
+
+    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::CFHEADERS,
+                                             filterTypeSer,
+                                             stopIndex->GetBlockHash(),
+                                             prevHeader,
+                                             filterHashes));
+}
+
+static void ProcessGetCFCheckPt(CNode* pfrom, CPublicDataStream& vRecv, CConnman& connman)
+{
+    uint8_t filterTypeSer;
+    uint256 stopHash;
+    vRecv >> filterTypeSer >> stopHash;
+
+    const BlockFilterType filterType = static_cast<BlockFilterType>(filterTypeSer);
+
+    const CBlockIndex* stopIndex;
+    if (!PrepareBlockFilterRequest(pfrom, filterType, /*startHeight=*/0, stopHash,
+                                   /*maxHeightDiff=*/std::numeric_limits<uint32_t>::max(), stopIndex))
+        return;
+
+    std::vector<uint256> headers(stopIndex->nHeight / CFCHECKPT_INTERVAL);
+
+    // Populate headers.
+    const CBlockIndex* blockIndex = stopIndex;
+    for (int i = headers.size() - 1; i >= 0; i--) {
+        int height = (i + 1) * CFCHECKPT_INTERVAL;
+        blockIndex = blockIndex->GetAncestor(height);
+
+        if (!pblockfilterindex->LookupFilterHeader(blockIndex, headers[i])) {
+            LogPrint("net", "Failed to find block filter header in index: filter_type=%s, block_hash=%s\n",
+                     BlockFilterTypeName(filterType), blockIndex->GetBlockHash().ToString());
+            return;
+        }
+    }
+
+    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::CFCHECKPT,
+                                             filterTypeSer,
+                                             stopIndex->GetBlockHash(),
+                                             headers));
+}
+
+bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CPublicDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
+{
+    LogPrint("net", "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->id);
+    // only takes cs_main when an embargo expired
+    CNode::CheckDandelionEmbargoes();
+
     if (strCommand == NetMsgType::REJECT)
     {
         if (fDebug) {
@@ -1857,6 +1999,24 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     }
 
 
+    else if (strCommand == NetMsgType::GETCFILTERS)
+    {
+        ProcessGetCFilters(pfrom, vRecv, connman);
+    }
+
+
+    else if (strCommand == NetMsgType::GETCFHEADERS)
+    {
+        ProcessGetCFHeaders(pfrom, vRecv, connman);
+    }
+
+
+    else if (strCommand == NetMsgType::GETCFCHECKPT)
+    {
+        ProcessGetCFCheckPt(pfrom, vRecv, connman);
+    }
+
+
     else if (strCommand == NetMsgType::GETHEADERS)
     {
         CBlockLocator locator;
@@ -2238,12 +2398,12 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         // dummy (empty) BLOCKTXN message, to re-use the logic there in
         // completing processing of the putative block (without cs_main).
         bool fProcessBLOCKTXN = false;
-        CDataStream blockTxnMsg(SER_NETWORK, PROTOCOL_VERSION);
+        CPublicDataStream blockTxnMsg(SER_NETWORK, PROTOCOL_VERSION);
 
         // If we end up treating this as a plain headers message, call that as well
         // without cs_main.
         bool fRevertToHeaderProcessing = false;
-        CDataStream vHeadersMsg(SER_NETWORK, PROTOCOL_VERSION);
+        CPublicDataStream vHeadersMsg(SER_NETWORK, PROTOCOL_VERSION);
 
         // Keep a CBlock for "optimistic" compactblock reconstructions (see
         // below)
@@ -2861,6 +3021,25 @@ static bool SendRejectsAndCheckIfBanned(CNode* pnode, CConnman& connman)
     return false;
 }
 
+/** Histogram timing the processing of messages of type strCommand, unknown types share one */
+static CPerfHistogram& GetMessageHistogram(const std::string& strCommand)
+{
+    static const std::map<std::string, CPerfHistogram*> mapHistograms = [] {
+        std::map<std::string, CPerfHistogram*> mapResult;
+        for (const std::string& strType : getAllNetMessageTypes()) {
+            std::string strName = "net_process_message_";
+            for (char c : strType)
+                strName += (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ? c : '_';
+            mapResult[strType] = &GetPerfHistogram(strName);
+        }
+        return mapResult;
+    }();
+    static CPerfHistogram& histogramOther = GetPerfHistogram("net_process_message_other");
+
+    auto it = mapHistograms.find(strCommand);
+    return it != mapHistograms.end() ? *it->second : histogramOther;
+}
+
 bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -2921,7 +3100,7 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
         unsigned int nMessageSize = hdr.nMessageSize;
 
         // Checksum
-        CDataStream& vRecv = msg.vRecv;
+        CPublicDataStream& vRecv = msg.vRecv;
         const uint256& hash = msg.GetMessageHash();
         if (memcmp(hash.begin(), hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) != 0)
         {
@@ -2936,6 +3115,7 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
         bool fRet = false;
         try
         {
+            CPerfTimer perfTimer(GetMessageHistogram(strCommand));
             fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
             if (interruptMsgProc)
                 return false;
@@ -0,0 +1,180 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "perfstats.h"
+
+#include "tinyformat.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+std::atomic<bool> fPerfStats(DEFAULT_PERFSTATS);
+
+namespace {
+
+std::mutex cs_perfstats;
+std::map<std::string, std::unique_ptr<CPerfHistogram>> mapHistograms;
+std::map<std::string, std::unique_ptr<CPerfCounter>> mapCounters;
+
+//! Bucket bounds of the Prometheus histograms, in microseconds
+const uint64_t PROMETHEUS_BUCKETS[] = {10, 100, 1000, 10000, 100000, 1000000, 10000000};
+
+int HighestBit(uint64_t n)
+{
+    int nBit = 0;
+    while (n >>= 1)
+        nBit++;
+    return nBit;
+}
+
+} // anon namespace
+
+uint64_t CPerfHistogramSnapshot::Percentile(double fraction) const
+{
+    if (nCount == 0)
+        return 0;
+    uint64_t nRank = std::max<uint64_t>(1, (uint64_t)(fraction * nCount + 0.5));
+    uint64_t nSeen = 0;
+    for (size_t i = 0; i < vBuckets.size(); i++) {
+        nSeen += vBuckets[i];
+        if (nSeen >= nRank)
+            return std::min(CPerfHistogram::GetBucketHigh(i), nMax);
+    }
+    return nMax;
+}
+
+uint64_t CPerfHistogramSnapshot::CountUpTo(uint64_t nValue) const
+{
+    uint64_t n = 0;
+    for (size_t i = 0; i < vBuckets.size() && CPerfHistogram::GetBucketHigh(i) <= nValue; i++)
+        n += vBuckets[i];
+    return n;
+}
+
+CPerfHistogram::CPerfHistogram()
+{
+    Reset();
+}
+
+int CPerfHistogram::GetBucket(uint64_t nValue)
+{
+    if (nValue < (uint64_t)SUB_BUCKETS)
+        return nValue;
+    int nExponent = HighestBit(nValue);
+    if (nExponent > MAX_EXPONENT)
+        return BUCKETS - 1;
+    int nSubBucket = (nValue >> (nExponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (nExponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + nSubBucket;
+}
+
+uint64_t CPerfHistogram::GetBucketLow(int nBucket)
+{
+    if (nBucket < SUB_BUCKETS)
+        return nBucket;
+    int nExponent = nBucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t nSubBucket = nBucket % SUB_BUCKETS;
+    return (SUB_BUCKETS + nSubBucket) << (nExponent - SUB_BUCKET_BITS);
+}
+
+uint64_t CPerfHistogram::GetBucketHigh(int nBucket)
+{
+    if (nBucket == BUCKETS - 1)
+        return std::numeric_limits<uint64_t>::max();
+    return GetBucketLow(nBucket + 1) - 1;
+}
+
+void CPerfHistogram::Record(int64_t nMicros)
+{
+    uint64_t nValue = nMicros > 0 ? nMicros : 0;
+    buckets[GetBucket(nValue)].fetch_add(1, std::memory_order_relaxed);
+    nSum.fetch_add(nValue, std::memory_order_relaxed);
+    uint64_t nPrevMax = nMax.load(std::memory_order_relaxed);
+    while (nValue > nPrevMax && !nMax.compare_exchange_weak(nPrevMax, nValue, std::memory_order_relaxed)) {}
+}
+
+void CPerfHistogram::GetSnapshot(CPerfHistogramSnapshot& snapshot) const
+{
+    // Not atomic as a whole, values recorded meanwhile may show up in some fields only
+    snapshot.vBuckets.resize(BUCKETS);
+    snapshot.nCount = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        snapshot.vBuckets[i] = buckets[i].load(std::memory_order_relaxed);
+        snapshot.nCount += snapshot.vBuckets[i];
+    }
+    snapshot.nSum = nSum.load(std::memory_order_relaxed);
+    snapshot.nMax = nMax.load(std::memory_order_relaxed);
+}
+
+void CPerfHistogram::Reset()
+{
+    for (int i = 0; i < BUCKETS; i++)
+        buckets[i] = 0;
+    nSum = 0;
+    nMax = 0;
+}
+
+CPerfHistogram& GetPerfHistogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(cs_perfstats);
+    std::unique_ptr<CPerfHistogram>& histogram = mapHistograms[name];
+    if (!histogram)
+        histogram.reset(new CPerfHistogram());
+    return *histogram;
+}
+
+CPerfCounter& GetPerfCounter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(cs_perfstats);
+    std::unique_ptr<CPerfCounter>& counter = mapCounters[name];
+    if (!counter)
+        counter.reset(new CPerfCounter());
+    return *counter;
+}
+
+void GetPerfStats(std::map<std::string, CPerfHistogramSnapshot>& histograms, std::map<std::string, uint64_t>& counters)
+{
+    std::lock_guard<std::mutex> lock(cs_perfstats);
+    for (const auto& histogram : mapHistograms)
+        histogram.second->GetSnapshot(histograms[histogram.first]);
+    for (const auto& counter : mapCounters)
+        counters[counter.first] = counter.second->Get();
+}
+
+void ResetPerfStats()
+{
+    std::lock_guard<std::mutex> lock(cs_perfstats);
+    for (const auto& histogram : mapHistograms)
+        histogram.second->Reset();
+    for (const auto& counter : mapCounters)
+        counter.second->Reset();
+}
+
+std::string FormatPerfStatsPrometheus()
+{
+    std::map<std::string, CPerfHistogramSnapshot> histograms;
+    std::map<std::string, uint64_t> counters;
+    GetPerfStats(histograms, counters);
+
+    std::string strOut;
+    for (const auto& histogram : histograms) {
+        const std::string strName = "bzx_" + histogram.first + "_microseconds";
+        const CPerfHistogramSnapshot& snapshot = histogram.second;
+        strOut += strprintf("# TYPE %s histogram\n", strName);
+        // The log-linear buckets don't end at these bounds, values of a bucket
+        // reaching beyond a bound are counted with the next one
+        for (uint64_t nBound : PROMETHEUS_BUCKETS)
+            strOut += strprintf("%s_bucket{le=\"%u\"} %u\n", strName, nBound, snapshot.CountUpTo(nBound));
+        strOut += strprintf("%s_bucket{le=\"+Inf\"} %u\n", strName, snapshot.nCount);
+        strOut += strprintf("%s_sum %u\n", strName, snapshot.nSum);
+        strOut += strprintf("%s_count %u\n", strName, snapshot.nCount);
+    }
+    for (const auto& counter : counters) {
+        const std::string strName = "bzx_" + counter.first + "_total";
+        strOut += strprintf("# TYPE %s counter\n", strName);
+        strOut += strprintf("%s %u\n", strName, counter.second);
+    }
+    return strOut;
+}
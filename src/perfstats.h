@@ -0,0 +1,140 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_PERFSTATS_H
+#define BZX_PERFSTATS_H
+
+#include "utiltime.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+//! -perfstats default
+static const bool DEFAULT_PERFSTATS = true;
+
+//! Whether timers record anything, set from -perfstats
+extern std::atomic<bool> fPerfStats;
+
+/** Copy of a histogram taken at one point in time */
+struct CPerfHistogramSnapshot
+{
+    uint64_t nCount;
+    uint64_t nSum;
+    uint64_t nMax;
+    std::vector<uint64_t> vBuckets;
+
+    CPerfHistogramSnapshot() : nCount(0), nSum(0), nMax(0) {}
+
+    //! Approximate value below which the given fraction of the recorded values lie
+    uint64_t Percentile(double fraction) const;
+    //! Number of recorded values up to nValue, exact at bucket boundaries
+    uint64_t CountUpTo(uint64_t nValue) const;
+};
+
+/**
+ * Histogram of durations in microseconds with log-linear buckets (as in HDR
+ * histograms): every power of two range is split into SUB_BUCKETS buckets,
+ * so values are kept with a relative error below 1/SUB_BUCKETS up to about
+ * 2^MAX_EXPONENT us. Recording only does relaxed atomic increments and is
+ * safe from any thread.
+ */
+class CPerfHistogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 40;
+    static const int BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+private:
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<uint64_t> nSum;
+    std::atomic<uint64_t> nMax;
+
+public:
+    CPerfHistogram();
+
+    static int GetBucket(uint64_t nValue);
+    //! Smallest and largest value of bucket nBucket
+    static uint64_t GetBucketLow(int nBucket);
+    static uint64_t GetBucketHigh(int nBucket);
+
+    void Record(int64_t nMicros);
+    void GetSnapshot(CPerfHistogramSnapshot& snapshot) const;
+    void Reset();
+};
+
+/** Monotonic event counter */
+class CPerfCounter
+{
+private:
+    std::atomic<uint64_t> nValue;
+
+public:
+    CPerfCounter() : nValue(0) {}
+
+    void Add(uint64_t n) { if (fPerfStats) nValue.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Get() const { return nValue.load(std::memory_order_relaxed); }
+    void Reset() { nValue = 0; }
+};
+
+/**
+ * Histogram or counter registered under name, created on first use. The
+ * returned references stay valid until shutdown, hot paths look them up once
+ * (see PERF_SCOPE and PERF_COUNT). Names must be valid Prometheus metric
+ * names: lower case letters, digits and underscores.
+ */
+CPerfHistogram& GetPerfHistogram(const std::string& name);
+CPerfCounter& GetPerfCounter(const std::string& name);
+
+void GetPerfStats(std::map<std::string, CPerfHistogramSnapshot>& histograms, std::map<std::string, uint64_t>& counters);
+void ResetPerfStats();
+//! All histograms and counters in the Prometheus text exposition format
+std::string FormatPerfStatsPrometheus();
+
+/** Records the time from its construction to its destruction */
+class CPerfTimer
+{
+private:
+    CPerfHistogram* histogram;
+    int64_t nStart;
+
+public:
+    explicit CPerfTimer(CPerfHistogram& histogramIn) :
+        histogram(fPerfStats ? &histogramIn : nullptr),
+        nStart(histogram ? GetTimeMicros() : 0) {}
+
+    ~CPerfTimer()
+    {
+        if (histogram)
+            histogram->Record(GetTimeMicros() - nStart);
+    }
+};
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+
+/** Time the rest of the enclosing scope into histogram name */
+#define PERF_SCOPE(name) \
+    static CPerfHistogram& PERF_CONCAT(perfHistogram, __LINE__) = GetPerfHistogram(name); \
+    CPerfTimer PERF_CONCAT(perfTimer, __LINE__)(PERF_CONCAT(perfHistogram, __LINE__))
+
+/** Record an already measured duration in microseconds into histogram name */
+#define PERF_RECORD(name, nMicros) do { \
+    static CPerfHistogram& perfHistogram = GetPerfHistogram(name); \
+    if (fPerfStats) \
+        perfHistogram.Record(nMicros); \
+} while (0)
+
+/** Add n to counter name */
+#define PERF_COUNT(name, n) do { \
+    static CPerfCounter& perfCounter = GetPerfCounter(name); \
+    perfCounter.Add(n); \
+} while (0)
+
+#endif // BZX_PERFSTATS_H
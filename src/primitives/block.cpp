@@ -29,17 +29,16 @@ uint256 CBlockHeader::GetHash() const {
 
 uint256 CBlockHeader::GetPoWHash(int nHeight) const
 {
-    uint256 Hash;
-    lyra2z_hash(BEGIN(nVersion), BEGIN(Hash));
-    if (nHeight > 82)
-    {
-        return Hash;
-    }
+    if (IsLyra2ZHeight(nHeight))
+        return GetLyra2ZHash();
+    return GetHash();
+}
 
-    else
-    {
-        return SerializeHash(*this);
-    }
+uint256 CBlockHeader::GetLyra2ZHash() const
+{
+    uint256 hash;
+    lyra2z_hash(BEGIN(nVersion), BEGIN(hash));
+    return hash;
 }
 
 std::string CBlock::ToString() const {
@@ -93,6 +93,10 @@ public:
 
     uint256 GetPoWHash(int nHeight) const;
 
+    //! The proof of work hash of blocks at nHeight is the Lyra2Z hash, below it is GetHash()
+    static bool IsLyra2ZHeight(int nHeight) { return nHeight > 82; }
+    uint256 GetLyra2ZHash() const;
+
     uint256 GetHash() const;
 
     int64_t GetBlockTime() const
@@ -272,6 +272,15 @@ unsigned int CTransaction::CalculateModifiedSize(unsigned int nTxSize) const
     return nTxSize;
 }
 
+size_t CTransaction::ParsedPayloadsDynamicUsage() const
+{
+    if (!IsLelantusJoinSplit() && !IsSparkSpend())
+        return 0;
+    // older joinsplits carry the proof in the script of their only input
+    size_t nProofSize = vExtraPayload.size() + (vin.empty() ? 0 : vin[0].scriptSig.size());
+    return nProofSize * PARSED_PAYLOAD_USAGE_FACTOR;
+}
+
 unsigned int CTransaction::GetTotalSize() const
 {
     return ::GetSerializeSize(*this, SER_NETWORK, PROTOCOL_VERSION);
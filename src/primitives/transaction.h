@@ -12,7 +12,12 @@
 #include "uint256.h"
 #include "../compat_layer.h"
 
+#include <atomic>
 #include <exception>
+#include <memory>
+
+namespace lelantus { class JoinSplit; }
+namespace spark { class SpendTransaction; }
 
 class CBadTxIn : public std::exception
 {
@@ -307,6 +312,31 @@ inline void SerializeTransaction(const TxType& tx, Stream& s) {
         s << tx.vExtraPayload;
 }
 
+//! Memory used by a parsed proof per byte of its serialization, see CTransaction::ParsedPayloadsDynamicUsage
+static const size_t PARSED_PAYLOAD_USAGE_FACTOR = 5;
+
+/**
+ * Parsed form of a transaction's privacy payload, set by the first parser and
+ * shared with everyone holding the same transaction. The parsed object is
+ * never modified, users that need to change it work on a copy. Mempool
+ * entries count it in their memory usage, see ParsedPayloadsDynamicUsage.
+ */
+template <typename T>
+class CTxParsedPayload
+{
+private:
+    mutable std::shared_ptr<const T> ptr;
+
+public:
+    CTxParsedPayload() {}
+    // copies parse again, AdaptJsplitTx and AdaptSparkTx change the inputs of theirs
+    CTxParsedPayload(const CTxParsedPayload&) {}
+    CTxParsedPayload& operator=(const CTxParsedPayload&) = delete;
+
+    std::shared_ptr<const T> Get() const { return std::atomic_load(&ptr); }
+    void Set(std::shared_ptr<const T> p) const { std::atomic_store(&ptr, std::move(p)); }
+};
+
 /** The basic transaction that is broadcasted on the network and contained in
  * blocks.  A transaction can contain multiple inputs and outputs.
  */
@@ -341,6 +371,10 @@ private:
     uint256 ComputeHash() const;
 
 public:
+    /** Memory only, see lelantus::GetParsedLelantusJoinSplit and spark::GetParsedSparkSpend */
+    const CTxParsedPayload<lelantus::JoinSplit> parsedJoinSplit;
+    const CTxParsedPayload<spark::SpendTransaction> parsedSparkSpend;
+
     /** Construct a CTransaction that qualifies as IsNull() */
     CTransaction();
 
@@ -407,6 +441,14 @@ public:
     bool HasNoRegularInputs() const;
     bool HasPrivateInputs() const;
 
+    /**
+     * Estimated memory usage of the parsed joinsplit or Spark spend, whether
+     * it has been parsed yet or not. Every group element and scalar of a
+     * parsed proof is allocated separately, which takes about
+     * PARSED_PAYLOAD_USAGE_FACTOR times the size of the serialized proof.
+     */
+    size_t ParsedPayloadsDynamicUsage() const;
+
     /**
      * Get the total transaction size in bytes, including witness data.
      * "Total Size" defined in BIP141 and BIP144.
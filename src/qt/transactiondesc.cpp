@@ -269,7 +269,7 @@ QString TransactionDesc::toHTML(CWallet *wallet, CWalletTx &wtx, TransactionReco
 
             if (wtx.tx->IsLelantusJoinSplit() && wtx.tx->vin.size() > 0) {
                 try {
-                    nTxFee = lelantus::ParseLelantusJoinSplit(*wtx.tx)->getFee();
+                    nTxFee = lelantus::GetParsedLelantusJoinSplit(*wtx.tx)->getFee();
                 }
                 catch (const std::exception &) {
                     //do nothing
@@ -278,7 +278,7 @@ QString TransactionDesc::toHTML(CWallet *wallet, CWalletTx &wtx, TransactionReco
 
             if (wtx.tx->IsSparkSpend() && wtx.tx->vin.size() > 0) {
                 try {
-                    nTxFee = spark::ParseSparkSpend(*wtx.tx).getFee();
+                    nTxFee = spark::GetParsedSparkSpend(*wtx.tx)->getFee();
                 }
                 catch (...) {
                     //do nothing
@@ -60,7 +60,7 @@ QList<TransactionRecord> TransactionRecord::decomposeTransaction(const CWallet *
         CAmount nTxFee = nDebit - wtx.tx->GetValueOut();
         if (isAllJoinSplitFromMe && wtx.tx->vin.size() > 0) {
             try {
-                nTxFee = lelantus::ParseLelantusJoinSplit(*wtx.tx)->getFee();
+                nTxFee = lelantus::GetParsedLelantusJoinSplit(*wtx.tx)->getFee();
             } catch (const std::exception &) {
                 // do nothing
             }
@@ -269,7 +269,7 @@ QList<TransactionRecord> TransactionRecord::decomposeTransaction(const CWallet *
 
             if (wtx.tx->IsSparkSpend() && wtx.tx->vin.size() > 0) {
                 try {
-                    nTxFee = spark::ParseSparkSpend(*wtx.tx).getFee();
+                    nTxFee = spark::GetParsedSparkSpend(*wtx.tx)->getFee();
                 }
                 catch (...) {
                     //do nothing
@@ -0,0 +1,180 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "reindex.h"
+
+#include "batchproof_container.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "consensus/consensus.h"
+#include "primitives/block.h"
+#include "protocol.h"
+#include "streams.h"
+#include "util.h"
+#include "validation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+CReindexPipeline::CReindexPipeline(const CChainParams& chainparamsIn, int nThreads) :
+    chainparams(chainparamsIn),
+    nMaxAhead(std::max(nThreads, 1)),
+    nNextFile(0),
+    nImportFile(0),
+    nEndFile(std::numeric_limits<int>::max()),
+    fInterrupt(false)
+{
+    for (int i = 0; i < nMaxAhead; i++)
+        workers.emplace_back(&TraceThread<std::function<void()>>, "reindex", std::function<void()>(std::bind(&CReindexPipeline::ThreadParse, this)));
+}
+
+CReindexPipeline::~CReindexPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fInterrupt = true;
+    }
+    cvParsed.notify_all();
+    cvImported.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+bool CReindexPipeline::ParseFile(int nFile, std::vector<CReindexBlock>& vBlocks) const
+{
+    CDiskBlockPos pos(nFile, 0);
+    if (!boost::filesystem::exists(GetBlockPosFilename(pos, "blk")))
+        return false; // No block files left to reindex
+    FILE* file = OpenBlockFile(pos, true);
+    if (!file)
+        return false; // This error is logged in OpenBlockFile
+
+    // Same recovery as LoadExternalBlockFile: after anything that doesn't
+    // parse look for the next message start one byte further. The file is
+    // read through a window of two blocks instead of being loaded whole.
+    try {
+        // This takes over file and calls fclose() on it in the CBufferedFile destructor
+        CBufferedFile blkdat(file, 2*MAX_BLOCK_BASE_SIZE, MAX_BLOCK_BASE_SIZE+8, SER_DISK, CLIENT_VERSION);
+        uint64_t nRewind = blkdat.GetPos();
+        while (!blkdat.eof() && !fInterrupt) {
+            blkdat.SetPos(nRewind);
+            nRewind++; // start one byte further next time, in case of failure
+            blkdat.SetLimit(); // remove former limit
+            unsigned int nSize = 0;
+            try {
+                // locate a header
+                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+                blkdat.FindByte(chainparams.MessageStart()[0]);
+                nRewind = blkdat.GetPos()+1;
+                blkdat >> FLATDATA(buf);
+                if (memcmp(buf, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE))
+                    continue;
+                // read size
+                blkdat >> nSize;
+                if (nSize < 80 || nSize > MAX_BLOCK_BASE_SIZE)
+                    continue;
+            } catch (const std::exception&) {
+                // no valid block header found; don't complain
+                break;
+            }
+            try {
+                CReindexBlock block;
+                uint64_t nBlockPos = blkdat.GetPos();
+                blkdat.SetLimit(nBlockPos + nSize);
+                block.pblock = std::make_shared<CBlock>();
+                blkdat >> *block.pblock;
+                nRewind = blkdat.GetPos();
+                block.nPos = nBlockPos;
+                block.hashLyra2Z = block.pblock->GetLyra2ZHash();
+                vBlocks.push_back(std::move(block));
+            } catch (const std::exception& e) {
+                LogPrintf("%s: Deserialize or I/O error in blk%05u.dat - %s\n", __func__, (unsigned int)nFile, e.what());
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        LogPrintf("%s: System error in blk%05u.dat - %s\n", __func__, (unsigned int)nFile, e.what());
+    }
+    return true;
+}
+
+void CReindexPipeline::ThreadParse()
+{
+    while (true) {
+        int nFile;
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            cvImported.wait(lock, [this] { return fInterrupt || nNextFile >= nEndFile || nNextFile < nImportFile + nMaxAhead; });
+            if (fInterrupt || nNextFile >= nEndFile)
+                return;
+            nFile = nNextFile++;
+        }
+
+        ParsedFile parsed;
+        parsed.fExists = ParseFile(nFile, parsed.vBlocks);
+
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            if (!parsed.fExists)
+                nEndFile = std::min(nEndFile, nFile);
+            mapParsed[nFile] = std::move(parsed);
+        }
+        cvParsed.notify_all();
+        // workers waiting for files past the end have to notice it
+        cvImported.notify_all();
+    }
+}
+
+bool CReindexPipeline::GetFile(int nFile, std::vector<CReindexBlock>& vBlocks)
+{
+    assert(nFile == nImportFile);
+
+    std::unique_lock<std::mutex> lock(cs);
+    while (!mapParsed.count(nFile)) {
+        // a shutdown interrupts the import thread, not the condition
+        cvParsed.wait_for(lock, std::chrono::milliseconds(100));
+        boost::this_thread::interruption_point();
+    }
+
+    std::map<int, ParsedFile>::iterator it = mapParsed.find(nFile);
+    bool fExists = it->second.fExists;
+    vBlocks.swap(it->second.vBlocks);
+    mapParsed.erase(it);
+    nImportFile = nFile + 1;
+    lock.unlock();
+    cvImported.notify_all();
+    return fExists;
+}
+
+bool ReindexBlockFiles(const CChainParams& chainparams, int nThreads)
+{
+    bool fBatching = GetBoolArg("-batching", true);
+    LogPrintf("Reindexing with %d parsing threads\n", nThreads);
+
+    CReindexPipeline pipeline(chainparams, nThreads);
+    for (int nFile = 0; true; nFile++) {
+        std::vector<CReindexBlock> vBlocks;
+        if (!pipeline.GetFile(nFile, vBlocks))
+            break;
+        LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
+        LoadReindexBlocks(chainparams, nFile, vBlocks);
+
+        if (fBatching) {
+            // verify the proofs of the file now instead of collecting them
+            // until the chain has caught up, they would all be held in memory
+            LOCK(cs_main);
+            try {
+                BatchProofContainer::get_instance()->flush();
+            } catch (const std::exception& e) {
+                AbortNode(e.what());
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_REINDEX_H
+#define BZX_REINDEX_H
+
+#include "uint256.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CBlock;
+class CChainParams;
+
+//! -reindexthreads default, 0 = one per core up to MAX_REINDEX_THREADS
+static const int DEFAULT_REINDEX_THREADS = 0;
+//! Every thread holds the parsed blocks of one file, this bounds the files held in memory
+static const int MAX_REINDEX_THREADS = 4;
+
+/** A block parsed from a block file by the -reindex pipeline */
+struct CReindexBlock
+{
+    std::shared_ptr<CBlock> pblock;
+    //! Position of the block in its file
+    unsigned int nPos;
+    //! Proof of work hash of all but the first blocks of the chain
+    uint256 hashLyra2Z;
+};
+
+/**
+ * Reads the block files for -reindex ahead of the thread importing them.
+ *
+ * Worker threads take the block files in order, one file each, locate the
+ * blocks in it, parse them and compute their Lyra2Z hashes, most of the cost
+ * of accepting a block besides connecting it. Files are read through a
+ * window of two blocks, only the parsed blocks are kept. The import thread
+ * takes the parsed files in order and only accepts and connects the blocks.
+ * Workers stay at most one file each ahead of the import, so at most the
+ * parsed blocks of MAX_REINDEX_THREADS files plus the one being imported
+ * are held in memory.
+ */
+class CReindexPipeline
+{
+private:
+    struct ParsedFile
+    {
+        bool fExists;
+        std::vector<CReindexBlock> vBlocks;
+    };
+
+    const CChainParams& chainparams;
+    const int nMaxAhead;
+
+    std::mutex cs;
+    //! Signalled when a worker finished a file or on interruption
+    std::condition_variable cvParsed;
+    //! Signalled when the import took a file or on interruption
+    std::condition_variable cvImported;
+    std::map<int, ParsedFile> mapParsed;
+    //! Next file a worker takes
+    int nNextFile;
+    //! Next file the import takes
+    int nImportFile;
+    //! First file found missing, there are no files past it
+    int nEndFile;
+
+    std::atomic<bool> fInterrupt;
+    std::vector<std::thread> workers;
+
+    //! Parse the blocks of file nFile, false if there is no such file
+    bool ParseFile(int nFile, std::vector<CReindexBlock>& vBlocks) const;
+    void ThreadParse();
+
+public:
+    CReindexPipeline(const CChainParams& chainparams, int nThreads);
+    ~CReindexPipeline();
+
+    /**
+     * Wait for the blocks of file nFile, files have to be taken in order.
+     * Returns false if there is no such file. Interruption point.
+     */
+    bool GetFile(int nFile, std::vector<CReindexBlock>& vBlocks);
+};
+
+/**
+ * Rebuild the block index from the block files, with nThreads parsing
+ * workers. The proofs batched while connecting blocks are verified after
+ * every file. Returns false if reindexing was aborted.
+ */
+bool ReindexBlockFiles(const CChainParams& chainparams, int nThreads);
+
+#endif // BZX_REINDEX_H
@@ -4,10 +4,12 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "amount.h"
+#include "blockfilterindex.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "coins.h"
+#include "coinstats.h"
 #include "compat_layer.h"
 #include "core_io.h"
 #include "consensus/validation.h"
@@ -21,6 +23,7 @@
 #include "util.h"
 #include "utilstrencodings.h"
 #include "hash.h"
+#include "net.h"
 
 #include "evo/specialtx.h"
 #include "evo/providertx.h"
@@ -809,6 +812,66 @@ UniValue getblockhash(const JSONRPCRequest& request)
     return pblockindex->GetBlockHash().GetHex();
 }
 
+UniValue getblockfilter(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "getblockfilter \"blockhash\" ( \"filtertype\" )\n"
+            "\nRetrieve a BIP 157 content filter for a particular block.\n"
+            "Besides the BIP 158 scripts the basic filter contains the Spark serial contexts and\n"
+            "linking tags and the Lelantus public coins and serials of the block.\n"
+            "\nArguments:\n"
+            "1. \"blockhash\"      (string, required) The hash of the block\n"
+            "2. \"filtertype\"     (string, optional, default=basic) The type name of the filter\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filter\" : \"hex\",   (string) the hex-encoded filter data\n"
+            "  \"header\" : \"hex\"    (string) the hex-encoded filter header\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\" \"basic\"")
+            + HelpExampleRpc("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\", \"basic\"")
+        );
+
+    uint256 blockHash = ParseHashV(request.params[0], "blockhash");
+    std::string filterTypeName = "basic";
+    if (request.params.size() > 1 && !request.params[1].isNull())
+        filterTypeName = request.params[1].get_str();
+
+    BlockFilterType filterType;
+    if (!BlockFilterTypeByName(filterTypeName, filterType))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
+
+    if (!pblockfilterindex || pblockfilterindex->GetFilterType() != filterType)
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is not enabled for filtertype " + filterTypeName);
+
+    const CBlockIndex* pblockindex;
+    {
+        LOCK(cs_main);
+        BlockMap::const_iterator it = mapBlockIndex.find(blockHash);
+        if (it == mapBlockIndex.end())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        pblockindex = it->second;
+    }
+
+    BlockFilter filter;
+    uint256 filterHeader;
+    if (!pblockfilterindex->LookupFilter(pblockindex, filter) ||
+        !pblockfilterindex->LookupFilterHeader(pblockindex, filterHeader)) {
+        std::string errmsg = "Filter not found.";
+        if (!pblockfilterindex->IsSynced())
+            errmsg += " Block filters are still in the process of being indexed.";
+        else
+            errmsg += " This error is unexpected and indicates index corruption.";
+        throw JSONRPCError(RPC_MISC_ERROR, errmsg);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("filter", HexStr(filter.GetEncodedFilter())));
+    ret.push_back(Pair("header", filterHeader.GetHex()));
+    return ret;
+}
+
 UniValue getblockheader(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
@@ -962,93 +1025,6 @@ UniValue getblock(const JSONRPCRequest& request)
     return blockToJSON(block, pblockindex, verbosity >= 2);
 }
 
-struct CCoinsStats
-{
-    int nHeight;
-    uint256 hashBlock;
-    uint64_t nTransactions;
-    uint64_t nTransactionOutputs;
-    uint256 hashSerialized;
-    uint64_t nDiskSize;
-    CAmount nTotalAmount;
-
-    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nTotalAmount(0) {}
-};
-
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
-{
-    assert(!outputs.empty());
-    ss << hash;
-    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
-    stats.nTransactions++;
-    for (const auto& output : outputs) {
-        ss << VARINT(output.first + 1);
-        ss << *(const CScriptBase*)(&output.second.out.scriptPubKey);
-        ss << VARINT(output.second.out.nValue);
-        stats.nTransactionOutputs++;
-        stats.nTotalAmount += output.second.out.nValue;
-    }
-    ss << VARINT(0);
-}
-
-//! Calculate statistics about the unspent transaction output set
-static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
-{
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
-    stats.hashBlock = pcursor->GetBestBlock();
-    {
-        LOCK(cs_main);
-        stats.nHeight = mapBlockIndex.find(stats.hashBlock)->second->nHeight;
-    }
-    ss << stats.hashBlock;
-    uint256 prevkey;
-    std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        COutPoint key;
-        Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
-                outputs.clear();
-            }
-            prevkey = key.hash;
-            outputs[key.n] = std::move(coin);
-        } else {
-            return error("%s: unable to read value", __func__);
-        }
-        pcursor->Next();
-    }
-    if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
-    }
-
-    // We need to remove amount of private spends from nTotalAmount;
-    // There are 3 type of private spend transactions
-    std::vector<std::pair<uint160, AddressType> > addresses;
-    addresses.push_back(std::make_pair(uint160(), AddressType::lelantusJSplit));
-    addresses.push_back(std::make_pair(uint160(), AddressType::sparkSpend));
-
-    // Iterate over all types of transactions
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    for (std::vector<std::pair<uint160, AddressType> >::iterator itr = addresses.begin(); itr != addresses.end(); itr++) {
-        // Get address index for each transaction type
-        if (GetAddressIndex((*itr).first, (*itr).second, addressIndex)) {
-            for (std::vector < std::pair < CAddressIndexKey, CAmount > > ::const_iterator it = addressIndex.begin();
-                    it != addressIndex.end(); it++) {
-                stats.nTotalAmount += it->second;
-            }
-        }
-        addressIndex.clear();
-    }
-    stats.nTotalAmount += 0;
-    stats.hashSerialized = ss.GetHash();
-    stats.nDiskSize = view->EstimateSize();
-    return true;
-}
-
 UniValue pruneblockchain(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -1100,11 +1076,13 @@ UniValue pruneblockchain(const JSONRPCRequest& request)
 
 UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 0)
+    if (request.fHelp || request.params.size() > 1)
         throw std::runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( \"hash_type\" )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "Note this call may take some time, the result is reused until the next block.\n"
+            "\nArguments:\n"
+            "1. \"hash_type\"     (string, optional, default=hash_serialized_2) Which UTXO set hash to calculate, \"hash_serialized_2\" or \"none\"\n"
             "\nResult:\n"
             "{\n"
             "  \"height\":n,     (numeric) The current block height (index)\n"
@@ -1117,19 +1095,30 @@ UniValue gettxoutsetinfo(const JSONRPCRequest& request)
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "none")
             + HelpExampleRpc("gettxoutsetinfo", "")
         );
 
+    bool fHash = true;
+    if (request.params.size() > 0 && !request.params[0].isNull()) {
+        std::string hashType = request.params[0].get_str();
+        if (hashType == "none")
+            fHash = false;
+        else if (hashType != "hash_serialized_2")
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown hash_type: " + hashType);
+    }
+
     UniValue ret(UniValue::VOBJ);
 
     CCoinsStats stats;
     FlushStateToDisk();
-    if (GetUTXOStats(pcoinsTip, stats)) {
+    if (GetUTXOStats(pcoinsTip, stats, fHash)) {
         ret.push_back(Pair("height", (int64_t)stats.nHeight));
         ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
         ret.push_back(Pair("transactions", (int64_t)stats.nTransactions));
         ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
-        ret.push_back(Pair("hash_serialized_2", stats.hashSerialized.GetHex()));
+        if (fHash)
+            ret.push_back(Pair("hash_serialized_2", stats.hashSerialized.GetHex()));
         ret.push_back(Pair("disk_size", stats.nDiskSize));
         ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
     } else {
@@ -1549,6 +1538,40 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
     return mempoolInfoToJSON();
 }
 
+UniValue getstempoolinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getstempoolinfo\n"
+            "\nReturns details on the active state of the Dandelion stem transaction pool.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\": xxxxx,               (numeric) Current tx count, including the mempool transactions mirrored to it\n"
+            "  \"bytes\": xxxxx,              (numeric) Sum of all virtual transaction sizes\n"
+            "  \"usage\": xxxxx,              (numeric) Total memory usage for the stem pool\n"
+            "  \"maxstempool\": xxxxx,        (numeric) Maximum memory usage for the stem pool\n"
+            "  \"embargoes\": xxxxx,          (numeric) Number of transactions under Dandelion embargo\n"
+            "  \"embargoesexpired\": xxxxx,   (numeric) Number of embargoes that expired, their transactions were fluffed\n"
+            "  \"embargoescancelled\": xxxxx, (numeric) Number of embargoes cancelled because the transaction was seen fluffed\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getstempoolinfo", "")
+            + HelpExampleRpc("getstempoolinfo", "")
+        );
+
+    CTxMemPool& stempool = txpools.getStemTxPool();
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("size", (int64_t) stempool.size()));
+    ret.push_back(Pair("bytes", (int64_t) stempool.GetTotalTxSize()));
+    ret.push_back(Pair("usage", (int64_t) stempool.DynamicMemoryUsage()));
+    ret.push_back(Pair("maxstempool", GetArg("-maxstempool", DEFAULT_MAX_STEMPOOL_SIZE) * 1000000));
+    ret.push_back(Pair("embargoes", (int64_t) CNode::timerDandelionEmbargo.Size()));
+    ret.push_back(Pair("embargoesexpired", (int64_t) CNode::timerDandelionEmbargo.GetExpiredCount()));
+    ret.push_back(Pair("embargoescancelled", (int64_t) CNode::timerDandelionEmbargo.GetRemovedCount()));
+
+    return ret;
+}
+
 UniValue preciousblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -1780,6 +1803,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbose"} },
     { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"} },
     { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high", "low"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         true,  {"blockhash", "filtertype"} },
     { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           true,  {} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {} },
@@ -1787,11 +1811,12 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  true,  {"txid","verbose"} },
     { "blockchain",         "getmempoolentry",        &getmempoolentry,        true,  {"txid"} },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         true,  {} },
+    { "blockchain",         "getstempoolinfo",        &getstempoolinfo,        true,  {} },
     { "blockchain",         "getrawmempool",          &getrawmempool,          true,  {"verbose"} },
     { "blockchain",         "clearmempool",           &clearmempool,           true,  {} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         true,  {"blockhash", "type", "count", "skip", "verbosity"} },
     { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {"hash_type"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        true,  {"height"} },
     { "blockchain",         "verifychain",            &verifychain,            true,  {"checklevel","nblocks"} },
 
@@ -5,6 +5,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "base58.h"
+#include "blocktemplatemanager.h"
 #include "amount.h"
 #include "chain.h"
 #include "chainparams.h"
@@ -576,44 +577,40 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     if (g_connman->GetNodeCount(CConnman::CONNECTIONS_ALL) == 0)
         throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "BZX is not connected!");
 
-    static unsigned int nTransactionsUpdatedLast;
+    if (!pblocktemplatemanager)
+        throw JSONRPCError(RPC_IN_WARMUP, "Block template manager not started");
+
     if (!lpval.isNull())
     {
-        // Wait to respond until either the best block changes, OR a minute has passed and there are more transactions
+        // Wait to respond until either the best block changes, OR the template fees grew enough for a new template id
         uint256 hashWatchedChain;
-        boost::system_time checktxtime;
-        unsigned int nTransactionsUpdatedLastLP;
+        uint64_t nTemplateIdLP;
 
         if (lpval.isStr())
         {
-            // Format: <hashBestChain><nTransactionsUpdatedLast>
+            // Format: <hashBestChain><nTemplateId>
             std::string lpstr = lpval.get_str();
 
             hashWatchedChain.SetHex(lpstr.substr(0, 64));
-            nTransactionsUpdatedLastLP = atoi64(lpstr.substr(64));
+            nTemplateIdLP = atoi64(lpstr.substr(64));
         }
         else
         {
             // NOTE: Spec does not specify behaviour for non-string longpollid, but this makes testing easier
-            hashWatchedChain = chainActive.Tip()->GetBlockHash();
-            nTransactionsUpdatedLastLP = nTransactionsUpdatedLast;
+            const CBlockIndex* pindexPrevLP;
+            if (!pblocktemplatemanager->GetBlockTemplate(pindexPrevLP, nTemplateIdLP))
+                throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+            hashWatchedChain = pindexPrevLP->GetBlockHash();
         }
 
         // Release the wallet and main lock while waiting
         LEAVE_CRITICAL_SECTION(cs_main);
         {
-            checktxtime = boost::get_system_time() + boost::posix_time::minutes(1);
-
-            boost::unique_lock<boost::mutex> lock(csBestBlock);
-            while (chainActive.Tip()->GetBlockHash() == hashWatchedChain && IsRPCRunning())
+            // Wake up every second to notice a shutdown
+            while (IsRPCRunning())
             {
-                if (!cvBlockChange.timed_wait(lock, checktxtime))
-                {
-                    // Timeout: Check transactions for update
-                    if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP)
-                        break;
-                    checktxtime += boost::posix_time::seconds(10);
-                }
+                if (pblocktemplatemanager->WaitForNewTemplate(hashWatchedChain, nTemplateIdLP, 1000))
+                    break;
             }
         }
         ENTER_CRITICAL_SECTION(cs_main);
@@ -624,30 +621,19 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     }
 
     // Update block
-    static CBlockIndex* pindexPrev;
-    static int64_t nStart;
-    static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    if (pindexPrev != chainActive.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5))
-    {
-        // Clear pindexPrev so future calls make a new block, despite any failures from here on
-        pindexPrev = nullptr;
+    // The template is kept up to date in the background, this only copies the latest one
+    const CBlockIndex* pindexPrev = nullptr;
+    uint64_t nTemplateId = 0;
+    std::shared_ptr<const CBlockTemplate> psharedtemplate = pblocktemplatemanager->GetBlockTemplate(pindexPrev, nTemplateId);
+    if (!psharedtemplate)
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+    static uint64_t nTemplateIdLast;
+    if (nTemplateId != nTemplateIdLast) {
         mapPPBlockTemplates.clear();
-
-        // Store the pindexBest used before CreateNewBlock, to avoid races
-        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrevNew = chainActive.Tip();
-        nStart = GetTime();
-
-        // Create new block
-        CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy);
-        if (!pblocktemplate)
-            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
+        nTemplateIdLast = nTemplateId;
     }
+    // The copy gets the time and coinbase of this request
+    std::unique_ptr<CBlockTemplate> pblocktemplate(new CBlockTemplate(*psharedtemplate));
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
     const Consensus::Params& consensusParams = Params().GetConsensus();
 
@@ -780,7 +766,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     result.push_back(Pair("transactions", transactions));
     result.push_back(Pair("coinbaseaux", aux));
     result.push_back(Pair("coinbasevalue", (int64_t)pblock->vtx[0]->GetValueOut()));
-    result.push_back(Pair("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(nTransactionsUpdatedLast)));
+    result.push_back(Pair("longpollid", pindexPrev->GetBlockHash().GetHex() + i64tostr(nTemplateId)));
     result.push_back(Pair("target", hashTarget.GetHex()));
     result.push_back(Pair("mintime", (int64_t)pindexPrev->GetMedianTimePast()+1));
     result.push_back(Pair("mutable", aMutable));
@@ -9,6 +9,7 @@
 #include "validation.h"
 #include "net.h"
 #include "netbase.h"
+#include "perfstats.h"
 #include "rpc/server.h"
 #include "timedata.h"
 #include "txmempool.h"
@@ -1149,7 +1150,7 @@ UniValue getusedcoinserials(const JSONRPCRequest& request)
     }
 
     lelantus::CLelantusState* lelantusState = lelantus::CLelantusState::GetState();
-    std::unordered_map<Scalar, int>  serials;
+    CTagMap<Scalar, int> serials;
     {
         LOCK(cs_main);
         serials = lelantusState->GetSpends();
@@ -1160,10 +1161,8 @@ UniValue getusedcoinserials(const JSONRPCRequest& request)
     for ( auto it = serials.begin(); it != serials.end(); ++it, ++i) {
         if (cmp::less((serials.size() - i - 1), startNumber))
             continue;
-        std::vector<unsigned char> serialized;
-        serialized.resize(32);
-        it->first.serialize(serialized.data());
-        serializedSerials.push_back(EncodeBase64(serialized.data(), 32));
+        // the map keeps the serials serialized
+        serializedSerials.push_back(EncodeBase64(it.data(), 32));
     }
 
     UniValue ret(UniValue::VOBJ);
@@ -1559,7 +1558,7 @@ UniValue getusedcoinstagstxhashes(const JSONRPCRequest& request)
     }
 
     spark::CSparkState* sparkState =  spark::CSparkState::GetState();
-    std::unordered_map<GroupElement, int, spark::CLTagHash>  tags;
+    CTagMap<GroupElement, int> tags;
     std::unordered_map<uint256, uint256> ltagTxhash;
     {
         LOCK(cs_main);
@@ -1571,13 +1570,10 @@ UniValue getusedcoinstagstxhashes(const JSONRPCRequest& request)
     for ( auto it = tags.begin(); it != tags.end(); ++it, ++i) {
         if (cmp::less((tags.size() - i - 1), startNumber))
             continue;
-        std::vector<unsigned char> serialized;
-        serialized.resize(34);
-        it->first.serialize(serialized.data());
         std::vector<UniValue> data;
-        data.push_back(EncodeBase64(serialized.data(), 34));
+        data.push_back(EncodeBase64(it.data(), 34));
         uint256 txid;
-        uint256 ltagHash = primitives::GetLTagHash(it->first);
+        uint256 ltagHash = primitives::GetLTagHash(it.key());
         if (ltagTxhash.count(ltagHash) > 0)
             txid = ltagTxhash[ltagHash];
         data.push_back(EncodeBase64(txid.begin(), txid.size()));
@@ -1679,8 +1675,8 @@ UniValue getmempoolsparktxs(const JSONRPCRequest& request)
         if (tx->IsSparkSpend())
         {
             try {
-                spark::SpendTransaction spend = spark::ParseSparkSpend(*tx);
-                auto lTags = spend.getUsedLTags();
+                std::shared_ptr<const spark::SpendTransaction> spend = spark::GetParsedSparkSpend(*tx);
+                const auto& lTags = spend->getUsedLTags();
                 for ( auto it = lTags.begin(); it != lTags.end(); ++it) {
                     std::vector<unsigned char> serialized;
                     serialized.resize(34);
@@ -2004,6 +2000,21 @@ UniValue getinfoex(const JSONRPCRequest& request)
     return info;
 }
 
+static UniValue RPCDebugLogInfo()
+{
+    CDebugLogStats stats;
+    GetDebugLogStats(stats);
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("async", stats.fRunning));
+    obj.push_back(Pair("queue_size", uint64_t(stats.nQueueSize)));
+    obj.push_back(Pair("queued", stats.nQueued));
+    obj.push_back(Pair("dropped", stats.nDropped));
+    obj.push_back(Pair("written", stats.nWritten));
+    obj.push_back(Pair("batches", stats.nBatches));
+    obj.push_back(Pair("bytes", stats.nBytes));
+    return obj;
+}
+
 static UniValue RPCLockedMemoryInfo()
 {
     LockedPool::Stats stats = LockedPoolManager::Instance().stats();
@@ -2035,6 +2046,15 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"debuglog\": {             (json object) Information about the debug.log queue\n"
+            "    \"async\": true|false,    (boolean) Whether messages are written by a background thread\n"
+            "    \"queue_size\": xxxxx,    (numeric) Number of messages the queue holds\n"
+            "    \"queued\": xxxxx,        (numeric) Number of messages queued\n"
+            "    \"dropped\": xxxxx,       (numeric) Number of messages dropped because the queue was full\n"
+            "    \"written\": xxxxx,       (numeric) Number of queued messages written\n"
+            "    \"batches\": xxxxx,       (numeric) Number of writes\n"
+            "    \"bytes\": xxxxx,         (numeric) Number of bytes written\n"
             "  }\n"
             "}\n"
             "\nExamples:\n"
@@ -2043,9 +2063,85 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
         );
     UniValue obj(UniValue::VOBJ);
     obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+    obj.push_back(Pair("debuglog", RPCDebugLogInfo()));
     return obj;
 }
 
+UniValue getperfstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 2)
+        throw std::runtime_error(
+            "getperfstats ( \"prefix\" reset )\n"
+            "Returns latency histograms and event counters of the hot paths of the node.\n"
+            "\nArguments:\n"
+            "1. \"prefix\"      (string, optional) Only return statistics whose name starts with this prefix\n"
+            "2. reset           (boolean, optional, default=false) Reset all statistics after reading them\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"enabled\": true|false,     (boolean) Whether timings are recorded (-perfstats)\n"
+            "  \"histograms\": {\n"
+            "    \"name\": {\n"
+            "      \"count\": n,            (numeric) Number of recorded durations\n"
+            "      \"total_ms\": x.xxx,     (numeric) Sum of the durations in milliseconds\n"
+            "      \"mean_us\": n,          (numeric) Mean duration in microseconds\n"
+            "      \"p50_us\": n,           (numeric) Median in microseconds\n"
+            "      \"p90_us\": n,           (numeric) 90th percentile in microseconds\n"
+            "      \"p99_us\": n,           (numeric) 99th percentile in microseconds\n"
+            "      \"max_us\": n            (numeric) Longest duration in microseconds\n"
+            "    }, ...\n"
+            "  },\n"
+            "  \"counters\": {\n"
+            "    \"name\": n, ...         (numeric) Number of events\n"
+            "  }\n"
+            "}\n"
+            "\nPercentiles are accurate to within 1/8 of their value.\n"
+            "The same statistics are available in Prometheus text format at /rest/metrics if -rest is enabled.\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getperfstats", "")
+            + HelpExampleCli("getperfstats", "\"spark_\"")
+            + HelpExampleRpc("getperfstats", "\"validation_\", true")
+        );
+
+    std::string strPrefix;
+    if (request.params.size() > 0)
+        strPrefix = request.params[0].get_str();
+    bool fReset = request.params.size() > 1 && request.params[1].get_bool();
+
+    std::map<std::string, CPerfHistogramSnapshot> histograms;
+    std::map<std::string, uint64_t> counters;
+    GetPerfStats(histograms, counters);
+    if (fReset)
+        ResetPerfStats();
+
+    UniValue histogramsObj(UniValue::VOBJ);
+    for (const auto& histogram : histograms) {
+        const CPerfHistogramSnapshot& snapshot = histogram.second;
+        if (histogram.first.compare(0, strPrefix.size(), strPrefix) != 0 || snapshot.nCount == 0)
+            continue;
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("count", snapshot.nCount));
+        obj.push_back(Pair("total_ms", snapshot.nSum * 0.001));
+        obj.push_back(Pair("mean_us", snapshot.nSum / snapshot.nCount));
+        obj.push_back(Pair("p50_us", snapshot.Percentile(0.5)));
+        obj.push_back(Pair("p90_us", snapshot.Percentile(0.9)));
+        obj.push_back(Pair("p99_us", snapshot.Percentile(0.99)));
+        obj.push_back(Pair("max_us", snapshot.nMax));
+        histogramsObj.push_back(Pair(histogram.first, obj));
+    }
+
+    UniValue countersObj(UniValue::VOBJ);
+    for (const auto& counter : counters) {
+        if (counter.first.compare(0, strPrefix.size(), strPrefix) == 0)
+            countersObj.push_back(Pair(counter.first, counter.second));
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("enabled", fPerfStats.load()));
+    result.push_back(Pair("histograms", histogramsObj));
+    result.push_back(Pair("counters", countersObj));
+    return result;
+}
+
 UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -2064,6 +2160,7 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------   ---------
     { "control",            "getinfo",                &getinfo,                true,        {} }, /* uses wallet if enabled */
     { "control",            "getmemoryinfo",          &getmemoryinfo,          true,        {} },
+    { "control",            "getperfstats",           &getperfstats,           true,        {"prefix","reset"} },
     { "util",               "validateaddress",        &validateaddress,        true,        {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         true,        {"nrequired","keys"} },
     { "util",               "verifymessage",          &verifymessage,          true,        {"address","signature","message"} },
@@ -80,6 +80,14 @@ public:
   // The function deserializes the GroupElement and checks the validity,
   // it accepts infinity point, handle it based on your use case
   unsigned const char* deserialize(unsigned const char* buffer);
+  // Deserializes n consecutive points into elements, as one pass over the buffer
+  static unsigned const char* deserialize_batch(unsigned const char* buffer, GroupElement* elements, std::size_t n);
+  // Serializes n points like serialize(), with one field inversion for all of
+  // them. Variable time, only for public points
+  static unsigned char* serialize_batch(const GroupElement* elements, std::size_t n, unsigned char* buffer);
+  // Stores n points in affine form with one field inversion for all of them,
+  // so serializing and comparing them later needs none. Variable time
+  static void normalize_batch(GroupElement* elements, std::size_t n);
 
   // These functions are for READWRITE() in serialize.h
   template<typename Stream>
@@ -27,15 +27,64 @@
 
 static secp256k1_ecmult_context ctx;
 
+// Returns true if the point is stored with z = 1, deserialized and normalized
+// points are, so no inversion is needed to get their affine coordinates.
+static bool gej_is_affine(const secp256k1_gej &gej)
+{
+    secp256k1_fe z = gej.z;
+    secp256k1_fe one;
+    secp256k1_fe_normalize_var(&z);
+    secp256k1_fe_set_int(&one, 1);
+    return secp256k1_fe_cmp_var(&z, &one) == 0;
+}
+
 // Converts the value from secp256k1_gej to secp256k1_ge and returns.
 static secp256k1_ge gej_to_ge(const secp256k1_gej &gej)
 {
     secp256k1_ge ge;
+    if (!gej.infinity && gej_is_affine(gej)) {
+        ge.x = gej.x;
+        ge.y = gej.y;
+        ge.infinity = 0;
+        secp256k1_fe_normalize_var(&ge.x);
+        secp256k1_fe_normalize_var(&ge.y);
+        return ge;
+    }
     secp256k1_gej j(gej);
     secp256k1_ge_set_gej(&ge, &j);
     return ge;
 }
 
+// Converts n points to affine coordinates with a single inversion for all of
+// them (Montgomery's trick). The inversion is variable time, so this is only
+// for public points.
+static void gej_to_ge_batch(const std::vector<const secp256k1_gej *>& points, std::vector<secp256k1_ge>& result)
+{
+    std::size_t n = points.size();
+    std::vector<std::size_t> indexes;
+    std::vector<secp256k1_fe> z, zinv;
+    result.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        const secp256k1_gej *gej = points[i];
+        // infinity and affine points take the single path, it needs no
+        // inversion for the latter and keeps the encoding of the former
+        if (gej->infinity || gej_is_affine(*gej)) {
+            result[i] = gej_to_ge(*gej);
+        } else {
+            indexes.push_back(i);
+            z.push_back(gej->z);
+        }
+    }
+    if (indexes.empty())
+        return;
+
+    zinv.resize(z.size());
+    secp256k1_fe_inv_all_var(zinv.data(), z.data(), z.size());
+    for (std::size_t k = 0; k < indexes.size(); k++) {
+        secp256k1_ge_set_gej_zinv(&result[indexes[k]], points[indexes[k]], &zinv[k]);
+    }
+}
+
 //	Implements the algorithm from:
 //   Indifferentiable Hashing to Barreto-Naehrig Curves
 //    Pierre-Alain Fouque and Mehdi Tibouchi
@@ -523,23 +572,69 @@ unsigned char* GroupElement::serialize(unsigned char* buffer) const {
     return buffer + memoryRequired();
 }
 
-const unsigned char* GroupElement::deserialize(const unsigned char* buffer) {
+// Decompresses a serialized point into r, returns false if it isn't on the curve.
+// The square root of x^3 + 7 only exists for points on the curve, so the curve
+// equation doesn't have to be checked again afterwards.
+static bool decompress(secp256k1_gej *r, const unsigned char* buffer)
+{
     secp256k1_fe x;
     secp256k1_fe_set_b32(&x, buffer);
     unsigned char oddness = buffer[32];
     unsigned char infinity = buffer[33];
     secp256k1_ge result;
-    secp256k1_ge_set_xo_var(&result, &x, (int)oddness);
+    int valid = secp256k1_ge_set_xo_var(&result, &x, (int)oddness);
     result.infinity = (int)infinity;
 
-    secp256k1_gej_set_ge(reinterpret_cast<secp256k1_gej *>(g_), &result);
+    secp256k1_gej_set_ge(r, &result);
+    return valid || result.infinity;
+}
 
-    if (!secp256k1_ge_is_valid_var(&result) && !result.infinity) {
+const unsigned char* GroupElement::deserialize(const unsigned char* buffer) {
+    if (!decompress(reinterpret_cast<secp256k1_gej *>(g_), buffer)) {
         throw std::invalid_argument("GroupElement: deserialize failed");
     }
     return buffer + memoryRequired();
 }
 
+const unsigned char* GroupElement::deserialize_batch(const unsigned char* buffer, GroupElement* elements, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++, buffer += memoryRequired()) {
+        if (!decompress(reinterpret_cast<secp256k1_gej *>(elements[i].g_), buffer)) {
+            throw std::invalid_argument("GroupElement: deserialize failed");
+        }
+    }
+    return buffer;
+}
+
+unsigned char* GroupElement::serialize_batch(const GroupElement* elements, std::size_t n, unsigned char* buffer) {
+    std::vector<const secp256k1_gej *> points(n);
+    for (std::size_t i = 0; i < n; i++)
+        points[i] = reinterpret_cast<const secp256k1_gej *>(elements[i].g_);
+    std::vector<secp256k1_ge> affine;
+    gej_to_ge_batch(points, affine);
+    for (std::size_t i = 0; i < n; i++, buffer += memoryRequired()) {
+        secp256k1_fe x = affine[i].x;
+        secp256k1_fe y = affine[i].y;
+        secp256k1_fe_normalize(&x);
+        secp256k1_fe_normalize(&y);
+        secp256k1_fe_get_b32(buffer, &x);
+        buffer[32] = secp256k1_fe_is_odd(&y);
+        buffer[33] = affine[i].infinity;
+    }
+    return buffer;
+}
+
+void GroupElement::normalize_batch(GroupElement* elements, std::size_t n) {
+    std::vector<const secp256k1_gej *> points(n);
+    for (std::size_t i = 0; i < n; i++)
+        points[i] = reinterpret_cast<const secp256k1_gej *>(elements[i].g_);
+    std::vector<secp256k1_ge> affine;
+    gej_to_ge_batch(points, affine);
+    for (std::size_t i = 0; i < n; i++) {
+        if (!affine[i].infinity)
+            secp256k1_gej_set_ge(reinterpret_cast<secp256k1_gej *>(elements[i].g_), &affine[i]);
+    }
+}
+
 std::vector<unsigned char> GroupElement::getvch() const {
     unsigned char buffer[memoryRequired()];
     serialize(buffer);
@@ -28,6 +28,10 @@
 #include "definition.h"
 #include <boost/optional.hpp>
 
+namespace secp_primitives {
+class GroupElement;
+}
+
 
 static const unsigned int MAX_SIZE = 0x02000000;
 
@@ -717,9 +721,11 @@ template<typename Stream, unsigned int N, typename T> inline void Unserialize(St
  */
 template<typename Stream, typename T, typename A> void Serialize_impl(Stream& os, const std::vector<T, A>& v, const unsigned char&);
 template<typename Stream, typename T, typename A, typename V> void Serialize_impl(Stream& os, const std::vector<T, A>& v, const V&);
+template<typename Stream, typename A> void Serialize_impl(Stream& os, const std::vector<secp_primitives::GroupElement, A>& v, const secp_primitives::GroupElement&);
 template<typename Stream, typename T, typename A> inline void Serialize(Stream& os, const std::vector<T, A>& v);
 template<typename Stream, typename T, typename A> void Unserialize_impl(Stream& is, std::vector<T, A>& v, const unsigned char&);
 template<typename Stream, typename T, typename A, typename V> void Unserialize_impl(Stream& is, std::vector<T, A>& v, const V&);
+template<typename Stream, typename A> void Unserialize_impl(Stream& is, std::vector<secp_primitives::GroupElement, A>& v, const secp_primitives::GroupElement&);
 template<typename Stream, typename T, typename A> inline void Unserialize(Stream& is, std::vector<T, A>& v);
 
 /**
@@ -923,6 +929,17 @@ void Serialize_impl(Stream& os, const std::vector<T, A>& v, const V&)
         ::Serialize(os, (*vi));
 }
 
+template<typename Stream, typename A>
+void Serialize_impl(Stream& os, const std::vector<secp_primitives::GroupElement, A>& v, const secp_primitives::GroupElement&)
+{
+    // one field inversion for all points of the vector instead of one per point
+    typedef typename std::vector<secp_primitives::GroupElement, A>::value_type Element;
+    WriteCompactSize(os, v.size());
+    std::vector<unsigned char> vBuffer(v.size() * Element::serialize_size);
+    Element::serialize_batch(v.data(), v.size(), vBuffer.data());
+    os.write((const char*)vBuffer.data(), vBuffer.size());
+}
+
 template<typename Stream, typename T, typename A>
 inline void Serialize(Stream& os, const std::vector<T, A>& v)
 {
@@ -964,6 +981,27 @@ void Unserialize_impl(Stream& is, std::vector<T, A>& v, const V&)
     }
 }
 
+template<typename Stream, typename A>
+void Unserialize_impl(Stream& is, std::vector<secp_primitives::GroupElement, A>& v, const secp_primitives::GroupElement&)
+{
+    // Points of proofs come in vectors, read them in blocks and decompress a
+    // whole block at once instead of going through the stream per point
+    typedef typename std::vector<secp_primitives::GroupElement, A>::value_type Element;
+    v.clear();
+    unsigned int nSize = ReadCompactSize(is);
+    std::vector<unsigned char> vBuffer;
+    unsigned int i = 0;
+    while (i < nSize)
+    {
+        unsigned int blk = std::min(nSize - i, (unsigned int)(1 + 4999999 / Element::serialize_size));
+        vBuffer.resize(blk * Element::serialize_size);
+        is.read((char*)vBuffer.data(), vBuffer.size());
+        v.resize(i + blk);
+        Element::deserialize_batch(vBuffer.data(), &v[i], blk);
+        i += blk;
+    }
+}
+
 template<typename Stream, typename T, typename A>
 inline void Unserialize(Stream& is, std::vector<T, A>& v)
 {
@@ -524,8 +524,8 @@ void CSparkWallet::UpdateSpendStateFromBlock(const CBlock& block) {
         for (const auto& tx : transactions) {
             if (tx->IsSparkSpend()) {
                 try {
-                    spark::SpendTransaction spend = spark::ParseSparkSpend(*tx);
-                    const auto& txLTags = spend.getUsedLTags();
+                    std::shared_ptr<const spark::SpendTransaction> spend = spark::GetParsedSparkSpend(*tx);
+                    const auto& txLTags = spend->getUsedLTags();
                     for (const auto& txLTag : txLTags) {
                         uint256 txHash = tx->GetHash();
                         uint256 lTagHash = primitives::GetLTagHash(txLTag);
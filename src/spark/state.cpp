@@ -4,6 +4,9 @@
 #include "sparkname.h"
 #include "../validation.h"
 #include "../batchproof_container.h"
+#include "../memusage.h"
+#include "../hash.h"
+#include "../perfstats.h"
 
 #include <set>
 
@@ -18,9 +21,13 @@ struct ProofCheckState {
 
     // if this is non-null, then the proof is being checked right now
     std::shared_ptr<boost::future<bool>> checkInProgress;
+
+    // cover sets the proof was (or is being) checked against, see GetCoverSetHash
+    uint256 coverSetHash;
 };
 
-// map from transaction hash to the state of checking its proofs
+// map from transaction hash to the state of checking its proofs, the result is
+// only reused if the spend resolves to the same cover sets again
 static std::map<uint256, ProofCheckState> gCheckedSparkSpendTransactions;
 static CCriticalSection cs_checkedSparkSpendTransactions;
 
@@ -166,12 +173,7 @@ void ParseSparkMintCoin(const CScript& script, spark::Coin& txCoin)
         throw std::invalid_argument("Script is not a valid Spark Mint");
     }
 
-    std::vector<unsigned char> serialized(script.begin() + 1, script.end());
-    CDataStream stream(
-            std::vector<unsigned char>(serialized.begin(), serialized.end()),
-            SER_NETWORK,
-            PROTOCOL_VERSION
-    );
+    SpanReader stream(SER_NETWORK, PROTOCOL_VERSION, script.data() + 1, script.data() + script.size());
 
     try {
         stream >> txCoin;
@@ -180,38 +182,42 @@ void ParseSparkMintCoin(const CScript& script, spark::Coin& txCoin)
     }
 }
 
-spark::SpendTransaction ParseSparkSpend(const CTransaction &tx)
+std::shared_ptr<const spark::SpendTransaction> GetParsedSparkSpend(const CTransaction &tx)
 {
+    std::shared_ptr<const spark::SpendTransaction> spend = tx.parsedSparkSpend.Get();
+    if (spend)
+        return spend;
+
     if (tx.vin.size() != 1 || tx.vin[0].scriptSig.size() < 1) {
         throw CBadTxIn();
     }
-    CDataStream serialized(SER_NETWORK, PROTOCOL_VERSION);
-
-    if (tx.vin[0].scriptSig[0] == OP_SPARKSPEND && tx.nVersion >= 3 && tx.nType == TRANSACTION_SPARK) {
-        serialized.write((const char *)tx.vExtraPayload.data(), tx.vExtraPayload.size());
-    }
-    else {
+    if (tx.vin[0].scriptSig[0] != OP_SPARKSPEND || tx.nVersion < 3 || tx.nType != TRANSACTION_SPARK) {
         throw CBadTxIn();
     }
+
+    // the proof is read straight from the payload, parsing validates every
+    // group element so it is only done once per transaction
     const spark::Params* params = spark::Params::get_default();
-    spark::SpendTransaction spendTransaction(params);
-    serialized >> spendTransaction;
-    return spendTransaction;
+    std::shared_ptr<spark::SpendTransaction> parsed = std::make_shared<spark::SpendTransaction>(params);
+    SpanReader serialized(SER_NETWORK, PROTOCOL_VERSION, tx.vExtraPayload.data(), tx.vExtraPayload.data() + tx.vExtraPayload.size());
+    serialized >> *parsed;
+    tx.parsedSparkSpend.Set(parsed);
+    return parsed;
+}
+
+spark::SpendTransaction ParseSparkSpend(const CTransaction &tx)
+{
+    return *GetParsedSparkSpend(tx);
 }
 
 
 std::vector<GroupElement> GetSparkUsedTags(const CTransaction &tx)
 {
-    const spark::Params* params = spark::Params::get_default();
-
-    spark::SpendTransaction spendTransaction(params);
     try {
-        spendTransaction = ParseSparkSpend(tx);
+        return GetParsedSparkSpend(tx)->getUsedLTags();
     } catch (const std::exception &) {
         return std::vector<GroupElement>();
     }
-
-    return  spendTransaction.getUsedLTags();
 }
 
 std::vector<spark::Coin> GetSparkMintCoins(const CTransaction &tx)
@@ -423,10 +429,10 @@ void RemoveSpendReferencingBlock(CTxMemPool& pool, CBlockIndex* blockIndex) {
             // block removed. If any one is equal, remove txn from mempool.
             for (const CTxIn& txin : tx.vin) {
                 if (txin.scriptSig.IsSparkSpend()) {
-                    std::unique_ptr<spark::SpendTransaction> sparkSpend;
+                    std::shared_ptr<const spark::SpendTransaction> sparkSpend;
 
                     try {
-                        sparkSpend = std::make_unique<spark::SpendTransaction>(ParseSparkSpend(tx));
+                        sparkSpend = GetParsedSparkSpend(tx);
                     }
                     catch (const std::exception &) {
                         txn_to_remove.push_back(tx);
@@ -587,6 +593,38 @@ bool CheckSparkSMintTransaction(
     return true;
 }
 
+// Collect the coins of group groupId (and of the previous group where the
+// blocks are shared) from index down to firstBlock. Returns the number of
+// coins, the coins themselves are only copied if cover_set is non-null
+static std::size_t GetCoverSetCoins(
+        CBlockIndex *index,
+        const CBlockIndex *firstBlock,
+        int groupId,
+        std::vector<Coin> *cover_set) {
+    std::size_t set_size = 0;
+    while (true) {
+        int id = 0;
+        if (CountCoinInBlock(index, groupId)) {
+            id = groupId;
+        } else if (CountCoinInBlock(index, groupId - 1)) {
+            id = groupId - 1;
+        }
+        if (id) {
+            auto it = index->sparkMintedCoins.find(id);
+            if (it != index->sparkMintedCoins.end()) {
+                set_size += it->second.size();
+                if (cover_set)
+                    cover_set->insert(cover_set->end(), it->second.begin(), it->second.end());
+            }
+        }
+
+        if (index == firstBlock)
+            break;
+        index = index->pprev;
+    }
+    return set_size;
+}
+
 bool CheckSparkSpendTransaction(
         const CTransaction &tx,
         CValidationState &state,
@@ -597,18 +635,19 @@ bool CheckSparkSpendTransaction(
         bool fStatefulSigmaCheck,
         CSparkTxInfo* sparkTxInfo) {
 
+    // result of an earlier check of the proof and the cover sets it was checked against,
+    // it is only trusted once the cover sets of this check turn out to be the same
     bool fChecked = false;
+    bool fCheckedResult = false;
+    uint256 checkedCoverSetHash;
     {
         LOCK(cs_checkedSparkSpendTransactions);
         if (gCheckedSparkSpendTransactions.count(hashTx)) {
             auto& checkState = gCheckedSparkSpendTransactions[hashTx];
             if (checkState.fChecked) {
-                if (!checkState.fResult)
-                    return state.DoS(100, false, REJECT_INVALID, "CheckSparkSpendTransaction: previously checked and failed");
-                else {
-                    LogPrintf("CheckSparkSpendTransaction: already checked tx %s\n", hashTx.ToString());
-                    fChecked = true;
-                }
+                fChecked = true;
+                fCheckedResult = checkState.fResult;
+                checkedCoverSetHash = checkState.coverSetHash;
             }
             // If the check is in progress and we are doing a stateful check, we need to wait
             else if (checkState.checkInProgress && fStatefulSigmaCheck) {
@@ -622,10 +661,9 @@ bool CheckSparkSpendTransaction(
                 checkState.fResult = result;
                 checkState.checkInProgress = nullptr;
 
-                if (!result)
-                    return state.DoS(100, false, REJECT_INVALID, "CheckSparkSpendTransaction: previously checked and failed");
-                else
-                    fChecked = true;
+                fChecked = true;
+                fCheckedResult = result;
+                checkedCoverSetHash = checkState.coverSetHash;
             }
         }
     }
@@ -715,6 +753,12 @@ bool CheckSparkSpendTransaction(
     BatchProofContainer* batchProofContainer = BatchProofContainer::get_instance();
     bool useBatching = batchProofContainer->fCollectProofs && !isVerifyDB && !isCheckWallet && sparkTxInfo && !sparkTxInfo->fInfoIsComplete;
 
+    // the coins are only needed if the proof is going to be verified here
+    bool fCollectCoins = !useBatching && !fChecked;
+    // first and last block of every cover set, to collect the coins later if the cached result can't be used
+    std::map<uint64_t, std::pair<CBlockIndex*, CBlockIndex*>> cover_set_blocks;
+    CHashWriter coverSetHasher(SER_GETHASH, PROTOCOL_VERSION);
+
     for (const auto& idAndHash : idAndBlockHashes) {
         CSparkState::SparkCoinGroupInfo coinGroup;
         if (!sparkState.GetCoinGroupInfo(idAndHash.first, coinGroup)) {
@@ -740,34 +784,16 @@ bool CheckSparkSpendTransaction(
         std::vector<unsigned char> set_hash = GetAnonymitySetHash(index, idAndHash.first);
 
         std::vector<Coin> cover_set;
-        cover_set.reserve(coinGroup.nCoins);
-        std::size_t set_size = 0;
+        if (fCollectCoins)
+            cover_set.reserve(coinGroup.nCoins);
         // Build a vector with all the public coins with given id before
         // the block on which the spend occurred.
         // This list of public coins is required by function "Verify" of spend.
-        while (true) {
-            int id = 0;
-            if (CountCoinInBlock(index, idAndHash.first)) {
-                id = idAndHash.first;
-            } else if (CountCoinInBlock(index, idAndHash.first - 1)) {
-                id = idAndHash.first - 1;
-            }
-            if (id) {
-                if (index->sparkMintedCoins.count(id) > 0) {
-                    BOOST_FOREACH(
-                    const auto& coin,
-                    index->sparkMintedCoins[id]) {
-                        set_size++;
-                        if (!useBatching)
-                            cover_set.push_back(coin);
-                    }
-                }
-            }
+        std::size_t set_size = GetCoverSetCoins(index, coinGroup.firstBlock, idAndHash.first, fCollectCoins ? &cover_set : nullptr);
+        cover_set_blocks[idAndHash.first] = std::make_pair(index, coinGroup.firstBlock);
 
-            if (index == coinGroup.firstBlock)
-                break;
-            index = index->pprev;
-        }
+        // the blocks the cover set spans determine its coins
+        coverSetHasher << idAndHash.first << index->GetBlockHash() << coinGroup.firstBlock->GetBlockHash() << (uint64_t)set_size << set_hash;
 
         CoverSetData setData;
         setData.cover_set_size = set_size;
@@ -787,55 +813,75 @@ bool CheckSparkSpendTransaction(
             return fStatefulSigmaCheck ? state.DoS(100,
                              error("CheckSparkSpendTransaction: No cover set found.")) : true;
     }
-    
+
+    uint256 coverSetHash = coverSetHasher.GetHash();
+    if (fChecked && checkedCoverSetHash != coverSetHash) {
+        // the proof was checked against other cover sets (e.g. before a reorg), check it again
+        LogPrintf("CheckSparkSpendTransaction: cover sets of tx %s changed since it was checked\n", hashTx.ToString());
+        fChecked = false;
+        if (!useBatching) {
+            for (auto& idAndBlocks : cover_set_blocks) {
+                auto& cover_set = cover_sets[idAndBlocks.first];
+                GetCoverSetCoins(idAndBlocks.second.first, idAndBlocks.second.second, idAndBlocks.first, &cover_set);
+            }
+        }
+    }
+
+    if (fChecked && !fCheckedResult)
+        return state.DoS(100, false, REJECT_INVALID, "CheckSparkSpendTransaction: previously checked and failed");
+
     // if we are collecting proofs, skip verification and collect proofs
     // add proofs into container
-    if (useBatching) {
+    if (fChecked) {
+        // the proof was already checked against the same cover sets and it passed,
+        // only the stateful checks below remain
+        LogPrintf("CheckSparkSpendTransaction: already checked tx %s\n", hashTx.ToString());
+        PERF_COUNT("spark_proof_cache_hits", 1);
+        passVerify = true;
+    } else if (useBatching) {
         passVerify = true;
         batchProofContainer->add(*spend);
     } else {
         try {
-            if (fChecked) {
-                // if we are here, then the proof was already checked and it passed
-                passVerify = true;
+            if (fStatefulSigmaCheck) {
+                // we need the answer now, so verify and execute
+                PERF_SCOPE("spark_verify_spend");
+                passVerify = spark::SpendTransaction::verify(*spend, cover_sets);
             }
             else {
-                if (fStatefulSigmaCheck) {
-                    // we need the answer now, so verify and execute
-                    passVerify = spark::SpendTransaction::verify(*spend, cover_sets);
-                }
-                else {
-                    LOCK(cs_checkedSparkSpendTransactions);
-                    if (gCheckProofThreadPool.IsPoolShutdown())
-                        // if we are shutting down, don't start any new tasks
-                        return true;
-
-                    // put the proof into the thread pool for verification
-                    auto future = gCheckProofThreadPool.PostTask([spend, cover_sets]() {
-                        try {
-                            return spark::SpendTransaction::verify(*spend, cover_sets);
-                        } catch (const std::exception &) {
-                            return false;
-                        }
-                    });
-                    auto &checkState = gCheckedSparkSpendTransactions[hashTx];
-                    checkState.fChecked = false;
-                    checkState.checkInProgress = std::make_shared<boost::future<bool>>(std::move(future));
-                    // return true for now, the result will be processed later
+                LOCK(cs_checkedSparkSpendTransactions);
+                if (gCheckProofThreadPool.IsPoolShutdown())
+                    // if we are shutting down, don't start any new tasks
                     return true;
-                }
+
+                // put the proof into the thread pool for verification
+                auto future = gCheckProofThreadPool.PostTask([spend, cover_sets]() {
+                    try {
+                        PERF_SCOPE("spark_verify_spend");
+                        return spark::SpendTransaction::verify(*spend, cover_sets);
+                    } catch (const std::exception &) {
+                        return false;
+                    }
+                });
+                auto &checkState = gCheckedSparkSpendTransactions[hashTx];
+                checkState.fChecked = false;
+                checkState.checkInProgress = std::make_shared<boost::future<bool>>(std::move(future));
+                checkState.coverSetHash = coverSetHash;
+                // return true for now, the result will be processed later
+                return true;
             }
         } catch (const std::exception &) {
             passVerify = false;
         }
 
         // remember the result of the check
-        if (!fChecked) {
+        {
             LOCK(cs_checkedSparkSpendTransactions);
             auto &checkState = gCheckedSparkSpendTransactions[hashTx];
             checkState.fChecked = true;
             checkState.fResult = passVerify;
             checkState.checkInProgress = nullptr;
+            checkState.coverSetHash = coverSetHash;
         }
     }
 
@@ -1055,8 +1101,7 @@ std::vector<unsigned char> getSerialContext(const CTransaction &tx) {
     CDataStream serialContextStream(SER_NETWORK, PROTOCOL_VERSION);
     if (tx.IsSparkSpend()) {
         try {
-            spark::SpendTransaction spend = ParseSparkSpend(tx);
-            serialContextStream << spend.getUsedLTags();
+            serialContextStream << GetParsedSparkSpend(tx)->getUsedLTags();
         } catch (const std::exception &) {
             return std::vector<unsigned char>();
         }
@@ -1162,9 +1207,15 @@ bool CSparkState::IsUsedLTag(const GroupElement& lTag) {
 }
 
 bool CSparkState::IsUsedLTagHash(GroupElement& lTag, const uint256 &coinLTaglHash) {
-    for ( auto it = GetSpends().begin(); it != GetSpends().end(); ++it ) {
-        if (primitives::GetLTagHash(it->first) == coinLTaglHash) {
-            lTag = it->first;
+    // same as primitives::GetLTagHash, on the serialized tags the spends map is keyed by
+    CDataStream ss(SER_GETHASH, 0);
+    ss << "tag_hash";
+    size_t nPrefixSize = ss.size();
+    for (auto it = GetSpends().begin(); it != GetSpends().end(); ++it) {
+        ss.resize(nPrefixSize);
+        ss.write((const char*)it.data(), GroupElement::memoryRequired());
+        if (::Hash(ss.begin(), ss.end()) == coinLTaglHash) {
+            lTag = it.key();
             return true;
         }
     }
@@ -1270,7 +1321,7 @@ void CSparkState::RemoveSpend(const GroupElement& lTag) {
         }
     }
     if (iter != usedLTags.end()) {
-        spendMetaInfo[iter->second] -= 1;
+        spendMetaInfo[iter.value()] -= 1;
         usedLTags.erase(iter);
     }
 }
@@ -1643,7 +1694,7 @@ void CSparkState::GetCoinsForRecovery(
 std::unordered_map<spark::Coin, CMintedCoinInfo, spark::CoinHash> const & CSparkState::GetMints() const {
     return mintedCoins;
 }
-std::unordered_map<GroupElement, int, spark::CLTagHash> const & CSparkState::GetSpends() const {
+CTagMap<GroupElement, int> const & CSparkState::GetSpends() const {
     return usedLTags;
 }
 
@@ -1655,11 +1706,18 @@ std::unordered_map<uint256, uint256> const& CSparkState::GetSpendTxIds() const {
     return ltagTxhash;
 }
 
+std::size_t CSparkState::GetMemoryUsage() const {
+    return memusage::DynamicUsage(mintedCoins)
+        + memusage::DynamicUsage(usedLTags)
+        + memusage::DynamicUsage(ltagTxhash)
+        + memusage::DynamicUsage(coinGroups);
+}
+
 std::unordered_map<int, CSparkState::SparkCoinGroupInfo> const& CSparkState::GetCoinGroups() const {
     return coinGroups;
 }
 
-std::unordered_map<GroupElement, uint256, spark::CLTagHash> const& CSparkState::GetMempoolLTags() const {
+CTagMap<GroupElement, uint256> const& CSparkState::GetMempoolLTags() const {
     LOCK(mempool.cs);
     return mempool.sparkState.GetMempoolLTags();
 }
@@ -1708,7 +1766,7 @@ bool CSparkMempoolState::HasLTag(const GroupElement& lTag) {
 }
 
 bool CSparkMempoolState::AddSpendToMempool(const GroupElement& lTag, uint256 txHash) {
-    return mempoolLTags.insert({lTag, txHash}).second;
+    return mempoolLTags.insert(lTag, txHash);
 }
 
 void CSparkMempoolState::RemoveSpendFromMempool(const GroupElement& lTag) {
@@ -1716,10 +1774,11 @@ void CSparkMempoolState::RemoveSpendFromMempool(const GroupElement& lTag) {
 }
 
 uint256 CSparkMempoolState::GetMempoolConflictingTxHash(const GroupElement& lTag) {
-    if (mempoolLTags.count(lTag) == 0)
+    auto iter = mempoolLTags.find(lTag);
+    if (iter == mempoolLTags.end())
         return uint256();
 
-    return mempoolLTags[lTag];
+    return iter.value();
 }
 
 void CSparkMempoolState::Reset() {
@@ -12,6 +12,7 @@
 #include "../libspark/spend_transaction.h"
 #include "primitives.h"
 #include "sparkname.h"
+#include "../tagmap.h"
 
 namespace spark_mintspend { struct spark_mintspend_test; }
 
@@ -51,6 +52,9 @@ unsigned char GetNetworkType();
 void ParseSparkMintTransaction(const std::vector<CScript>& scripts, MintTransaction& mintTransaction);
 void ParseSparkMintCoin(const CScript& script, spark::Coin& txCoin);
 std::vector<unsigned char> getSerialContext(const CTransaction &tx);
+// Parsed once per transaction and shared, throws like ParseSparkSpend
+std::shared_ptr<const spark::SpendTransaction> GetParsedSparkSpend(const CTransaction &tx);
+// Modifiable copy of the parsed spend
 spark::SpendTransaction ParseSparkSpend(const CTransaction &tx);
 
 std::vector<GroupElement>  GetSparkUsedTags(const CTransaction &tx);
@@ -98,7 +102,7 @@ private:
     std::unordered_set<spark::Coin, spark::CoinHash> mempoolMints;
 
     // linking tags of spends currently in the mempool mapped to tx hashes
-    std::unordered_map<GroupElement, uint256, spark::CLTagHash> mempoolLTags;
+    CTagMap<GroupElement, uint256> mempoolLTags;
 
 public:
     // Check if there is a conflicting tx in the blockchain or mempool
@@ -118,7 +122,7 @@ public:
     // Get conflicting tx hash by coin serial number
     uint256 GetMempoolConflictingTxHash(const GroupElement& lTag);
 
-    std::unordered_map<GroupElement, uint256, spark::CLTagHash> const & GetMempoolLTags() const { return mempoolLTags; }
+    CTagMap<GroupElement, uint256> const & GetMempoolLTags() const { return mempoolLTags; }
 
     void Reset();
 };
@@ -239,15 +243,17 @@ public:
             std::vector<std::pair<spark::Coin, std::pair<uint256, std::vector<unsigned char>>>>& coins);
 
     std::unordered_map<spark::Coin, CMintedCoinInfo, spark::CoinHash> const & GetMints() const;
-    std::unordered_map<GroupElement, int, spark::CLTagHash> const & GetSpends() const;
+    CTagMap<GroupElement, int> const & GetSpends() const;
     std::vector<std::pair<GroupElement, int>> const & GetSpendsMobile() const;
     std::unordered_map<uint256, uint256> const& GetSpendTxIds() const;
     std::unordered_map<int, SparkCoinGroupInfo> const & GetCoinGroups() const;
-    std::unordered_map<GroupElement, uint256, spark::CLTagHash> const & GetMempoolLTags() const;
+    CTagMap<GroupElement, uint256> const & GetMempoolLTags() const;
 
     static CSparkState* GetState();
 
     std::size_t GetTotalCoins() const { return mintedCoins.size(); }
+    //! Approximate heap usage of the state maps, used to account the state against -dbcache
+    std::size_t GetMemoryUsage() const;
 
 private:
     size_t CountLastNCoins(int groupId, size_t required, CBlockIndex* &first);
@@ -266,7 +272,7 @@ private:
     // Set of all minted coins
     std::unordered_map<spark::Coin, CMintedCoinInfo, spark::CoinHash> mintedCoins;
     // Set of all used coin linking tags.
-    std::unordered_map<GroupElement, int, spark::CLTagHash> usedLTags;
+    CTagMap<GroupElement, int> usedLTags;
     // Set of all used linking tags, used only when -mobile=true
     std::vector<std::pair<GroupElement, int>> mobileUsedLTags;
     // linking tag hash mapped to tx hash
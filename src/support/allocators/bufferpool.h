@@ -0,0 +1,148 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_SUPPORT_ALLOCATORS_BUFFERPOOL_H
+#define BZX_SUPPORT_ALLOCATORS_BUFFERPOOL_H
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <stddef.h>
+
+/**
+ * Per thread cache of freed buffers, in power of two size classes.
+ *
+ * Serialization buffers are allocated and freed at a high rate with a few
+ * typical sizes, a freed buffer is kept for the next allocation of its size
+ * class on the same thread instead of going back to the heap. Buffers freed
+ * on another thread than they were allocated on simply move to that thread's
+ * cache. Buffers larger than MAX_SIZE are not cached and at most
+ * MAX_CACHED_BYTES are kept per thread.
+ */
+class CBufferPoolCache
+{
+public:
+    static const size_t MIN_SHIFT = 6;
+    static const size_t MAX_SHIFT = 22;
+    static const size_t MAX_SIZE = size_t(1) << MAX_SHIFT;
+    static const size_t MAX_CACHED_PER_CLASS = 4;
+    static const size_t MAX_CACHED_BYTES = 8 << 20;
+
+private:
+    static const size_t CLASSES = MAX_SHIFT - MIN_SHIFT + 1;
+
+    void* apFree[CLASSES][MAX_CACHED_PER_CLASS];
+    size_t anFree[CLASSES];
+    size_t nCachedBytes;
+    bool& fAlive;
+
+    static size_t SizeClass(size_t nBytes)
+    {
+        size_t nShift = MIN_SHIFT;
+        while ((size_t(1) << nShift) < nBytes)
+            nShift++;
+        return nShift - MIN_SHIFT;
+    }
+
+    explicit CBufferPoolCache(bool& fAliveIn) : anFree(), nCachedBytes(0), fAlive(fAliveIn) {}
+
+    static CBufferPoolCache* Get()
+    {
+        // buffers can still be freed by thread_local destructors that run
+        // after the cache of the thread is gone, those go to the heap
+        static thread_local bool fAliveThread = true;
+        if (!fAliveThread)
+            return nullptr;
+        static thread_local CBufferPoolCache cache(fAliveThread);
+        return &cache;
+    }
+
+public:
+    ~CBufferPoolCache()
+    {
+        fAlive = false;
+        for (size_t c = 0; c < CLASSES; c++) {
+            for (size_t i = 0; i < anFree[c]; i++)
+                ::operator delete(apFree[c][i]);
+        }
+    }
+
+    CBufferPoolCache(const CBufferPoolCache&) = delete;
+    CBufferPoolCache& operator=(const CBufferPoolCache&) = delete;
+
+    static void* Allocate(size_t nBytes)
+    {
+        if (nBytes > MAX_SIZE)
+            return ::operator new(nBytes);
+        size_t c = SizeClass(nBytes);
+        CBufferPoolCache* cache = Get();
+        if (cache && cache->anFree[c] > 0) {
+            cache->nCachedBytes -= size_t(1) << (c + MIN_SHIFT);
+            return cache->apFree[c][--cache->anFree[c]];
+        }
+        return ::operator new(size_t(1) << (c + MIN_SHIFT));
+    }
+
+    static void Free(void* p, size_t nBytes)
+    {
+        if (nBytes > MAX_SIZE) {
+            ::operator delete(p);
+            return;
+        }
+        size_t c = SizeClass(nBytes);
+        size_t nClassSize = size_t(1) << (c + MIN_SHIFT);
+        CBufferPoolCache* cache = Get();
+        if (cache && cache->anFree[c] < MAX_CACHED_PER_CLASS && cache->nCachedBytes + nClassSize <= MAX_CACHED_BYTES) {
+            cache->apFree[c][cache->anFree[c]++] = p;
+            cache->nCachedBytes += nClassSize;
+            return;
+        }
+        ::operator delete(p);
+    }
+};
+
+//
+// Allocator for buffers of public data: memory comes from the thread's
+// CBufferPoolCache and is not cleared when freed. Never use it for secrets.
+//
+template <typename T>
+struct buffer_pool_allocator : public std::allocator<T> {
+    using base = std::allocator<T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+
+    buffer_pool_allocator() throw() {}
+    buffer_pool_allocator(const buffer_pool_allocator& a) throw() : base(a) {}
+    template <typename U>
+    buffer_pool_allocator(const buffer_pool_allocator<U>& a) throw() : base(a)
+    {
+    }
+    ~buffer_pool_allocator() throw() {}
+    template <typename _Other>
+    struct rebind {
+        typedef buffer_pool_allocator<_Other> other;
+    };
+
+    T* allocate(std::size_t n, const void* hint = 0)
+    {
+        return static_cast<T*>(CBufferPoolCache::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (p != NULL)
+            CBufferPoolCache::Free(p, n * sizeof(T));
+    }
+};
+
+// Byte-vector for public data, recycled through the thread's buffer pool.
+typedef std::vector<char, buffer_pool_allocator<char> > CPublicSerializeData;
+
+#endif // BZX_SUPPORT_ALLOCATORS_BUFFERPOOL_H
@@ -0,0 +1,345 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_TAGMAP_H
+#define BZX_TAGMAP_H
+
+#include "crypto/common.h"
+#include "hash.h"
+#include "memusage.h"
+#include "random.h"
+#include "uint256.h"
+
+#include <secp256k1/include/GroupElement.h>
+#include <secp256k1/include/Scalar.h>
+
+#include <assert.h>
+#include <limits>
+#include <string.h>
+#include <vector>
+
+/**
+ * Fixed size encoding of the keys of a CTagMap, the normalized serialization
+ * of the key: two keys are equal exactly when their encodings are.
+ */
+template <typename T>
+struct CTagEncoding;
+
+/** Lelantus coin serials, big endian */
+template <>
+struct CTagEncoding<secp_primitives::Scalar>
+{
+    static constexpr size_t SIZE = 32;
+    static void Encode(const secp_primitives::Scalar& key, unsigned char* out) { key.serialize(out); }
+    static secp_primitives::Scalar Decode(const unsigned char* in)
+    {
+        secp_primitives::Scalar key;
+        key.deserialize(in);
+        return key;
+    }
+};
+
+/** Spark linking tags, affine x coordinate followed by the y parity and infinity flags */
+template <>
+struct CTagEncoding<secp_primitives::GroupElement>
+{
+    static constexpr size_t SIZE = 34;
+    static void Encode(const secp_primitives::GroupElement& key, unsigned char* out) { key.serialize(out); }
+    static secp_primitives::GroupElement Decode(const unsigned char* in)
+    {
+        secp_primitives::GroupElement key;
+        key.deserialize(in);
+        return key;
+    }
+};
+
+/** Transaction ids, as serialized */
+template <>
+struct CTagEncoding<uint256>
+{
+    static constexpr size_t SIZE = 32;
+    static void Encode(const uint256& key, unsigned char* out) { memcpy(out, key.begin(), SIZE); }
+    static uint256 Decode(const unsigned char* in)
+    {
+        uint256 key;
+        memcpy(key.begin(), in, SIZE);
+        return key;
+    }
+};
+
+/**
+ * Open addressing hash map for spent coin serials and linking tags, also
+ * used for transaction ids.
+ *
+ * std::unordered_map<GroupElement, ...> allocates a node per entry pointing
+ * to a heap allocated Jacobian point, and hashing or comparing a key converts
+ * it to affine coordinates. Here the keys are stored inline as their
+ * CTagEncoding, so a key is normalized once per lookup and probing compares
+ * plain bytes.
+ *
+ * The layout follows the "swiss table" design: every slot has a control byte
+ * holding 7 bits of the key hash, or marking the slot empty or deleted.
+ * Lookups load the control bytes of 8 consecutive slots at once and compare
+ * them against the hash with a few word operations, keys are only compared
+ * for slots whose control byte matches. The table is grown at 7/8 load.
+ * Hashes are salted per map, so colliding tags can't be ground offline.
+ */
+template <typename T, typename V>
+class CTagMap
+{
+public:
+    typedef T key_type;
+    typedef V mapped_type;
+    typedef size_t size_type;
+    static constexpr size_t KEY_SIZE = CTagEncoding<T>::SIZE;
+
+private:
+    static constexpr size_t GROUP = 8;
+    static constexpr unsigned char CTRL_EMPTY = 0x80;
+    static constexpr unsigned char CTRL_DELETED = 0xfe;
+
+    //! capacity + GROUP control bytes, the last GROUP mirror the first ones
+    //! so a group can be loaded at any slot without wrapping
+    std::vector<unsigned char> vCtrl;
+    std::vector<unsigned char> vKeys;
+    std::vector<V> vValues;
+    size_t nCapacity;
+    size_t nSize;
+    //! Slots left to fill before the table is rehashed
+    size_t nGrowthLeft;
+    uint64_t k0, k1;
+
+    static uint64_t Repeat(unsigned char c) { return 0x0101010101010101ULL * c; }
+
+    uint64_t Hash(const unsigned char* key) const
+    {
+        uint256 val;
+        memcpy(val.begin(), key, 32);
+        uint32_t extra = 0;
+        for (size_t i = 32; i < KEY_SIZE; i++)
+            extra |= uint32_t(key[i]) << (8 * (i - 32));
+        return SipHashUint256Extra(k0, k1, val, extra);
+    }
+
+    void SetCtrl(size_t i, unsigned char c)
+    {
+        vCtrl[i] = c;
+        if (i < GROUP)
+            vCtrl[nCapacity + i] = c;
+    }
+
+    const unsigned char* KeyAt(size_t i) const { return &vKeys[i * KEY_SIZE]; }
+
+    /** Slot of the key, or nCapacity if it isn't in the map */
+    size_t Find(const unsigned char* key, uint64_t hash) const
+    {
+        if (nSize == 0)
+            return nCapacity;
+        const size_t mask = nCapacity - 1;
+        const uint64_t h2 = Repeat(hash & 0x7f);
+        size_t pos = (hash >> 7) & mask;
+        for (size_t step = GROUP; true; step += GROUP) {
+            uint64_t group = ReadLE64(&vCtrl[pos]);
+            // bytes equal to h2 become zero, the top bit is set for those
+            // (and rarely for a neighbour of one, the key compare sorts that out)
+            uint64_t x = group ^ h2;
+            uint64_t match = (x - Repeat(0x01)) & ~x & Repeat(0x80);
+            for (size_t j = 0; match; j++, match >>= 8) {
+                if ((match & 0x80) == 0)
+                    continue;
+                size_t i = (pos + j) & mask;
+                if (memcmp(KeyAt(i), key, KEY_SIZE) == 0)
+                    return i;
+            }
+            // an empty slot ends the probe sequence, deleted slots don't
+            if (group & (~group << 6) & Repeat(0x80))
+                return nCapacity;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /** First empty or deleted slot on the probe sequence of hash */
+    size_t FindFree(uint64_t hash) const
+    {
+        const size_t mask = nCapacity - 1;
+        size_t pos = (hash >> 7) & mask;
+        for (size_t step = GROUP; true; step += GROUP) {
+            uint64_t free = ReadLE64(&vCtrl[pos]) & Repeat(0x80);
+            for (size_t j = 0; free; j++, free >>= 8) {
+                if (free & 0x80)
+                    return (pos + j) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    void Rehash(size_t nNewCapacity)
+    {
+        std::vector<unsigned char> vOldCtrl;
+        std::vector<unsigned char> vOldKeys;
+        std::vector<V> vOldValues;
+        vOldCtrl.swap(vCtrl);
+        vOldKeys.swap(vKeys);
+        vOldValues.swap(vValues);
+        size_t nOldCapacity = nCapacity;
+
+        nCapacity = nNewCapacity;
+        vCtrl.assign(nCapacity + GROUP, CTRL_EMPTY);
+        vKeys.resize(nCapacity * KEY_SIZE);
+        vValues.resize(nCapacity);
+        nGrowthLeft = nCapacity - nCapacity / 8 - nSize;
+
+        for (size_t i = 0; i < nOldCapacity; i++) {
+            if (vOldCtrl[i] & 0x80)
+                continue;
+            const unsigned char* key = &vOldKeys[i * KEY_SIZE];
+            uint64_t hash = Hash(key);
+            size_t slot = FindFree(hash);
+            SetCtrl(slot, hash & 0x7f);
+            memcpy(&vKeys[slot * KEY_SIZE], key, KEY_SIZE);
+            vValues[slot] = std::move(vOldValues[i]);
+        }
+    }
+
+    /** Slot for a new key, growing the table or dropping tombstones if needed */
+    size_t Reserve(uint64_t hash)
+    {
+        size_t slot = FindFree(hash);
+        if (nGrowthLeft == 0 && vCtrl[slot] == CTRL_EMPTY) {
+            // plenty of tombstones: rehash in place, otherwise grow
+            Rehash(nSize * 2 >= nCapacity - nCapacity / 8 ? nCapacity * 2 : nCapacity);
+            slot = FindFree(hash);
+        }
+        if (vCtrl[slot] == CTRL_EMPTY)
+            nGrowthLeft--;
+        SetCtrl(slot, hash & 0x7f);
+        nSize++;
+        return slot;
+    }
+
+public:
+    class const_iterator
+    {
+    private:
+        const CTagMap* map;
+        size_t i;
+
+        void Skip()
+        {
+            while (i < map->nCapacity && (map->vCtrl[i] & 0x80))
+                i++;
+        }
+
+    public:
+        const_iterator(const CTagMap* mapIn, size_t iIn) : map(mapIn), i(iIn) { Skip(); }
+
+        //! Encoded key, see CTagEncoding
+        const unsigned char* data() const { return map->KeyAt(i); }
+        T key() const { return CTagEncoding<T>::Decode(data()); }
+        const V& value() const { return map->vValues[i]; }
+        size_t slot() const { return i; }
+
+        const_iterator& operator++() { i++; Skip(); return *this; }
+        bool operator==(const const_iterator& other) const { return i == other.i; }
+        bool operator!=(const const_iterator& other) const { return i != other.i; }
+    };
+
+    CTagMap() :
+        k0(GetRand(std::numeric_limits<uint64_t>::max())),
+        k1(GetRand(std::numeric_limits<uint64_t>::max()))
+    {
+        clear();
+    }
+
+    size_type size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, nCapacity); }
+
+    const_iterator find(const T& key) const
+    {
+        unsigned char buf[KEY_SIZE];
+        CTagEncoding<T>::Encode(key, buf);
+        return const_iterator(this, Find(buf, Hash(buf)));
+    }
+
+    size_type count(const T& key) const { return find(key) != end(); }
+
+    /** Add key with value, false if key is already in the map */
+    bool insert(const T& key, const V& value)
+    {
+        unsigned char buf[KEY_SIZE];
+        CTagEncoding<T>::Encode(key, buf);
+        uint64_t hash = Hash(buf);
+        if (Find(buf, hash) != nCapacity)
+            return false;
+        size_t slot = Reserve(hash);
+        memcpy(&vKeys[slot * KEY_SIZE], buf, KEY_SIZE);
+        vValues[slot] = value;
+        return true;
+    }
+
+    V& operator[](const T& key)
+    {
+        unsigned char buf[KEY_SIZE];
+        CTagEncoding<T>::Encode(key, buf);
+        uint64_t hash = Hash(buf);
+        size_t slot = Find(buf, hash);
+        if (slot == nCapacity) {
+            slot = Reserve(hash);
+            memcpy(&vKeys[slot * KEY_SIZE], buf, KEY_SIZE);
+            vValues[slot] = V();
+        }
+        return vValues[slot];
+    }
+
+    void erase(const const_iterator& it)
+    {
+        assert(it != end());
+        SetCtrl(it.slot(), CTRL_DELETED);
+        vValues[it.slot()] = V();
+        nSize--;
+    }
+
+    size_type erase(const T& key)
+    {
+        const_iterator it = find(key);
+        if (it == end())
+            return 0;
+        erase(it);
+        return 1;
+    }
+
+    void clear()
+    {
+        nCapacity = GROUP;
+        nSize = 0;
+        vCtrl.assign(nCapacity + GROUP, CTRL_EMPTY);
+        vKeys.assign(nCapacity * KEY_SIZE, 0);
+        vValues.assign(nCapacity, V());
+        nGrowthLeft = nCapacity - nCapacity / 8;
+        vCtrl.shrink_to_fit();
+        vKeys.shrink_to_fit();
+        vValues.shrink_to_fit();
+    }
+
+    size_t DynamicMemoryUsage() const
+    {
+        return memusage::DynamicUsage(vCtrl) + memusage::DynamicUsage(vKeys) + memusage::DynamicUsage(vValues);
+    }
+};
+
+namespace memusage
+{
+
+template <typename T, typename V>
+static inline size_t DynamicUsage(const CTagMap<T, V>& m)
+{
+    return m.DynamicMemoryUsage();
+}
+
+}
+
+#endif // BZX_TAGMAP_H
@@ -0,0 +1,115 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bls/bls_worker.h"
+
+#include "random.h"
+#include "test/test_bitcoinzero.h"
+
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+static const size_t QUORUM_SIZE = 24;
+static const int QUORUM_THRESHOLD = 5;
+
+/**
+ * Every member generates a contribution for the quorum, forId receives one
+ * secret key share from every member together with their verification vectors
+ */
+static void GenerateReceivedContributions(CBLSWorker& worker, const BLSIdVector& ids, size_t forIndex,
+                                          std::vector<BLSVerificationVectorPtr>& vvecsRet, BLSSecretKeyVector& skSharesRet)
+{
+    vvecsRet.clear();
+    skSharesRet.clear();
+    for (size_t i = 0; i < ids.size(); i++) {
+        BLSVerificationVectorPtr vvec;
+        BLSSecretKeyVector skShares;
+        BOOST_REQUIRE(worker.GenerateContributions(QUORUM_THRESHOLD, ids, vvec, skShares));
+        vvecsRet.emplace_back(vvec);
+        skSharesRet.emplace_back(skShares[forIndex]);
+    }
+}
+
+/** Checks that exactly the members in vBad fail, with and without batching */
+static void CheckBadMembers(CBLSWorker& worker, const CBLSId& forId, const std::vector<BLSVerificationVectorPtr>& vvecs,
+                            const BLSSecretKeyVector& skShares, const std::set<size_t>& vBad)
+{
+    std::vector<bool> aggregated = worker.VerifyContributionShares(forId, vvecs, skShares, true, true);
+    std::vector<bool> oneByOne = worker.VerifyContributionShares(forId, vvecs, skShares, true, false);
+    BOOST_REQUIRE_EQUAL(aggregated.size(), skShares.size());
+    BOOST_CHECK(aggregated == oneByOne);
+    for (size_t i = 0; i < aggregated.size(); i++)
+        BOOST_CHECK_EQUAL(aggregated[i], vBad.count(i) == 0);
+}
+
+BOOST_FIXTURE_TEST_SUITE(bls_worker_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(verify_contribution_shares_batch)
+{
+    FastRandomContext rng(true);
+    CBLSWorker worker;
+    worker.Start();
+
+    BLSIdVector ids;
+    for (size_t i = 0; i < QUORUM_SIZE; i++)
+        ids.emplace_back(CBLSId(TestHash(i)));
+    const size_t forIndex = 3;
+
+    std::vector<BLSVerificationVectorPtr> vvecs;
+    BLSSecretKeyVector skShares;
+    GenerateReceivedContributions(worker, ids, forIndex, vvecs, skShares);
+
+    // all contributions are valid
+    CheckBadMembers(worker, ids[forIndex], vvecs, skShares, {});
+
+    // a share meant for another member is a valid key but a bad contribution
+    auto corrupt = [&](const std::set<size_t>& vBad) {
+        BLSSecretKeyVector badShares = skShares;
+        for (size_t i : vBad) {
+            CBLSSecretKey other;
+            other.MakeNewKey();
+            badShares[i] = other;
+        }
+        CheckBadMembers(worker, ids[forIndex], vvecs, badShares, vBad);
+    };
+
+    // one bad contribution at the edges of the batch halves and in between
+    for (size_t i : {size_t(0), QUORUM_SIZE / 2 - 1, QUORUM_SIZE / 2, QUORUM_SIZE - 1, size_t(rng.randrange(QUORUM_SIZE))})
+        corrupt({i});
+
+    // two bad contributions, next to each other, in the same half and in different halves
+    corrupt({5, 6});
+    corrupt({1, 9});
+    corrupt({2, QUORUM_SIZE - 2});
+    for (int i = 0; i < 4; i++) {
+        size_t a = rng.randrange(QUORUM_SIZE);
+        size_t b = (a + 1 + rng.randrange(QUORUM_SIZE - 1)) % QUORUM_SIZE;
+        corrupt({a, b});
+    }
+
+    // a missing share is never treated as valid
+    {
+        BLSSecretKeyVector badShares = skShares;
+        badShares[4] = CBLSSecretKey();
+        CheckBadMembers(worker, ids[forIndex], vvecs, badShares, {4});
+        badShares[13] = CBLSSecretKey();
+        CBLSSecretKey other;
+        other.MakeNewKey();
+        badShares[20] = other;
+        CheckBadMembers(worker, ids[forIndex], vvecs, badShares, {4, 13, 20});
+    }
+
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(verify_contribution_shares_empty)
+{
+    CBLSWorker worker;
+    worker.Start();
+    BOOST_CHECK(worker.VerifyContributionShares(CBLSId(TestHash(0)), {}, {}, true, true).empty());
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,195 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinstats.h"
+
+#include "chain.h"
+#include "coins.h"
+#include "hash.h"
+#include "random.h"
+#include "sync.h"
+#include "test/test_bitcoinzero.h"
+#include "validation.h"
+#include "version.h"
+
+#include <map>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+/** Coins view over a sorted map, in the key order of the chainstate database */
+class CCoinsViewMap : public CCoinsView
+{
+public:
+    std::map<COutPoint, Coin> mapCoins;
+    uint256 hashBestBlock;
+
+    class MapCursor : public CCoinsViewCursor
+    {
+    public:
+        MapCursor(const CCoinsViewMap& view, const uint256& hashFrom) :
+            CCoinsViewCursor(view.hashBestBlock), map(view.mapCoins), it(map.lower_bound(COutPoint(hashFrom, 0))) {}
+
+        bool GetKey(COutPoint& key) const override { key = it->first; return true; }
+        bool GetValue(Coin& coin) const override { coin = it->second; return true; }
+        unsigned int GetValueSize() const override { return 0; }
+        bool Valid() const override { return it != map.end(); }
+        void Next() override { ++it; }
+
+    private:
+        const std::map<COutPoint, Coin>& map;
+        std::map<COutPoint, Coin>::const_iterator it;
+    };
+
+    uint256 GetBestBlock() const override { return hashBestBlock; }
+    CCoinsViewCursor* Cursor() const override { return new MapCursor(*this, uint256()); }
+    CCoinsViewCursor* Cursor(const uint256& hashFrom) const override { return new MapCursor(*this, hashFrom); }
+};
+
+/** Sequential scan computing the statistics the way gettxoutsetinfo did before the scan was split up */
+CCoinsStats SerialStats(const CCoinsView& view)
+{
+    std::unique_ptr<CCoinsViewCursor> pcursor(view.Cursor());
+    CCoinsStats stats;
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss << pcursor->GetBestBlock();
+
+    uint256 prevkey;
+    std::map<uint32_t, Coin> outputs;
+    auto apply = [&]() {
+        SerializeTxOutputsForHash(ss, prevkey, outputs);
+        stats.nTransactions++;
+        for (const auto& output : outputs) {
+            stats.nTransactionOutputs++;
+            stats.nTotalAmount += output.second.out.nValue;
+        }
+    };
+    for (; pcursor->Valid(); pcursor->Next()) {
+        COutPoint key;
+        Coin coin;
+        BOOST_REQUIRE(pcursor->GetKey(key) && pcursor->GetValue(coin));
+        if (!outputs.empty() && key.hash != prevkey) {
+            apply();
+            outputs.clear();
+        }
+        prevkey = key.hash;
+        outputs[key.n] = coin;
+    }
+    if (!outputs.empty())
+        apply();
+    stats.hashSerialized = ss.GetHash();
+    return stats;
+}
+
+void FillRandomCoins(CCoinsViewMap& view, FastRandomContext& rng, int nTransactions)
+{
+    for (int i = 0; i < nTransactions; i++) {
+        uint256 txid = RandomHash(rng);
+        // some transactions right at the edges of the txid ranges
+        if (i % 50 == 0)
+            *txid.begin() = (i / 50) % 2 ? 0xff : 0x00;
+        int nHeight = rng.randrange(500000);
+        bool fCoinBase = rng.randrange(10) == 0;
+        int nOutputs = 1 + rng.randrange(5);
+        for (int n = 0; n < nOutputs; n++) {
+            if (n && rng.randrange(3) == 0)
+                continue; // spent
+            CTxOut out;
+            out.nValue = rng.randrange(100 * COIN);
+            out.scriptPubKey.assign(rng.randrange(60), (unsigned char)rng.randrange(256));
+            view.mapCoins.emplace(COutPoint(txid, n * 7), Coin(out, nHeight, fCoinBase));
+        }
+    }
+}
+
+/** Adds the best block of view to mapBlockIndex for as long as it lives, GetUTXOStats looks its height up */
+struct BestBlockIndex
+{
+    uint256 hash;
+    CBlockIndex index;
+
+    BestBlockIndex(CCoinsViewMap& view, uint256 hashIn, int nHeight) : hash(hashIn)
+    {
+        view.hashBestBlock = hash;
+        index.nHeight = nHeight;
+        LOCK(cs_main);
+        index.phashBlock = &mapBlockIndex.emplace(hash, &index).first->first;
+    }
+
+    ~BestBlockIndex()
+    {
+        LOCK(cs_main);
+        mapBlockIndex.erase(hash);
+    }
+};
+
+} // anon namespace
+
+BOOST_FIXTURE_TEST_SUITE(coinstats_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(coinstats_hash_matches_serial)
+{
+    FastRandomContext rng(true);
+    CCoinsViewMap view;
+    FillRandomCoins(view, rng, 5000);
+    BestBlockIndex best(view, RandomHash(rng), 1234);
+
+    CCoinsStats expected = SerialStats(view);
+    CCoinsStats stats;
+    BOOST_REQUIRE(GetUTXOStats(&view, stats));
+    BOOST_CHECK(stats.hashSerialized == expected.hashSerialized);
+    BOOST_CHECK_EQUAL(stats.nTransactions, expected.nTransactions);
+    BOOST_CHECK_EQUAL(stats.nTransactionOutputs, expected.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(stats.nTotalAmount, expected.nTotalAmount);
+    BOOST_CHECK_EQUAL(stats.nHeight, 1234);
+    BOOST_CHECK(stats.hashBlock == best.hash);
+
+    // the next block spends a coin, the result remembered for the last one is not used
+    view.mapCoins.erase(view.mapCoins.begin());
+    BestBlockIndex next(view, RandomHash(rng), 1235);
+    CCoinsStats changed;
+    BOOST_REQUIRE(GetUTXOStats(&view, changed));
+    BOOST_CHECK(changed.hashSerialized == SerialStats(view).hashSerialized);
+    BOOST_CHECK_EQUAL(changed.nTransactionOutputs, expected.nTransactionOutputs - 1);
+}
+
+BOOST_AUTO_TEST_CASE(coinstats_empty_set)
+{
+    FastRandomContext rng(true);
+    CCoinsViewMap view;
+    BestBlockIndex best(view, RandomHash(rng), 1);
+
+    CCoinsStats stats;
+    BOOST_REQUIRE(GetUTXOStats(&view, stats));
+    BOOST_CHECK(stats.hashSerialized == SerialStats(view).hashSerialized);
+    BOOST_CHECK_EQUAL(stats.nTransactions, 0U);
+    BOOST_CHECK_EQUAL(stats.nTransactionOutputs, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(coinstats_without_hash)
+{
+    FastRandomContext rng(true);
+    CCoinsViewMap view;
+    FillRandomCoins(view, rng, 1000);
+    BestBlockIndex best(view, RandomHash(rng), 42);
+    CCoinsStats expected = SerialStats(view);
+
+    CCoinsStats stats;
+    BOOST_REQUIRE(GetUTXOStats(&view, stats, false));
+    BOOST_CHECK(stats.hashSerialized.IsNull());
+    BOOST_CHECK_EQUAL(stats.nTransactionOutputs, expected.nTransactionOutputs);
+
+    // the remembered result has no hash, asking for one scans again
+    BOOST_REQUIRE(GetUTXOStats(&view, stats, true));
+    BOOST_CHECK(stats.hashSerialized == expected.hashSerialized);
+
+    // and the hashed result serves both kinds of requests afterwards
+    BOOST_REQUIRE(GetUTXOStats(&view, stats, false));
+    BOOST_CHECK(stats.hashSerialized.IsNull());
+    BOOST_CHECK_EQUAL(stats.nTransactionOutputs, expected.nTransactionOutputs);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
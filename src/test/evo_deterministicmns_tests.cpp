@@ -0,0 +1,193 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "evo/deterministicmns.h"
+
+#include "arith_uint256.h"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+#include "random.h"
+#include "test/test_bitcoinzero.h"
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+/**
+ * List of nCount masternodes with last paid heights from a small range, so
+ * that many of them tie and are ordered by proTxHash. Some were never paid,
+ * some were revived, every tenth one is PoSe banned and every fifth one is
+ * not confirmed yet.
+ */
+CDeterministicMNList CreateList(FastRandomContext& rng, int nCount, const uint256& blockHash)
+{
+    CDeterministicMNList list(blockHash, 1000, nCount);
+    for (int i = 0; i < nCount; i++) {
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->nRegisteredHeight = 100 + rng.randrange(50);
+        state->nLastPaidHeight = rng.randrange(4) == 0 ? 0 : 150 + rng.randrange(30);
+        if (rng.randrange(8) == 0)
+            state->nPoSeRevivedHeight = 150 + rng.randrange(40);
+        if (i % 10 == 3)
+            state->nPoSeBanHeight = 990;
+        if (i % 5 != 4) {
+            state->confirmedHash = RandomHash(rng);
+            state->confirmedHashWithProRegTxHash = RandomHash(rng);
+        }
+        uint160 owner;
+        WriteLE64(owner.begin(), i + 1);
+        state->keyIDOwner = CKeyID(owner);
+
+        auto dmn = std::make_shared<CDeterministicMN>();
+        dmn->proTxHash = RandomHash(rng);
+        dmn->internalId = i;
+        dmn->collateralOutpoint = COutPoint(RandomHash(rng), i % 3);
+        dmn->nOperatorReward = 0;
+        dmn->pdmnState = state;
+        list.AddMN(dmn);
+    }
+    return list;
+}
+
+int LastPaidHeight(const CDeterministicMNCPtr& dmn)
+{
+    int height = dmn->pdmnState->nLastPaidHeight;
+    if (dmn->pdmnState->nPoSeRevivedHeight != -1 && dmn->pdmnState->nPoSeRevivedHeight > height) {
+        height = dmn->pdmnState->nPoSeRevivedHeight;
+    } else if (height == 0) {
+        height = dmn->pdmnState->nRegisteredHeight;
+    }
+    return height;
+}
+
+/** Payee order as computed before, by sorting all valid masternodes */
+std::vector<CDeterministicMNCPtr> FullSortPayees(const CDeterministicMNList& list)
+{
+    std::vector<CDeterministicMNCPtr> result;
+    list.ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
+        result.emplace_back(dmn);
+    });
+    std::sort(result.begin(), result.end(), [](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+        int ah = LastPaidHeight(a);
+        int bh = LastPaidHeight(b);
+        return ah == bh ? a->proTxHash < b->proTxHash : ah < bh;
+    });
+    return result;
+}
+
+/** Quorum as computed before: one hash per masternode and a full sort of the scores */
+std::vector<CDeterministicMNCPtr> FullSortQuorum(const CDeterministicMNList& list, size_t maxSize, const uint256& modifier)
+{
+    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
+    list.ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
+        if (dmn->pdmnState->confirmedHash.IsNull())
+            return;
+        uint256 h;
+        CSHA256 sha256;
+        sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), dmn->pdmnState->confirmedHashWithProRegTxHash.size());
+        sha256.Write(modifier.begin(), modifier.size());
+        sha256.Finalize(h.begin());
+        scores.emplace_back(UintToArith256(h), dmn);
+    });
+    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+        if (a.first == b.first)
+            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+        return a.first < b.first;
+    });
+
+    std::vector<CDeterministicMNCPtr> result;
+    for (size_t i = 0; i < std::min(maxSize, scores.size()); i++)
+        result.emplace_back(scores[i].second);
+    return result;
+}
+
+bool SameOrder(const std::vector<CDeterministicMNCPtr>& a, const std::vector<CDeterministicMNCPtr>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i]->proTxHash != b[i]->proTxHash)
+            return false;
+    }
+    return true;
+}
+
+} // anon namespace
+
+BOOST_FIXTURE_TEST_SUITE(evo_deterministicmns_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(projected_payees_match_full_sort)
+{
+    FastRandomContext rng(true);
+    CDeterministicMNList list = CreateList(rng, 400, uint256());
+    std::vector<CDeterministicMNCPtr> expected = FullSortPayees(list);
+    BOOST_REQUIRE_EQUAL(expected.size(), list.GetValidMNsCount());
+
+    for (int nCount : {1, 2, 10, 99, 359, 360}) {
+        std::vector<CDeterministicMNCPtr> projected = list.GetProjectedMNPayees(nCount);
+        std::vector<CDeterministicMNCPtr> prefix(expected.begin(), expected.begin() + std::min<size_t>(nCount, expected.size()));
+        BOOST_CHECK(SameOrder(projected, prefix));
+    }
+
+    // asking for more payees than there are valid masternodes returns all of them
+    BOOST_CHECK(SameOrder(list.GetProjectedMNPayees(1000), expected));
+    BOOST_CHECK(list.GetProjectedMNPayees(1)[0]->proTxHash == list.GetMNPayee()->proTxHash);
+}
+
+BOOST_AUTO_TEST_CASE(projected_payees_non_positive_count)
+{
+    FastRandomContext rng(true);
+    CDeterministicMNList list = CreateList(rng, 20, uint256());
+    BOOST_CHECK(list.GetProjectedMNPayees(0).empty());
+    BOOST_CHECK(list.GetProjectedMNPayees(-5).empty());
+    BOOST_CHECK(CDeterministicMNList().GetProjectedMNPayees(3).empty());
+}
+
+BOOST_AUTO_TEST_CASE(quorum_matches_full_sort)
+{
+    FastRandomContext rng(true);
+    // a null block hash keeps the list out of the quorum cache
+    CDeterministicMNList list = CreateList(rng, 400, uint256());
+
+    for (size_t maxSize : {1, 10, 50, 400}) {
+        uint256 modifier = RandomHash(rng);
+        BOOST_CHECK(SameOrder(list.CalculateQuorum(maxSize, modifier), FullSortQuorum(list, maxSize, modifier)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(quorum_cache)
+{
+    FastRandomContext rng(true);
+    CDeterministicMNList list = CreateList(rng, 100, RandomHash(rng));
+    uint256 modifier = RandomHash(rng);
+
+    std::vector<CDeterministicMNCPtr> expected = FullSortQuorum(list, 10, modifier);
+    BOOST_CHECK(SameOrder(list.CalculateQuorum(10, modifier), expected));
+    // served from the cache, other sizes and modifiers are separate entries
+    BOOST_CHECK(SameOrder(list.CalculateQuorum(10, modifier), expected));
+    BOOST_CHECK(SameOrder(list.CalculateQuorum(20, modifier), FullSortQuorum(list, 20, modifier)));
+    uint256 other = RandomHash(rng);
+    BOOST_CHECK(SameOrder(list.CalculateQuorum(10, other), FullSortQuorum(list, 10, other)));
+}
+
+BOOST_AUTO_TEST_CASE(sha256_batch64_matches_single)
+{
+    FastRandomContext rng(true);
+    for (size_t blocks : {0, 1, 3, 17}) {
+        std::vector<unsigned char> input(blocks * 64);
+        for (auto& c : input)
+            c = rng.randbits(8);
+        std::vector<unsigned char> output(blocks * 32);
+        SHA256Batch64(output.data(), input.data(), blocks);
+        for (size_t i = 0; i < blocks; i++) {
+            unsigned char expected[CSHA256::OUTPUT_SIZE];
+            CSHA256().Write(&input[i * 64], 64).Finalize(expected);
+            BOOST_CHECK(memcmp(&output[i * 32], expected, 32) == 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
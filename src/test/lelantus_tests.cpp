@@ -0,0 +1,72 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "lelantus.h"
+
+#include "test/test_bitcoinzero.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(lelantus_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(verified_joinsplit_cache_lookup)
+{
+    lelantus::CVerifiedJoinSplitCache cache(10);
+    uint256 setHash = TestHash(1000);
+    BOOST_CHECK(!cache.Contains(TestHash(1), setHash));
+
+    cache.Add(TestHash(1), setHash);
+    BOOST_CHECK(cache.Contains(TestHash(1), setHash));
+    BOOST_CHECK_EQUAL(cache.Size(), 1U);
+
+    // a proof verified against other anonymity sets is not a hit
+    BOOST_CHECK(!cache.Contains(TestHash(1), TestHash(1001)));
+    BOOST_CHECK(!cache.Contains(TestHash(2), setHash));
+
+    // verifying again against new sets replaces the old ones
+    cache.Add(TestHash(1), TestHash(1001));
+    BOOST_CHECK(cache.Contains(TestHash(1), TestHash(1001)));
+    BOOST_CHECK(!cache.Contains(TestHash(1), setHash));
+    BOOST_CHECK_EQUAL(cache.Size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(verified_joinsplit_cache_eviction)
+{
+    const size_t nMaxSize = 10;
+    lelantus::CVerifiedJoinSplitCache cache(nMaxSize);
+    uint256 setHash = TestHash(1000);
+
+    for (uint64_t i = 0; i < nMaxSize; i++)
+        cache.Add(TestHash(i), setHash);
+    BOOST_CHECK_EQUAL(cache.Size(), nMaxSize);
+
+    // the oldest entries go first, one for every new one
+    for (uint64_t i = nMaxSize; i < 3 * nMaxSize; i++) {
+        cache.Add(TestHash(i), setHash);
+        BOOST_CHECK_EQUAL(cache.Size(), nMaxSize);
+        BOOST_CHECK(!cache.Contains(TestHash(i - nMaxSize), setHash));
+        for (uint64_t j = i - nMaxSize + 1; j <= i; j++)
+            BOOST_CHECK(cache.Contains(TestHash(j), setHash));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(verified_joinsplit_cache_update_keeps_position)
+{
+    lelantus::CVerifiedJoinSplitCache cache(3);
+    cache.Add(TestHash(1), TestHash(1000));
+    cache.Add(TestHash(2), TestHash(1000));
+    cache.Add(TestHash(3), TestHash(1000));
+
+    // updating the oldest entry doesn't make it the newest one
+    cache.Add(TestHash(1), TestHash(1001));
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+    cache.Add(TestHash(4), TestHash(1000));
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+    BOOST_CHECK(!cache.Contains(TestHash(1), TestHash(1001)));
+    BOOST_CHECK(cache.Contains(TestHash(2), TestHash(1000)));
+    BOOST_CHECK(cache.Contains(TestHash(3), TestHash(1000)));
+    BOOST_CHECK(cache.Contains(TestHash(4), TestHash(1000)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,170 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tagmap.h"
+
+#include "random.h"
+#include "test/test_bitcoinzero.h"
+
+#include <map>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(tagmap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(tagmap_insert_find_erase)
+{
+    CTagMap<uint256, int> map;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+
+    for (int i = 0; i < 1000; i++)
+        BOOST_CHECK(map.insert(TestHash(i), i));
+    BOOST_CHECK_EQUAL(map.size(), 1000U);
+
+    // existing keys are not replaced
+    BOOST_CHECK(!map.insert(TestHash(7), -1));
+    BOOST_CHECK_EQUAL(map.find(TestHash(7)).value(), 7);
+
+    for (int i = 0; i < 1000; i++) {
+        auto it = map.find(TestHash(i));
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK(it.key() == TestHash(i));
+        BOOST_CHECK_EQUAL(it.value(), i);
+    }
+    BOOST_CHECK(map.find(TestHash(1000)) == map.end());
+    BOOST_CHECK_EQUAL(map.count(TestHash(1000)), 0U);
+
+    map[TestHash(1000)] = 1000;
+    map[TestHash(3)] = 33;
+    BOOST_CHECK_EQUAL(map.size(), 1001U);
+    BOOST_CHECK_EQUAL(map.find(TestHash(3)).value(), 33);
+
+    BOOST_CHECK_EQUAL(map.erase(TestHash(3)), 1U);
+    BOOST_CHECK_EQUAL(map.erase(TestHash(3)), 0U);
+    BOOST_CHECK(map.find(TestHash(3)) == map.end());
+    BOOST_CHECK_EQUAL(map.size(), 1000U);
+
+    // an erased key can be added again
+    BOOST_CHECK(map.insert(TestHash(3), 3));
+    BOOST_CHECK_EQUAL(map.find(TestHash(3)).value(), 3);
+
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(TestHash(1)) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(tagmap_rehash_with_tombstones)
+{
+    CTagMap<uint256, uint64_t> map;
+    std::set<uint64_t> present;
+
+    // keep the map small while churning through many keys: the table has to
+    // drop its tombstones instead of growing for every new key
+    for (uint64_t i = 0; i < 20000; i++) {
+        BOOST_CHECK(map.insert(TestHash(i), i));
+        present.insert(i);
+        if (i >= 50) {
+            BOOST_CHECK_EQUAL(map.erase(TestHash(i - 50)), 1U);
+            present.erase(i - 50);
+        }
+    }
+    BOOST_CHECK_EQUAL(map.size(), present.size());
+    BOOST_CHECK(map.DynamicMemoryUsage() < 64 * 1024);
+
+    for (uint64_t i = 0; i < 20000; i++) {
+        auto it = map.find(TestHash(i));
+        if (present.count(i)) {
+            BOOST_REQUIRE(it != map.end());
+            BOOST_CHECK_EQUAL(it.value(), i);
+        } else {
+            BOOST_CHECK(it == map.end());
+        }
+    }
+
+    // growing again after the churn keeps every key
+    for (uint64_t i = 20000; i < 30000; i++)
+        BOOST_CHECK(map.insert(TestHash(i), i));
+    BOOST_CHECK_EQUAL(map.size(), present.size() + 10000);
+    for (uint64_t i = 20000; i < 30000; i++)
+        BOOST_CHECK_EQUAL(map.find(TestHash(i)).value(), i);
+}
+
+BOOST_AUTO_TEST_CASE(tagmap_erase_while_iterating)
+{
+    CTagMap<uint256, uint64_t> map;
+    for (uint64_t i = 0; i < 5000; i++)
+        map.insert(TestHash(i), i);
+
+    // erasing only marks the slot as deleted, the iterator stays valid
+    std::set<uint64_t> visited;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        BOOST_CHECK(visited.insert(it.value()).second);
+        if (it.value() % 2)
+            map.erase(it);
+    }
+    BOOST_CHECK_EQUAL(visited.size(), 5000U);
+    BOOST_CHECK_EQUAL(map.size(), 2500U);
+
+    size_t count = 0;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        BOOST_CHECK_EQUAL(it.value() % 2, 0U);
+        count++;
+    }
+    BOOST_CHECK_EQUAL(count, 2500U);
+}
+
+BOOST_AUTO_TEST_CASE(tagmap_random_operations)
+{
+    FastRandomContext rng(true);
+    CTagMap<uint256, uint64_t> map;
+    std::map<uint256, uint64_t> model;
+
+    for (int i = 0; i < 50000; i++) {
+        uint256 key = TestHash(rng.randrange(4000));
+        switch (rng.randrange(3)) {
+        case 0: {
+            uint64_t value = rng.rand64();
+            BOOST_CHECK_EQUAL(map.insert(key, value), model.emplace(key, value).second);
+            break;
+        }
+        case 1:
+            BOOST_CHECK_EQUAL(map.erase(key), model.erase(key));
+            break;
+        case 2: {
+            auto it = map.find(key);
+            auto mit = model.find(key);
+            BOOST_REQUIRE_EQUAL(it == map.end(), mit == model.end());
+            if (mit != model.end())
+                BOOST_CHECK_EQUAL(it.value(), mit->second);
+            break;
+        }
+        }
+    }
+
+    BOOST_CHECK_EQUAL(map.size(), model.size());
+    std::map<uint256, uint64_t> contents;
+    for (auto it = map.begin(); it != map.end(); ++it)
+        contents.emplace(it.key(), it.value());
+    BOOST_CHECK(contents == model);
+}
+
+BOOST_AUTO_TEST_CASE(tagmap_group_element_keys)
+{
+    // the same point reached through different Jacobian coordinates is one key
+    secp_primitives::GroupElement g;
+    g.set_base_g();
+    secp_primitives::GroupElement doubled = g + g;
+    secp_primitives::GroupElement scaled = g * secp_primitives::Scalar(uint64_t(2));
+
+    CTagMap<secp_primitives::GroupElement, int> map;
+    BOOST_CHECK(map.insert(doubled, 1));
+    BOOST_CHECK(!map.insert(scaled, 2));
+    BOOST_CHECK(map.count(scaled));
+    BOOST_CHECK(map.find(scaled).key() == doubled);
+    BOOST_CHECK(!map.count(g));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,26 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define BOOST_TEST_MODULE BitcoinZero Test Suite
+
+#include "test/test_bitcoinzero.h"
+
+#include "chainparams.h"
+#include "key.h"
+#include "util.h"
+
+#include <boost/test/unit_test.hpp>
+
+BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
+{
+    ECC_Start();
+    SetupEnvironment();
+    fPrintToDebugLog = false;
+    SelectParams(chainName);
+}
+
+BasicTestingSetup::~BasicTestingSetup()
+{
+    ECC_Stop();
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_TEST_TEST_BITCOINZERO_H
+#define BZX_TEST_TEST_BITCOINZERO_H
+
+#include "arith_uint256.h"
+#include "chainparamsbase.h"
+#include "crypto/common.h"
+#include "pubkey.h"
+#include "random.h"
+#include "uint256.h"
+
+#include <string>
+
+/** Selects the chain parameters and starts the crypto libraries, no chain state or network */
+struct BasicTestingSetup {
+    ECCVerifyHandle globalVerifyHandle;
+
+    explicit BasicTestingSetup(const std::string& chainName = CBaseChainParams::REGTEST);
+    ~BasicTestingSetup();
+};
+
+/** The n-th of a series of distinct hashes, never the null hash */
+static inline uint256 TestHash(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n + 1));
+}
+
+static inline uint256 RandomHash(FastRandomContext& rng)
+{
+    uint256 hash;
+    for (int i = 0; i < 4; i++)
+        WriteLE64(hash.begin() + 8 * i, rng.rand64());
+    return hash;
+}
+
+#endif // BZX_TEST_TEST_BITCOINZERO_H
@@ -0,0 +1,128 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "timerwheel.h"
+
+#include "random.h"
+#include "test/test_bitcoinzero.h"
+#include "utiltime.h"
+
+#include <algorithm>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+static const int64_t TICK = CTimerWheel::TICK_MICROS;
+
+static bool Contains(const std::vector<uint256>& v, const uint256& hash)
+{
+    return std::find(v.begin(), v.end(), hash) != v.end();
+}
+
+BOOST_FIXTURE_TEST_SUITE(timerwheel_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(timerwheel_cascade)
+{
+    CTimerWheel wheel;
+    // the wheel starts at the current time, stay ahead of it
+    int64_t nBaseTick = GetTimeMicros() / TICK + 10;
+
+    // delays at the edges of every level, and beyond the top one
+    const int64_t slots = CTimerWheel::SLOTS;
+    std::vector<int64_t> vDelays = {1, 2, slots - 1, slots, slots + 1, slots * slots - 1, slots * slots,
+                                    slots * slots * slots + 7, slots * slots * slots * slots + 3};
+    std::map<int64_t, uint256> mapExpiry;
+    for (size_t i = 0; i < vDelays.size(); i++) {
+        int64_t nExpiry = (nBaseTick + vDelays[i]) * TICK;
+        BOOST_CHECK(wheel.Insert(TestHash(i), nExpiry));
+        mapExpiry.emplace(nExpiry, TestHash(i));
+    }
+    BOOST_CHECK(!wheel.Insert(TestHash(0), nBaseTick * TICK));
+    BOOST_CHECK(wheel.PopExpired(nBaseTick * TICK).empty());
+
+    // every entry comes out exactly at its tick, after falling down the levels
+    for (const auto& p : mapExpiry) {
+        BOOST_CHECK(wheel.PopExpired(p.first - 1).empty());
+        std::vector<uint256> vExpired = wheel.PopExpired(p.first);
+        BOOST_CHECK_EQUAL(vExpired.size(), 1U);
+        BOOST_CHECK(Contains(vExpired, p.second));
+        BOOST_CHECK(!wheel.Contains(p.second));
+    }
+    BOOST_CHECK_EQUAL(wheel.Size(), 0U);
+    BOOST_CHECK_EQUAL(wheel.GetExpiredCount(), vDelays.size());
+}
+
+BOOST_AUTO_TEST_CASE(timerwheel_remove_after_cascade)
+{
+    CTimerWheel wheel;
+    int64_t nBaseTick = GetTimeMicros() / TICK + 10;
+    const int64_t slots = CTimerWheel::SLOTS;
+
+    uint256 removed = TestHash(1);
+    uint256 kept = TestHash(2);
+    BOOST_CHECK(wheel.Insert(removed, (nBaseTick + slots * slots + 5) * TICK));
+    BOOST_CHECK(wheel.Insert(kept, (nBaseTick + slots * slots + 5) * TICK));
+
+    // both entries have been moved down from level 2 by now
+    BOOST_CHECK(wheel.PopExpired((nBaseTick + slots * slots + 1) * TICK).empty());
+    BOOST_CHECK(wheel.Remove(removed));
+    BOOST_CHECK(!wheel.Remove(removed));
+
+    std::vector<uint256> vExpired = wheel.PopExpired((nBaseTick + slots * slots + 5) * TICK);
+    BOOST_CHECK_EQUAL(vExpired.size(), 1U);
+    BOOST_CHECK(Contains(vExpired, kept));
+    BOOST_CHECK_EQUAL(wheel.GetRemovedCount(), 1U);
+    BOOST_CHECK_EQUAL(wheel.GetExpiredCount(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(timerwheel_overdue_entries)
+{
+    CTimerWheel wheel;
+    int64_t nNow = (GetTimeMicros() / TICK + 10) * TICK;
+    BOOST_CHECK(wheel.PopExpired(nNow).empty());
+
+    // expiries in the past are due on the next tick
+    BOOST_CHECK(wheel.Insert(TestHash(1), nNow - 60 * TICK));
+    std::vector<uint256> vExpired = wheel.PopExpired(nNow + TICK);
+    BOOST_CHECK_EQUAL(vExpired.size(), 1U);
+    BOOST_CHECK(Contains(vExpired, TestHash(1)));
+}
+
+BOOST_AUTO_TEST_CASE(timerwheel_random_operations)
+{
+    FastRandomContext rng(true);
+    CTimerWheel wheel;
+    std::map<uint256, int64_t> model;
+    int64_t nNow = (GetTimeMicros() / TICK + 10) * TICK;
+    uint64_t nNextHash = 0;
+
+    for (int i = 0; i < 20000; i++) {
+        int op = rng.randrange(10);
+        if (op < 4) {
+            // mostly short delays, some that need cascading from the top levels
+            int64_t nRange = op == 0 ? int64_t(3000000) * 1000000 : int64_t(60) * 1000000;
+            int64_t nExpiry = nNow + int64_t(rng.randrange(nRange)) - 1000000;
+            uint256 hash = TestHash(nNextHash++);
+            BOOST_CHECK(wheel.Insert(hash, nExpiry));
+            model.emplace(hash, std::max(nExpiry, nNow));
+        } else if (op < 5 && !model.empty()) {
+            BOOST_CHECK(wheel.Remove(model.begin()->first));
+            model.erase(model.begin());
+        } else {
+            nNow += rng.randrange(op == 9 ? int64_t(100000) * 1000000 : 300000);
+            for (const uint256& hash : wheel.PopExpired(nNow)) {
+                auto it = model.find(hash);
+                BOOST_REQUIRE(it != model.end());
+                BOOST_CHECK(it->second <= nNow);
+                model.erase(it);
+            }
+            // nothing is left that expired more than a tick ago
+            for (const auto& p : model)
+                BOOST_CHECK(p.second > nNow - TICK);
+        }
+        BOOST_CHECK_EQUAL(wheel.Size(), model.size());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
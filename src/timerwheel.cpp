@@ -0,0 +1,123 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "timerwheel.h"
+
+#include "utiltime.h"
+
+#include <algorithm>
+
+CTimerWheel::CTimerWheel() :
+    nCurrentTick(GetTimeMicros() / TICK_MICROS), nExpired(0), nRemoved(0)
+{
+}
+
+void CTimerWheel::Place(const uint256& hash, Entry& entry)
+{
+    // overdue entries expire on the next tick, entries beyond the top level
+    // wait in its farthest slot and are placed again from there
+    int64_t nDelta = std::max<int64_t>(entry.nExpiryTick - nCurrentTick, 1);
+    int nLevel = 0;
+    while (nLevel < LEVELS - 1 && nDelta >= (int64_t(1) << (SLOT_BITS * (nLevel + 1))))
+        nLevel++;
+    nDelta = std::min<int64_t>(nDelta, (int64_t(1) << (SLOT_BITS * LEVELS)) - 1);
+
+    int64_t nTick = nCurrentTick + nDelta;
+    entry.nLevel = nLevel;
+    entry.nSlot = (nTick >> (SLOT_BITS * nLevel)) & (SLOTS - 1);
+    Slot& slot = slots[entry.nLevel][entry.nSlot];
+    entry.it = slot.insert(slot.end(), hash);
+}
+
+void CTimerWheel::Cascade(int nLevel)
+{
+    Slot slot;
+    slot.swap(slots[nLevel][(nCurrentTick >> (SLOT_BITS * nLevel)) & (SLOTS - 1)]);
+    for (const uint256& hash : slot)
+        Place(hash, mapEntries[hash]);
+}
+
+bool CTimerWheel::Insert(const uint256& hash, int64_t nExpiryMicros)
+{
+    LOCK(cs);
+    if (mapEntries.count(hash))
+        return false;
+    if (mapEntries.empty()) {
+        // nothing was due while the wheel was empty, skip the idle ticks
+        nCurrentTick = std::max(nCurrentTick, GetTimeMicros() / TICK_MICROS);
+    }
+
+    Entry& entry = mapEntries[hash];
+    entry.nExpiryTick = (nExpiryMicros + TICK_MICROS - 1) / TICK_MICROS;
+    Place(hash, entry);
+    return true;
+}
+
+bool CTimerWheel::Remove(const uint256& hash)
+{
+    LOCK(cs);
+    auto it = mapEntries.find(hash);
+    if (it == mapEntries.end())
+        return false;
+    slots[it->second.nLevel][it->second.nSlot].erase(it->second.it);
+    mapEntries.erase(it);
+    nRemoved++;
+    return true;
+}
+
+bool CTimerWheel::Contains(const uint256& hash) const
+{
+    LOCK(cs);
+    return mapEntries.count(hash) != 0;
+}
+
+std::vector<uint256> CTimerWheel::PopExpired(int64_t nNowMicros)
+{
+    std::vector<uint256> vExpired;
+    int64_t nTargetTick = nNowMicros / TICK_MICROS;
+
+    LOCK(cs);
+    while (nCurrentTick < nTargetTick) {
+        if (mapEntries.empty()) {
+            nCurrentTick = nTargetTick;
+            break;
+        }
+        nCurrentTick++;
+
+        // entries of a higher level slot are moved down when the wheel
+        // enters it, top level first so they can fall through several levels
+        for (int nLevel = LEVELS - 1; nLevel > 0; nLevel--) {
+            if ((nCurrentTick & ((int64_t(1) << (SLOT_BITS * nLevel)) - 1)) == 0)
+                Cascade(nLevel);
+        }
+
+        Slot& slot = slots[0][nCurrentTick & (SLOTS - 1)];
+        for (const uint256& hash : slot) {
+            mapEntries.erase(hash);
+            vExpired.push_back(hash);
+        }
+        slot.clear();
+    }
+
+    nExpired += vExpired.size();
+    return vExpired;
+}
+
+size_t CTimerWheel::Size() const
+{
+    LOCK(cs);
+    return mapEntries.size();
+}
+
+uint64_t CTimerWheel::GetExpiredCount() const
+{
+    LOCK(cs);
+    return nExpired;
+}
+
+uint64_t CTimerWheel::GetRemovedCount() const
+{
+    LOCK(cs);
+    return nRemoved;
+}
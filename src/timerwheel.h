@@ -0,0 +1,80 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_TIMERWHEEL_H
+#define BZX_TIMERWHEEL_H
+
+#include "saltedhasher.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <stdint.h>
+
+/**
+ * Hierarchical timer wheel of hashes, used for the Dandelion embargoes.
+ *
+ * Time is counted in ticks of TICK_MICROS. Level 0 has one slot per tick for
+ * the next SLOTS ticks, every higher level has one slot per SLOTS slots of
+ * the level below it. An entry is put into the lowest level covering its
+ * expiry and moved down a level when the wheel reaches its slot, so insert,
+ * remove and expiry of an entry are O(1) and PopExpired doesn't look at
+ * entries that are not due. Entries expire at most one tick late.
+ */
+class CTimerWheel
+{
+public:
+    static const int64_t TICK_MICROS = 100 * 1000;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 4;
+
+private:
+    typedef std::list<uint256> Slot;
+
+    struct Entry
+    {
+        int64_t nExpiryTick;
+        int nLevel;
+        int nSlot;
+        Slot::iterator it;
+    };
+
+    mutable CCriticalSection cs;
+    Slot slots[LEVELS][SLOTS];
+    std::unordered_map<uint256, Entry, StaticSaltedHasher> mapEntries;
+    //! Last tick whose level 0 slot was expired
+    int64_t nCurrentTick;
+
+    uint64_t nExpired;
+    uint64_t nRemoved;
+
+    //! Put an entry into the slot covering its expiry, relative to nCurrentTick
+    void Place(const uint256& hash, Entry& entry);
+    //! Move the entries of a level's current slot down into the levels below
+    void Cascade(int nLevel);
+
+public:
+    CTimerWheel();
+
+    //! Add hash expiring at nExpiryMicros, false if it is already in the wheel
+    bool Insert(const uint256& hash, int64_t nExpiryMicros);
+    //! Cancel the timer of hash, false if it isn't in the wheel
+    bool Remove(const uint256& hash);
+    bool Contains(const uint256& hash) const;
+
+    //! Remove and return all hashes that expired at or before nNowMicros
+    std::vector<uint256> PopExpired(int64_t nNowMicros);
+
+    size_t Size() const;
+    //! Number of hashes returned by PopExpired so far
+    uint64_t GetExpiredCount() const;
+    //! Number of hashes removed before they expired so far
+    uint64_t GetRemovedCount() const;
+};
+
+#endif // BZX_TIMERWHEEL_H
@@ -84,6 +84,7 @@ public:
     uint256 GetBestBlock() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
+    CCoinsViewCursor *Cursor(const uint256 &hashFrom) const override;
 
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
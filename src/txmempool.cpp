@@ -26,14 +26,19 @@
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                                  int64_t _nTime, unsigned int _entryHeight,
                                  CAmount _inChainInputValue,
-                                 bool _spendsCoinbase, int64_t _sigOpsCost, LockPoints lp):
+                                 bool _spendsCoinbase, int64_t _sigOpsCost, LockPoints lp,
+                                 std::shared_ptr<const CPrivateSpendInfo> _privateSpendInfo):
     tx(_tx), nFee(_nFee), nTime(_nTime), entryHeight(_entryHeight),
     inChainInputValue(_inChainInputValue),
-    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp)
+    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp),
+    privateSpendInfo(_privateSpendInfo)
 {
     nTxWeight = GetTransactionWeight(*tx);
     nModSize = tx->CalculateModifiedSize(GetTxSize());
-    nUsageSize = RecursiveDynamicUsage(*tx) + memusage::DynamicUsage(tx);
+    // the parsed proof of a private spend stays attached to the transaction while it is in the mempool
+    nUsageSize = RecursiveDynamicUsage(*tx) + memusage::DynamicUsage(tx) + tx->ParsedPayloadsDynamicUsage();
+    if (privateSpendInfo)
+        nUsageSize += memusage::DynamicUsage(privateSpendInfo) + privateSpendInfo->DynamicMemoryUsage();
 
     nCountWithDescendants = 1;
     nSizeWithDescendants = GetTxSize();
@@ -51,6 +56,11 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFe
     nSigOpCostWithAncestors = sigOpCost;
 }
 
+size_t CPrivateSpendInfo::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(coverSetIds) + memusage::DynamicUsage(serials) + memusage::DynamicUsage(linkingTags);
+}
+
 CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry& other)
 {
     *this = other;
@@ -583,9 +593,10 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
         // Remove mints and spend serials from lelantus mempool state
         const CTransaction &tx = it->GetTx();
         if (tx.IsLelantusJoinSplit()) {
+            const CPrivateSpendInfo *info = it->GetPrivateSpendInfo();
             std::vector<Scalar> serials;
             try {
-                serials = lelantus::GetLelantusJoinSplitSerialNumbers(tx, tx.vin[0]);
+                serials = info ? info->serials : lelantus::GetLelantusJoinSplitSerialNumbers(tx, tx.vin[0]);
                 for (const Scalar &serial: serials)
                     lelantusState.RemoveSpendFromMempool(serial);
             }
@@ -616,9 +627,10 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
         // Remove mints and spends from spark mempool state
         const CTransaction &tx = it->GetTx();
         if (tx.IsSparkSpend()) {
+            const CPrivateSpendInfo *info = it->GetPrivateSpendInfo();
             std::vector<GroupElement> lTags;
             try {
-                lTags = spark::GetSparkUsedTags(tx);
+                lTags = info ? info->linkingTags : spark::GetSparkUsedTags(tx);
                 for (const auto& lTag : lTags)
                     sparkState.RemoveSpendFromMempool(lTag);
             }
@@ -1353,6 +1365,16 @@ CTransactionRef CTxMemPool::get(const uint256& hash) const
     return i->GetSharedTx();
 }
 
+bool CTxMemPool::GetPrivateSpendFee(const uint256& hash, CAmount& nFee) const
+{
+    LOCK(cs);
+    indexed_transaction_set::const_iterator i = mapTx.find(hash);
+    if (i == mapTx.end() || !i->GetPrivateSpendInfo())
+        return false;
+    nFee = i->GetPrivateSpendInfo()->nFee;
+    return true;
+}
+
 TxMempoolInfo CTxMemPool::info(const uint256& hash) const
 {
     LOCK(cs);
@@ -68,6 +68,29 @@ struct LockPoints
     LockPoints() : height(0), time(0), maxInputBlock(NULL) { }
 };
 
+/**
+ * Data of a Lelantus joinsplit or Spark spend parsed from its proof when the
+ * transaction enters the mempool, so that block assembly, fee accounting and
+ * removal don't have to deserialize the proof again.
+ */
+struct CPrivateSpendInfo
+{
+    //! Sum of the transparent outputs
+    CAmount nTransparentAmount;
+    CAmount nFee;
+    //! Anonymity set (Lelantus) or cover set (Spark) of every input
+    std::vector<uint32_t> coverSetIds;
+    //! Lelantus serial numbers
+    std::vector<Scalar> serials;
+    //! Spark linking tags
+    std::vector<GroupElement> linkingTags;
+
+    CPrivateSpendInfo() : nTransparentAmount(0), nFee(0) {}
+
+    size_t GetInputCount() const { return serials.size() + linkingTags.size(); }
+    size_t DynamicMemoryUsage() const;
+};
+
 class CTxMemPool;
 
 /** \class CTxMemPoolEntry
@@ -102,6 +125,7 @@ private:
     int64_t sigOpCost;         //!< Total sigop cost
     int64_t feeDelta;          //!< Used for determining the priority of the transaction for mining in a block
     LockPoints lockPoints;     //!< Track the height and time at which tx was final
+    std::shared_ptr<const CPrivateSpendInfo> privateSpendInfo; //!< Parsed proof data of a joinsplit or spark spend
 
     // Information about descendants of this transaction that are in the
     // mempool; if we remove this transaction we must remove all of these
@@ -122,7 +146,8 @@ public:
     CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                     int64_t _nTime, unsigned int _entryHeight,
                     CAmount _inChainInputValue, bool spendsCoinbase,
-                    int64_t nSigOpsCost, LockPoints lp);
+                    int64_t nSigOpsCost, LockPoints lp,
+                    std::shared_ptr<const CPrivateSpendInfo> _privateSpendInfo = nullptr);
 
     CTxMemPoolEntry(const CTxMemPoolEntry& other);
     CTxMemPoolEntry& operator=(const CTxMemPoolEntry& other) = default;
@@ -143,6 +168,8 @@ public:
     int64_t GetModifiedFee() const { return nFee + feeDelta; }
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints& GetLockPoints() const { return lockPoints; }
+    //! Null unless the transaction is a Lelantus joinsplit or Spark spend
+    const CPrivateSpendInfo* GetPrivateSpendInfo() const { return privateSpendInfo.get(); }
 
     // Adjusts the descendant state, if this entry is not dirty.
     void UpdateDescendantState(int64_t modifySize, CAmount modifyFee, int64_t modifyCount);
@@ -714,6 +741,8 @@ public:
     }
 
     CTransactionRef get(const uint256& hash) const;
+    //! Fee of a Lelantus joinsplit or Spark spend in the mempool, without parsing its proof again
+    bool GetPrivateSpendFee(const uint256& hash, CAmount& nFee) const;
     TxMempoolInfo info(const uint256& hash) const;
     std::vector<TxMempoolInfo> infoAll() const;
 
@@ -12,10 +12,12 @@
 #include "support/allocators/secure.h"
 #include "chainparamsbase.h"
 #include "ctpl.h"
+#include "mpscqueue.h"
 #include "random.h"
 #include "serialize.h"
 #include "stacktraces.h"
 #include "sync.h"
+#include "threadinterrupt.h"
 #include "utilstrencodings.h"
 #include "utiltime.h"
 #include "warnings.h"
@@ -40,6 +42,7 @@
 #endif // __linux__
 
 #include <algorithm>
+#include <thread>
 #include <fcntl.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
@@ -271,31 +274,188 @@ bool LogAcceptCategory(const char* category)
  * fStartedNewLine is a state variable held by the calling context that will
  * suppress printing of the timestamp when multiple calls are made that don't
  * end in a newline. Initialize it to true, and hold it, in the calling context.
+ * Returns whether str needs a timestamp.
  */
-static std::string LogTimestampStr(const std::string &str, std::atomic_bool *fStartedNewLine)
+static bool LogStartsNewLine(const std::string &str, std::atomic_bool *fStartedNewLine)
 {
-    std::string strStamped;
-
     if (!fLogTimestamps)
-        return str;
+        return false;
 
-    if (*fStartedNewLine) {
-        int64_t nTimeMicros = GetLogTimeMicros();
-        strStamped = DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTimeMicros/1000000);
-        if (fLogTimeMicros)
-            strStamped += strprintf(".%06d", nTimeMicros%1000000);
-        strStamped += ' ' + str;
-    } else
-        strStamped = str;
+    bool fNewLine = *fStartedNewLine;
 
     if (!str.empty() && str[str.size()-1] == '\n')
         *fStartedNewLine = true;
     else
         *fStartedNewLine = false;
 
+    return fNewLine;
+}
+
+static std::string LogTimestampStr(const std::string &str, int64_t nTimeMicros)
+{
+    std::string strStamped = DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTimeMicros/1000000);
+    if (fLogTimeMicros)
+        strStamped += strprintf(".%06d", nTimeMicros%1000000);
+    strStamped += ' ' + str;
     return strStamped;
 }
 
+//! Called with mutexDebugLog held
+static void ReopenDebugLogIfRequested()
+{
+    if (fReopenDebugLog) {
+        fReopenDebugLog = false;
+        boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
+        if (freopen(pathDebug.string().c_str(),"a",fileout) != NULL)
+            setbuf(fileout, NULL); // unbuffered
+    }
+}
+
+/**
+ * Asynchronous debug.log writer. Logging threads only stamp the time and
+ * queue the message, formatting the timestamp and the file I/O happen on the
+ * writer thread, which writes everything it finds in the queue at once.
+ */
+namespace {
+
+struct CLogEntry
+{
+    //! Time of the message if it gets a timestamp, 0 otherwise
+    int64_t nTimeMicros;
+    std::string str;
+};
+
+//! Upper limit for the size of one write
+const size_t LOG_BATCH_SIZE = 1 << 20;
+//! How long the writer sleeps when there is nothing to write
+const int64_t LOG_WRITER_IDLE_MS = 20;
+
+CMPSCQueue<CLogEntry>* logQueue = NULL;
+std::atomic<bool> fLogWriterRunning(false);
+//! Number of LogPrintStr calls inside QueueLogMessage
+std::atomic<int> nLogProducers(0);
+std::atomic<size_t> nLogQueueSize(0);
+std::thread logWriterThread;
+CThreadInterrupt logWriterInterrupt;
+
+std::atomic<uint64_t> nLogQueued(0);
+std::atomic<uint64_t> nLogDropped(0);
+std::atomic<uint64_t> nLogWritten(0);
+std::atomic<uint64_t> nLogBatches(0);
+std::atomic<uint64_t> nLogBytes(0);
+
+//! Write out what is in the queue, returns false if it was empty
+bool WriteQueuedLogMessages(std::string& strBatch, uint64_t& nDroppedReported)
+{
+    CLogEntry entry;
+    uint64_t nEntries = 0;
+    strBatch.clear();
+    while (strBatch.size() < LOG_BATCH_SIZE && logQueue->TryPop(entry)) {
+        if (entry.nTimeMicros)
+            strBatch += LogTimestampStr(entry.str, entry.nTimeMicros);
+        else
+            strBatch += entry.str;
+        nEntries++;
+    }
+
+    uint64_t nDropped = nLogDropped;
+    if (nDropped != nDroppedReported) {
+        strBatch += LogTimestampStr(strprintf("%u debug log messages were dropped, the log queue was full\n", nDropped - nDroppedReported), GetLogTimeMicros());
+        nDroppedReported = nDropped;
+    }
+
+    if (strBatch.empty())
+        return false;
+
+    {
+        boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+        ReopenDebugLogIfRequested();
+        FileWriteStr(strBatch, fileout);
+    }
+    nLogWritten += nEntries;
+    nLogBatches++;
+    nLogBytes += strBatch.size();
+    return true;
+}
+
+void ThreadLogWriter()
+{
+    std::string strBatch;
+    strBatch.reserve(LOG_BATCH_SIZE);
+    uint64_t nDroppedReported = nLogDropped;
+    while (true) {
+        if (WriteQueuedLogMessages(strBatch, nDroppedReported))
+            continue;
+        if (logWriterInterrupt)
+            break;
+        logWriterInterrupt.sleep_for(std::chrono::milliseconds(LOG_WRITER_IDLE_MS));
+    }
+}
+
+//! Hand a message to the writer thread, returns false if it isn't running
+bool QueueLogMessage(const std::string& str, int64_t nTimeMicros, int& ret)
+{
+    // StopDebugLogWriter waits for everyone who saw the writer running before the last drain
+    nLogProducers++;
+    bool fRunning = fLogWriterRunning;
+    if (fRunning) {
+        CLogEntry entry;
+        entry.nTimeMicros = nTimeMicros;
+        entry.str = str;
+        if (logQueue->TryPush(std::move(entry))) {
+            nLogQueued++;
+            ret = str.size();
+        } else {
+            nLogDropped++;
+        }
+    }
+    nLogProducers--;
+    return fRunning;
+}
+
+} // anon namespace
+
+void StartDebugLogWriter(size_t nQueueSize)
+{
+    boost::call_once(&DebugPrintInit, debugPrintInitFlag);
+    if (fLogWriterRunning || fileout == NULL || fPrintToConsole)
+        return;
+
+    logQueue = new CMPSCQueue<CLogEntry>(std::max<size_t>(nQueueSize, 1024));
+    nLogQueueSize = logQueue->Capacity();
+    logWriterInterrupt.reset();
+    logWriterThread = std::thread(&TraceThread<void (*)()>, "logwriter", &ThreadLogWriter);
+    fLogWriterRunning = true;
+}
+
+void StopDebugLogWriter()
+{
+    if (!fLogWriterRunning)
+        return;
+    fLogWriterRunning = false;
+    // New messages are written directly from here on, let the ones already being queued finish
+    while (nLogProducers > 0)
+        std::this_thread::yield();
+    // The writer empties the queue before it exits
+    logWriterInterrupt();
+    if (logWriterThread.joinable())
+        logWriterThread.join();
+    delete logQueue;
+    logQueue = NULL;
+    nLogQueueSize = 0;
+}
+
+void GetDebugLogStats(CDebugLogStats& stats)
+{
+    stats.fRunning = fLogWriterRunning;
+    stats.nQueueSize = nLogQueueSize;
+    stats.nQueued = nLogQueued;
+    stats.nDropped = nLogDropped;
+    stats.nWritten = nLogWritten;
+    stats.nBatches = nLogBatches;
+    stats.nBytes = nLogBytes;
+}
+
 int LogPrintStr(const std::string &str)
 {
     //A temporary fix for https://github.com/BZXorg/BZX/issues/1011
@@ -305,16 +465,23 @@ int LogPrintStr(const std::string &str)
     int ret = 0; // Returns total number of characters written
     static std::atomic_bool fStartedNewLine(true);
 
-    std::string strTimestamped = LogTimestampStr(str, &fStartedNewLine);
+    int64_t nTimeMicros = LogStartsNewLine(str, &fStartedNewLine) ? GetLogTimeMicros() : 0;
 
     if (fPrintToConsole)
     {
         // print to console
+        std::string strTimestamped = nTimeMicros ? LogTimestampStr(str, nTimeMicros) : str;
         ret = fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
         fflush(stdout);
     }
+    else if (fPrintToDebugLog && QueueLogMessage(str, nTimeMicros, ret))
+    {
+        // the writer thread takes it from here
+    }
     else if (fPrintToDebugLog)
     {
+        std::string strTimestamped = nTimeMicros ? LogTimestampStr(str, nTimeMicros) : str;
+
         boost::call_once(&DebugPrintInit, debugPrintInitFlag);
         boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
 
@@ -327,12 +494,7 @@ int LogPrintStr(const std::string &str)
         else
         {
             // reopen the log file, if requested
-            if (fReopenDebugLog) {
-                fReopenDebugLog = false;
-                boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
-                if (freopen(pathDebug.string().c_str(),"a",fileout) != NULL)
-                    setbuf(fileout, NULL); // unbuffered
-            }
+            ReopenDebugLogIfRequested();
 
             ret = FileWriteStr(strTimestamped, fileout);
         }
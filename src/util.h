@@ -41,6 +41,9 @@ using namespace boost::placeholders;
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
+static const bool DEFAULT_LOGASYNC      = false;
+//! Number of messages the debug.log queue holds before further ones are dropped
+static const unsigned int DEFAULT_LOGQUEUESIZE = 32768;
 
 /** Signals for translation. */
 class CTranslationInterface
@@ -97,6 +100,29 @@ bool LogAcceptCategory(const char* category);
 /** Send a string to the log output */
 int LogPrintStr(const std::string &str);
 
+/** Counters of the asynchronous debug.log writer */
+struct CDebugLogStats
+{
+    bool fRunning;
+    size_t nQueueSize;
+    uint64_t nQueued;
+    uint64_t nDropped;
+    uint64_t nWritten;
+    uint64_t nBatches;
+    uint64_t nBytes;
+};
+
+/**
+ * Hand debug.log messages to a background thread from now on. Messages are
+ * put into a lock-free queue of nQueueSize entries, which the thread drains
+ * and writes in batches. Messages which don't fit into the full queue are
+ * dropped and counted, the writer logs how many were lost.
+ */
+void StartDebugLogWriter(size_t nQueueSize);
+/** Write out all queued messages and go back to writing on the calling thread */
+void StopDebugLogWriter();
+void GetDebugLogStats(CDebugLogStats& stats);
+
 #define LogPrint(category, ...) do { \
     if (LogAcceptCategory((category))) { \
         LogPrintStr(tfm::format(__VA_ARGS__)); \
@@ -10,6 +10,8 @@
 #endif
 
 #include "arith_uint256.h"
+#include "blockfilemapper.h"
+#include "cachebudget.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
@@ -21,12 +23,14 @@
 #include "base58.h"
 #include "merkleblock.h"
 #include "net.h"
+#include "perfstats.h"
 #include "policy/fees.h"
 #include "policy/policy.h"
 #include "pow.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "random.h"
+#include "reindex.h"
 #include "reverse_iterate.h"
 #include "script/script.h"
 #include "script/sigcache.h"
@@ -107,6 +111,7 @@ bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
 size_t nCoinCacheUsage = 5000 * 300;
+static CCacheBudget coinsCacheBudget;
 uint64_t nPruneTarget = 0;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
 bool fEnableReplacement = DEFAULT_ENABLE_REPLACEMENT;
@@ -334,9 +339,9 @@ bool VerifyPrivateTxOwn(const uint256& txid, const std::vector<unsigned char>& v
         ss << strLelantusMessageMagic;
         ss << message;
 
-        std::unique_ptr<lelantus::JoinSplit> joinsplit;
+        std::shared_ptr<const lelantus::JoinSplit> joinsplit;
         try {
-            joinsplit = lelantus::ParseLelantusJoinSplit(*tx);
+            joinsplit = lelantus::GetParsedLelantusJoinSplit(*tx);
         } catch (const std::exception&) {
             return false;
         }
@@ -819,6 +824,13 @@ bool ContextualCheckTransaction(const CTransaction& tx, CValidationState &state,
     return true;
 }
 
+/** Memory limit of pool in bytes, the Dandelion stem pool has its own */
+static int64_t GetPoolSizeLimit(const CTxMemPool& pool) {
+    if (&pool == &txpools.getStemTxPool())
+        return GetArg("-maxstempool", DEFAULT_MAX_STEMPOOL_SIZE) * 1000000;
+    return GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+}
+
 void LimitMempoolSize(CTxMemPool &pool, size_t limit, unsigned long age) {
     int expired = pool.Expire(GetTime() - age);
     if (expired != 0)
@@ -855,6 +867,7 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
                               bool fOverrideMempoolLimit, const CAmount& nAbsurdFee, std::vector<COutPoint>& coins_to_uncache,
                               bool isCheckWalletTransaction, bool markBZXSpendTransactionSerial)
 {
+    PERF_SCOPE("validation_accept_to_mempool");
     LogPrintf("AcceptToMemoryPoolWorker(), tx.IsSpend()=%s", ptx->IsLelantusJoinSplit());
 
     const CTransaction& tx = *ptx;
@@ -921,6 +934,9 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
     std::vector<spark::Coin> sparkMintCoins;
     std::vector<GroupElement> sparkUsedLTags;
 
+    // The proof of a spend is parsed once here, the mempool entry keeps what we need of it
+    std::shared_ptr<CPrivateSpendInfo> privateSpendInfo;
+
     CSparkNameTxData sparkNameData;
     {
         LOCK(pool.cs);
@@ -928,10 +944,10 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
             if (tx.vin.size() > 1) {
                 return state.Invalid(false, REJECT_CONFLICT, "txn-invalid-lelantus-joinsplit");
             }
-            std::unique_ptr<lelantus::JoinSplit> joinsplit;
+            std::shared_ptr<const lelantus::JoinSplit> joinsplit;
 
             try {
-                joinsplit = lelantus::ParseLelantusJoinSplit(tx);
+                joinsplit = lelantus::GetParsedLelantusJoinSplit(tx);
             }
             catch (CBadTxIn&) {
                 return state.Invalid(false, REJECT_CONFLICT, "txn-invalid-lelantus-joinsplit");
@@ -946,6 +962,12 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
             if (serials.size() != ids.size())
                 return state.Invalid(false, REJECT_CONFLICT, "txn-invalid-lelantus-joinsplit");
 
+            privateSpendInfo = std::make_shared<CPrivateSpendInfo>();
+            privateSpendInfo->nTransparentAmount = lelantus::GetSpendTransparentAmount(tx);
+            privateSpendInfo->nFee = joinsplit->getFee();
+            privateSpendInfo->coverSetIds = ids;
+            privateSpendInfo->serials = serials;
+
             for (size_t i = 0; i < serials.size(); ++i) {
                 if (!serials[i].isMember() || serials[i].isZero())
                     return state.Invalid(false, REJECT_INVALID, "txn-invalid-lelantus-joinsplit-serial");
@@ -966,7 +988,15 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
 
             try
             {
-                sparkUsedLTags = spark::GetSparkUsedTags(tx);
+                spark::SpendTransaction spend = spark::ParseSparkSpend(tx);
+                sparkUsedLTags = spend.getUsedLTags();
+
+                privateSpendInfo = std::make_shared<CPrivateSpendInfo>();
+                privateSpendInfo->nTransparentAmount = spark::GetSpendTransparentAmount(tx);
+                privateSpendInfo->nFee = spend.getFee();
+                const std::vector<uint64_t>& ids = spend.getCoinGroupIds();
+                privateSpendInfo->coverSetIds.assign(ids.begin(), ids.end());
+                privateSpendInfo->linkingTags = sparkUsedLTags;
             }
             catch (const std::exception &)
             {
@@ -1195,28 +1225,10 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
 
             CAmount nValueOut = tx.GetValueOut();
             CAmount nFees;
-             if (!tx.IsLelantusJoinSplit() && !tx.IsSparkSpend()) {
+            if (privateSpendInfo) {
+                nFees = privateSpendInfo->nFee;
+            } else {
                 nFees = nValueIn - nValueOut;
-            } else if (tx.IsLelantusJoinSplit()) {
-                try {
-                    nFees = lelantus::ParseLelantusJoinSplit(tx)->getFee();
-                }
-                catch (CBadTxIn&) {
-                    return state.DoS(0, false, REJECT_INVALID, "unable to parse joinsplit");
-                }
-                    catch (const std::exception &) {
-                        return state.DoS(0, false, REJECT_INVALID, "failed to deserialize joinsplit");
-                    }
-                } else {
-                    try {
-                        nFees = spark::ParseSparkSpend(tx).getFee();
-                    }
-                    catch (CBadTxIn&) {
-                        return state.DoS(0, false, REJECT_INVALID, "unable to parse joinsplit");
-                    }
-                    catch (const std::exception &) {
-                        return state.DoS(0, false, REJECT_INVALID, "failed to deserialize joinsplit");
-                }
             }
             // nModifiedFees includes any fee deltas from PrioritiseTransaction
             CAmount nModifiedFees = nFees;
@@ -1238,7 +1250,7 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
             }
 
             CTxMemPoolEntry entry(ptx, nFees, nAcceptTime, chainActive.Height(),
-                                inChainInputValue, fSpendsCoinbase, nSigOpsCost, lp);
+                                inChainInputValue, fSpendsCoinbase, nSigOpsCost, lp, privateSpendInfo);
             unsigned int nSize = entry.GetTxSize();
 
             // Check that the transaction doesn't have an excessive number of
@@ -1251,7 +1263,7 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
                 return state.DoS(0, false, REJECT_NONSTANDARD, "bad-txns-too-many-sigops", false,
                     strprintf("%d", nSigOpsCost));
 
-            CAmount mempoolRejectFee = pool.GetMinFee(GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFee(nSize);
+            CAmount mempoolRejectFee = pool.GetMinFee(GetPoolSizeLimit(pool)).GetFee(nSize);
             if (mempoolRejectFee > 0 && nModifiedFees < mempoolRejectFee) {
                 return state.DoS(0, false, REJECT_INSUFFICIENTFEE, "mempool min fee not met", false, strprintf("%d < %d", nFees, mempoolRejectFee));
             } else if (GetBoolArg("-relaypriority", DEFAULT_RELAYPRIORITY) && nModifiedFees < ::minRelayTxFee.GetFee(nSize) && !AllowFree(entry.GetPriority(chainActive.Height() + 1))) {
@@ -1523,7 +1535,7 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
 
             // trim mempool and check if tx was trimmed
             if (!fOverrideMempoolLimit) {
-                LimitMempoolSize(pool, GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
+                LimitMempoolSize(pool, GetPoolSizeLimit(pool), GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
                 if (!pool.exists(hash))
                     return state.DoS(0, false, REJECT_INSUFFICIENTFEE, "mempool full");
             }
@@ -1661,14 +1673,22 @@ bool GetTransaction(const uint256 &hash, CTransactionRef &txOut, const Consensus
     if (fTxIndex) {
         CDiskTxPos postx;
         if (pblocktree->ReadTxIndex(hash, postx)) {
-            CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-            if (file.IsNull())
-                return error("%s: OpenBlockFile failed", __func__);
             CBlockHeader header;
             try {
-                file >> header;
-                fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                file >> txOut;
+                CMappedBlockRecord record;
+                if (pblockfilemapper && pblockfilemapper->GetRecord(postx, "blk", 0, record)) {
+                    SpanReader reader(SER_DISK, CLIENT_VERSION, record.begin(), record.end());
+                    reader >> header;
+                    reader.ignore(postx.nTxOffset);
+                    reader >> txOut;
+                } else {
+                    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+                    if (file.IsNull())
+                        return error("%s: OpenBlockFile failed", __func__);
+                    file >> header;
+                    fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+                    file >> txOut;
+                }
             } catch (const std::exception& e) {
                 return error("%s: Deserialize or I/O error - %s", __func__, e.what());
             }
@@ -1782,14 +1802,18 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int nHeight, con
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
-
-    // Read block
+    // Read block, from the mapped file if there is one
     try {
-        filein >> block;
+        CMappedBlockRecord record;
+        if (pblockfilemapper && pblockfilemapper->GetRecord(pos, "blk", 0, record)) {
+            SpanReader reader(SER_DISK, CLIENT_VERSION, record.begin(), record.end());
+            reader >> block;
+        } else {
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+                return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+            filein >> block;
+        }
     }
     catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
@@ -1814,12 +1838,17 @@ bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex, const Consensus
 }
 
 bool ReadBlockHeaderFromDisk(CBlock &block, const CDiskBlockPos &pos) {
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
-
     try {
-        block.SerializationOp(filein, CBlockHeader::CReadBlockHeader());
+        CMappedBlockRecord record;
+        if (pblockfilemapper && pblockfilemapper->GetRecord(pos, "blk", 0, record)) {
+            SpanReader reader(SER_DISK, CLIENT_VERSION, record.begin(), record.end());
+            block.SerializationOp(reader, CBlockHeader::CReadBlockHeader());
+        } else {
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+                return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+            block.SerializationOp(filein, CBlockHeader::CReadBlockHeader());
+        }
     }
     catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
@@ -2124,6 +2153,20 @@ bool CScriptCheck::operator()() {
     return true;
 }
 
+/**
+ * Fee of a Lelantus joinsplit or Spark spend. A transaction we already accepted into the
+ * mempool had its proof parsed then, the fee is taken from there. Throws like the parsers.
+ */
+static CAmount GetPrivateSpendFee(const CTransaction& tx)
+{
+    CAmount nFee;
+    if (mempool.GetPrivateSpendFee(tx.GetHash(), nFee))
+        return nFee;
+    if (tx.IsLelantusJoinSplit())
+        return lelantus::ParseLelantusJoinSplit(tx)->getFee();
+    return spark::ParseSparkSpend(tx).getFee();
+}
+
 int GetSpendHeight(const CCoinsViewCache& inputs)
 {
     LOCK(cs_main);
@@ -2172,7 +2215,7 @@ bool CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoins
             nTxFee = nValueIn - tx.GetValueOut();
         } else {
             try {
-                nTxFee = lelantus::ParseLelantusJoinSplit(tx)->getFee();
+                nTxFee = GetPrivateSpendFee(tx);
             }
             catch (CBadTxIn&) {
                 return state.DoS(0, false, REJECT_INVALID, "unable to parse joinsplit");
@@ -2211,6 +2254,7 @@ static bool CheckSwap(const CTransaction &tx)
 
 bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks)
 {
+    PERF_SCOPE("validation_check_inputs");
     if (!tx.IsCoinBase() && !tx.HasNoRegularInputs())
     {
         if (!Consensus::CheckTxInputs(tx, state, inputs, GetSpendHeight(inputs)))
@@ -2319,16 +2363,12 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
+template<typename Stream>
+bool UndoReadFromStream(Stream& filein, CBlockUndo& blockundo, const uint256& hashBlock)
 {
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("%s: OpenUndoFile failed", __func__);
-
     // Read block
     uint256 hashChecksum;
-    CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
+    CHashVerifier<Stream> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
     try {
         verifier << hashBlock;
         verifier >> blockundo;
@@ -2347,6 +2387,23 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uin
 
 } // anon namespace
 
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
+{
+    // Read from the mapped file if there is one, the checksum follows the undo data
+    CMappedBlockRecord record;
+    if (pblockfilemapper && pblockfilemapper->GetRecord(pos, "rev", sizeof(uint256), record)) {
+        SpanReader reader(SER_DISK, CLIENT_VERSION, record.begin(), record.end());
+        return UndoReadFromStream(reader, blockundo, hashBlock);
+    }
+
+    // Open history file to read
+    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: OpenUndoFile failed", __func__);
+
+    return UndoReadFromStream(filein, blockundo, hashBlock);
+}
+
 /** Abort with a message */
 bool AbortNode(const std::string& strMessage, const std::string& userMessage)
 {
@@ -2556,6 +2613,10 @@ void static FlushBlockFile(bool fFinalize = false)
         FileCommit(fileOld);
         fclose(fileOld);
     }
+
+    // mappings of the preallocated space are sized for the old file
+    if (fFinalize && pblockfilemapper)
+        pblockfilemapper->Invalidate(nLastBlockFile);
 }
 
 bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigned int nAddSize);
@@ -2635,6 +2696,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 {
     AssertLockHeld(cs_main);
 
+    PERF_SCOPE("validation_connect_block");
     int64_t nTimeStart = GetTimeMicros();
     //btzc: update nHeight, isVerifyDB
     // Check it again in case a previous version let a bad block in
@@ -2804,7 +2866,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 ++nSigma;
             if(tx.IsLelantusJoinSplit()) {
                 try {
-                    nFees += lelantus::ParseLelantusJoinSplit(tx)->getFee();
+                    nFees += GetPrivateSpendFee(tx);
                 }
                 catch (CBadTxIn&) {
                     return state.DoS(0, false, REJECT_INVALID, "unable to parse joinsplit");
@@ -2816,7 +2878,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
             if(tx.IsSparkSpend()) {
                 try {
-                    nFees += spark::ParseSparkSpend(tx).getFee();
+                    nFees += GetPrivateSpendFee(tx);
                 }
                 catch (CBadTxIn&) {
                     return state.DoS(0, false, REJECT_INVALID, "unable to parse spark spend");
@@ -2874,11 +2936,13 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     block.sparkTxInfo->Complete();
 
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
+    PERF_RECORD("validation_connect_block_transactions", nTime3 - nTime2);
     LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * 0.000001);
 
     if (!control.Wait())
         return state.DoS(100, false);
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
+    PERF_RECORD("validation_connect_block_verify", nTime4 - nTime2);
     LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2), nInputs <= 1 ? 0 : 0.001 * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * 0.000001);
 
     //btzc: Add time to check
@@ -3023,6 +3087,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     batchProofContainer->finalize();
 
     int64_t nTime5 = GetTimeMicros(); nTimeIndex += nTime5 - nTime4;
+    PERF_RECORD("validation_connect_block_index", nTime5 - nTime4);
     LogPrint("bench", "    - Index writing: %.2fms [%.2fs]\n", 0.001 * (nTime5 - nTime4), nTimeIndex * 0.000001);
 
     // Watch for changes to the previous coinbase transaction.
@@ -3136,6 +3201,7 @@ void static RemoveConflictingPrivacyTransactionsFromMempool(const CBlock &block)
  * or always and in all cases if we're in prune mode and are deleting files.
  */
 bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int nManualPruneHeight) {
+    PERF_SCOPE("validation_flush_state");
     int64_t nMempoolUsage = mempool.DynamicMemoryUsage();
     const CChainParams& chainparams = Params();
     LOCK2(cs_main, cs_LastBlockFile);
@@ -3172,13 +3238,35 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
         nLastSetChain = nNow;
     }
     int64_t nMempoolSizeMax = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-    int64_t cacheSize = pcoinsTip->DynamicMemoryUsage();
-    cacheSize += evoDb->GetMemoryUsage();
+    // Uncommitted evodb writes and the Spark/Lelantus state share the budget with the coins cache
+    size_t nPrivacyUsage = spark::CSparkState::GetState()->GetMemoryUsage() + lelantus::CLelantusState::GetState()->GetMemoryUsage();
+    int64_t nReservedSize = evoDb->GetMemoryUsage() + CCacheBudget::GetPrivacyStateCharge(nCoinCacheUsage, nPrivacyUsage);
+    int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() + nReservedSize;
     int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
+    int64_t nLargeSpace = std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
+    {
+        uint64_t nHits, nMisses;
+        pcoinsTip->PopHitStats(nHits, nMisses);
+        coinsCacheBudget.AddLookups(nHits, nMisses);
+    }
     // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
-    bool fCacheLarge = mode == FLUSH_STATE_PERIODIC && cacheSize > std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
+    bool fCacheLarge = mode == FLUSH_STATE_PERIODIC && cacheSize > nLargeSpace;
     // The cache is over the limit, we have to write now.
     bool fCacheCritical = mode == FLUSH_STATE_IF_NEEDED && cacheSize > nTotalSpace;
+    if (fCacheLarge || fCacheCritical) {
+        // Coins that were only read can be dropped without touching the disk, try that before writing out the whole cache
+        int64_t nCoinsLimit = std::max<int64_t>(nTotalSpace - nReservedSize, 0);
+        size_t nRemoved = pcoinsTip->UncacheUnmodified(coinsCacheBudget.GetTrimTarget(nCoinsLimit));
+        if (nRemoved > 0) {
+            int64_t nOldSize = cacheSize;
+            cacheSize = pcoinsTip->DynamicMemoryUsage() + nReservedSize;
+            fCacheLarge = fCacheLarge && cacheSize > nLargeSpace;
+            fCacheCritical = fCacheCritical && cacheSize > nTotalSpace;
+            LogPrint("coindb", "%s: dropped %u unmodified coins (%.1fMiB -> %.1fMiB, hit rate %.2f)%s\n", __func__,
+                     nRemoved, nOldSize * (1.0 / 1024 / 1024), cacheSize * (1.0 / 1024 / 1024), coinsCacheBudget.GetHitRate(),
+                     (fCacheLarge || fCacheCritical) ? ", flushing" : "");
+        }
+    }
     // It's been a while since we wrote the block index to disk. Do this frequently, so we don't need to redownload after a crash.
     bool fPeriodicWrite = mode == FLUSH_STATE_PERIODIC && nNow > nLastWrite + (int64_t)DATABASE_WRITE_INTERVAL * 1000000;
     // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
@@ -3516,6 +3604,7 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     const CBlock& blockConnecting = *connectTrace.blocksConnected.back().second;
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
+    PERF_RECORD("validation_connect_tip_read", nTime2 - nTime1);
     int64_t nTime3;
     // LogPrint("bench", "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, nTimeReadFromDisk * 0.000001);
     {
@@ -3532,17 +3621,20 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
             return error("ConnectTip(): ConnectBlock %s failed", pindexNew->GetBlockHash().ToString());
         }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
+        PERF_RECORD("validation_connect_tip_connect", nTime3 - nTime2);
         LogPrint("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
+    PERF_RECORD("validation_connect_tip_flush", nTime4 - nTime3);
     LogPrint("bench", "  - Flush: %.2fms [%.2fs]\n", (nTime4 - nTime3) * 0.001, nTimeFlush * 0.000001);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
         return false;
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
+    PERF_RECORD("validation_connect_tip_chainstate", nTime5 - nTime4);
     LogPrint("bench", "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, nTimeChainState * 0.000001);
 
     // Remove conflicting transactions from the mempool.;
@@ -3568,6 +3660,8 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
 #endif
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
+    PERF_RECORD("validation_connect_tip_postprocess", nTime6 - nTime5);
+    PERF_RECORD("validation_connect_tip", nTime6 - nTime1);
     LogPrint("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
     LogPrint("bench", "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, nTimeTotal * 0.000001);
     return true;
@@ -3779,7 +3873,7 @@ static bool ActivateBestChainStep(CValidationState& state, const CChainParams& c
 
 	    // Changes to mempool should also be made to Dandelion stempool
         LimitMempoolSize(txpools.getStemTxPool(),
-                         GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000,
+                         GetPoolSizeLimit(txpools.getStemTxPool()),
                          GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
     }
     txpools.check(pcoinsTip);
@@ -3961,7 +4055,7 @@ bool InvalidateBlock(CValidationState& state, const CChainParams& chainparams, C
     LimitMempoolSize(mempool, GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
 
     // Changes to mempool should also be made to Dandelion stempool
-    LimitMempoolSize(txpools.getStemTxPool(), GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
+    LimitMempoolSize(txpools.getStemTxPool(), GetPoolSizeLimit(txpools.getStemTxPool()), GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
 
     // The resulting new best tip may not be in setBlockIndexCandidates anymore, so
     // add it again.
@@ -4492,8 +4586,9 @@ bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidatio
     return true;
 }
 
-/** Store block on disk. If dbp is non-NULL, the file is known to already reside on disk */
-static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock)
+/** Store block on disk. If dbp is non-NULL, the file is known to already reside on disk.
+ *  With fCheckPOW false the caller has verified the proof of work already. */
+static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock, bool fCheckPOW = true)
 {
     const CBlock& block = *pblock;
 
@@ -4503,7 +4598,7 @@ static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidation
     CBlockIndex *pindexDummy = NULL;
     CBlockIndex *&pindex = ppindex ? *ppindex : pindexDummy;
 
-    if (!AcceptBlockHeader(block, state, chainparams, &pindex))
+    if (!AcceptBlockHeader(block, state, chainparams, &pindex, fCheckPOW))
         return false;
 
     LogPrintf("AcceptBlock nHeight=%s\n", pindex->nHeight);
@@ -4534,7 +4629,7 @@ static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidation
     }
     if (fNewBlock) *fNewBlock = true;
 
-    if (!CheckBlock(block, state, chainparams.GetConsensus(), true, true, pindex->nHeight, false) ||
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), fCheckPOW, true, pindex->nHeight, false) ||
         !ContextualCheckBlock(block, state, chainparams.GetConsensus(), pindex->pprev)) {
         if (state.IsInvalid() && !state.CorruptionPossible()) {
             pindex->nStatus |= BLOCK_FAILED_VALID;
@@ -4542,6 +4637,9 @@ static bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidation
         }
         return error("%s: %s", __func__, FormatStateMessage(state));
     }
+    // spare ConnectBlock the proof of work check the caller did already
+    if (!fCheckPOW)
+        block.fChecked = true;
 
     // Header is valid/has work, merkle tree is good...RELAY NOW
     // (but if it does not build on our best tip, let the SendMessages loop relay it)
@@ -4610,6 +4708,7 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
 bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams, const CBlock& block, CBlockIndex* pindexPrev, bool fCheckPOW, bool fCheckMerkleRoot)
 {
     AssertLockHeld(cs_main);
+    PERF_SCOPE("validation_test_block_validity");
     assert(pindexPrev && pindexPrev == chainActive.Tip());
 
     CCoinsViewCache viewNew(pcoinsTip);
@@ -4687,6 +4786,8 @@ void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
         CDiskBlockPos pos(*it, 0);
         boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
         boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
+        if (pblockfilemapper)
+            pblockfilemapper->Invalidate(*it);
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
     }
 }
@@ -5142,6 +5243,8 @@ void UnloadBlockIndex()
     vinfoBlockFile.clear();
     nLastBlockFile = 0;
     nBlockSequenceId = 1;
+    if (pblockfilemapper)
+        pblockfilemapper->Clear();
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
     versionbitscache.Clear();
@@ -5214,10 +5317,94 @@ bool InitBlockIndex(const CChainParams& chainparams)
     return true;
 }
 
+namespace {
+
+// Map of disk positions for blocks with unknown parent (only used for reindex)
+std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+
+/**
+ * Accept a block read from a block file, connect it and its earlier
+ * encountered successors. phashLyra2Z is the Lyra2Z hash of the block if it
+ * was computed in advance. Returns false if importing has to stop.
+ */
+bool ImportBlock(const CChainParams& chainparams, const std::shared_ptr<CBlock>& pblock, CDiskBlockPos* dbp, const uint256* phashLyra2Z, int& nLoaded)
+{
+    const CBlock& block = *pblock;
+
+    // detect out of order blocks, and store them for later
+    uint256 hash = block.GetHash();
+    if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
+        LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                block.hashPrevBlock.ToString());
+        if (dbp)
+            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+        return true;
+    }
+    // process in case the block isn't known yet
+    if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
+        LOCK(cs_main);
+        CValidationState state;
+        bool fCheckPOW = true;
+        if (phashLyra2Z) {
+            uint256 hashPoW = CBlockHeader::IsLyra2ZHeight(GetNHeight(block)) ? *phashLyra2Z : hash;
+            if (!CheckProofOfWork(hashPoW, block.nBits, chainparams.GetConsensus()))
+                state.DoS(50, error("%s: proof of work failed for %s", __func__, hash.ToString()), REJECT_INVALID, "high-hash");
+            fCheckPOW = false;
+        }
+        if (state.IsValid() && AcceptBlock(pblock, state, chainparams, NULL, true, dbp, NULL, fCheckPOW))
+            nLoaded++;
+        if (state.IsError())
+            return false;
+    } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
+        LogPrint("reindex", "Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
+    }
+
+    // Activate the genesis block so normal node progress can continue
+// We should call it for every block as our tx verification algos rely on the real block heights.
+//                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
+    // Passing the block on spares reading it back from disk to connect it
+    CValidationState state;
+    if (!ActivateBestChain(state, chainparams, pblock)) {
+        return false;
+    }
+
+    NotifyHeaderTip();
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+            int nHeight = mapBlockIndex[head]->nHeight+1;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second, nHeight, chainparams.GetConsensus()))
+            {
+                LogPrint("reindex", "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                CValidationState dummy;
+                if (AcceptBlock(pblockrecursive, dummy, chainparams, NULL, true, &it->second, NULL))
+                {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+            NotifyHeaderTip();
+        }
+    }
+    return true;
+}
+
+} // anon namespace
+
 bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
 {
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
@@ -5256,69 +5443,11 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos);
                 std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
+                blkdat >> *pblock;
                 nRewind = blkdat.GetPos();
 
-                // detect out of order blocks, and store them for later
-                uint256 hash = block.GetHash();
-                if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
-                    LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                            block.hashPrevBlock.ToString());
-                    if (dbp)
-                        mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                    continue;
-                }
-                // process in case the block isn't known yet
-                if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
-                    LOCK(cs_main);
-                    CValidationState state;
-                    if (AcceptBlock(pblock, state, chainparams, NULL, true, dbp, NULL))
-                        nLoaded++;
-                    if (state.IsError())
-                        break;
-                } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
-                    LogPrint("reindex", "Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
-                }
-
-                // Activate the genesis block so normal node progress can continue
-// We should call it for every block as our tx verification algos rely on the real block heights.
-//                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
-                    CValidationState state;
-                    if (!ActivateBestChain(state, chainparams)) {
-                        break;
-                    }
-
-                NotifyHeaderTip();
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        int nHeight = mapBlockIndex[head]->nHeight+1;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, nHeight, chainparams.GetConsensus()))
-                        {
-                            LogPrint("reindex", "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            CValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, chainparams, NULL, true, &it->second, NULL))
-                            {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip();
-                    }
-                }
+                if (!ImportBlock(chainparams, pblock, dbp, NULL, nLoaded))
+                    break;
             } catch (const std::exception& e) {
                 LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
@@ -5331,6 +5460,29 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
     return nLoaded > 0;
 }
 
+bool LoadReindexBlocks(const CChainParams& chainparams, int nFile, std::vector<CReindexBlock>& vBlocks)
+{
+    int64_t nStart = GetTimeMillis();
+
+    int nLoaded = 0;
+    for (CReindexBlock& block : vBlocks) {
+        boost::this_thread::interruption_point();
+        try {
+            CDiskBlockPos pos(nFile, block.nPos);
+            bool fContinue = ImportBlock(chainparams, block.pblock, &pos, &block.hashLyra2Z, nLoaded);
+            // the block is on disk, don't keep the parsed one around until the whole file is done
+            block.pblock.reset();
+            if (!fContinue)
+                break;
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+        }
+    }
+    if (nLoaded > 0)
+        LogPrintf("Loaded %i blocks from blk%05u.dat in %dms\n", nLoaded, (unsigned int)nFile, GetTimeMillis() - nStart);
+    return nLoaded > 0;
+}
+
 void static CheckBlockIndex(const Consensus::Params& consensusParams)
 {
     if (!fCheckBlockIndex) {
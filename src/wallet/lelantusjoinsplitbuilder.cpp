@@ -19,9 +19,38 @@ struct CoinCompare
     }
 };
 
-LelantusJoinSplitBuilder::LelantusJoinSplitBuilder(CWallet& wallet, CHDMintWallet& mintWallet, const CCoinControl *coinControl) :
+const LelantusAnonymitySetCache::Entry& LelantusAnonymitySetCache::Get(int groupId)
+{
+    AssertLockHeld(cs_main);
+
+    auto it = sets.find(groupId);
+    if (it != sets.end()) {
+        auto mi = mapBlockIndex.find(it->second.blockHash);
+        if (mi != mapBlockIndex.end() && chainActive.Contains(mi->second))
+            return it->second;
+        sets.erase(it);
+    }
+
+    Entry entry;
+    std::vector<lelantus::PublicCoin> set;
+    if (lelantus::CLelantusState::GetState()->GetCoinSetForSpend(
+            &chainActive,
+            chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1), // required 1 confirmation for mint to spend
+            groupId,
+            entry.blockHash,
+            set,
+            entry.setHash) < 2)
+        throw std::runtime_error(
+                _("Has to have at least two mint coins with at least 1 confirmation in order to spend a coin"));
+    entry.set = std::make_shared<const std::vector<lelantus::PublicCoin>>(std::move(set));
+
+    return sets.emplace(groupId, std::move(entry)).first->second;
+}
+
+LelantusJoinSplitBuilder::LelantusJoinSplitBuilder(CWallet& wallet, CHDMintWallet& mintWallet, const CCoinControl *coinControl, LelantusAnonymitySetCache *setCache) :
     wallet(wallet),
-    mintWallet(mintWallet)
+    mintWallet(mintWallet),
+    setCache(setCache ? setCache : &localSetCache)
 {
     cs_main.lock();
 
@@ -278,7 +307,15 @@ CWalletTx LelantusJoinSplitBuilder::Build(
         // now every fields is populated then we can sign transaction
         uint256 sig = tx.GetHash();
 
-        CreateJoinSplit(sig, Cout, currentVout, fee, tx);
+        if (unprovenJob) {
+            PrepareJoinSplit(sig, Cout, currentVout, fee, *unprovenJob);
+            result.SetTx(MakeTransactionRef(tx));
+            break;
+        }
+
+        LelantusJoinSplitProofJob job;
+        PrepareJoinSplit(sig, Cout, currentVout, fee, job);
+        ProveJoinSplit(job, tx);
 
         // check fee
         result.SetTx(MakeTransactionRef(tx));
@@ -324,6 +361,23 @@ CWalletTx LelantusJoinSplitBuilder::Build(
 
 }
 
+CWalletTx LelantusJoinSplitBuilder::BuildUnproven(
+    const std::vector<CRecipient>& recipients,
+    CAmount &fee,
+    const std::vector<CAmount>& newMints,
+    LelantusJoinSplitProofJob& job)
+{
+    unprovenJob = &job;
+    try {
+        CWalletTx result = Build(recipients, fee, newMints);
+        unprovenJob = nullptr;
+        return result;
+    } catch (...) {
+        unprovenJob = nullptr;
+        throw;
+    }
+}
+
 void LelantusJoinSplitBuilder::GenerateMints(const std::vector<CAmount>& newMints, const CAmount& changeToMint, std::vector<lelantus::PrivateCoin>& Cout, std::vector<CTxOut>& outputs) {
     mintCoins.clear();
     Cout.clear();
@@ -382,30 +436,26 @@ void LelantusJoinSplitBuilder::GenerateMints(const std::vector<CAmount>& newMint
     }
 }
 
-void LelantusJoinSplitBuilder::CreateJoinSplit(
+void LelantusJoinSplitBuilder::PrepareJoinSplit(
         const uint256& txHash,
         const std::vector<lelantus::PrivateCoin>& Cout,
         const uint64_t& Vout,
         const uint64_t& fee,
-        CMutableTransaction& tx) {
+        LelantusJoinSplitProofJob& job) {
 
     lelantus::CLelantusState* state = lelantus::CLelantusState::GetState();
     auto params = lelantus::Params::get_default();
 
-    std::vector<std::pair<lelantus::PrivateCoin, uint32_t>> coins;
-    coins.reserve(spendCoins.size());
-    std::map<uint32_t, std::vector<lelantus::PublicCoin>> anonymity_sets;
-    std::map<uint32_t, uint256> groupBlockHashes;
-    int version = 0;
-    version = LELANTUS_TX_TPAYLOAD;
+    job = LelantusJoinSplitProofJob();
+    job.coins.reserve(spendCoins.size());
+    job.version = LELANTUS_TX_TPAYLOAD;
 
-    std::vector<std::vector<unsigned char>> anonymity_set_hashes;
     for (const auto &spend : spendCoins) {
         // construct public part of the mint
         lelantus::PublicCoin pub(spend.value);
         // construct private part of the mint
         lelantus::PrivateCoin priv(params, spend.amount);
-        priv.setVersion(version);
+        priv.setVersion(job.version);
         priv.setSerialNumber(spend.serialNumber);
         priv.setRandomness(spend.randomness);
         priv.setEcdsaSeckey(spend.ecdsaSecretKey);
@@ -427,37 +477,35 @@ void LelantusJoinSplitBuilder::CreateJoinSplit(
                 groupId += 1;
         }
 
-        coins.emplace_back(std::make_pair(priv, groupId));
-        std::vector<unsigned char> setHash;
-        if (anonymity_sets.count(groupId) == 0) {
-            std::vector<lelantus::PublicCoin> set;
-            uint256 blockHash;
-            if (state->GetCoinSetForSpend(
-                    &chainActive,
-                    chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1), // required 1 confirmation for mint to spend
-                    groupId,
-                    blockHash,
-                    set,
-                    setHash) < 2)
-                throw std::runtime_error(
-                        _("Has to have at least two mint coins with at least 1 confirmation in order to spend a coin"));
-            groupBlockHashes[groupId] = blockHash;
-            anonymity_sets[groupId] = set;
-            if (!setHash.empty())
-                anonymity_set_hashes.push_back(setHash);
+        job.coins.emplace_back(std::make_pair(priv, groupId));
+        if (job.anonymity_sets.count(groupId) == 0) {
+            const LelantusAnonymitySetCache::Entry& entry = setCache->Get(groupId);
+            job.groupBlockHashes[groupId] = entry.blockHash;
+            job.anonymity_sets[groupId] = entry.set;
+            if (!entry.setHash.empty())
+                job.anonymity_set_hashes.push_back(entry.setHash);
         }
     }
 
-    std::sort(coins.begin(), coins.end(), CoinCompare());
+    std::sort(job.coins.begin(), job.coins.end(), CoinCompare());
+
+    job.Cout = Cout;
+    job.Vout = Vout;
+    job.fee = fee;
+    job.txHash = txHash;
+}
+
+void LelantusJoinSplitBuilder::ProveJoinSplit(const LelantusJoinSplitProofJob& job, CMutableTransaction& tx) {
+    auto params = lelantus::Params::get_default();
 
-    lelantus::JoinSplit joinSplit(params, coins, anonymity_sets, anonymity_set_hashes, Vout, Cout, fee, groupBlockHashes, txHash, version);
+    lelantus::JoinSplit joinSplit(params, job.coins, job.anonymity_sets, job.anonymity_set_hashes, job.Vout, job.Cout, job.fee, job.groupBlockHashes, job.txHash, job.version);
 
     std::vector<lelantus::PublicCoin>  pCout;
-    pCout.reserve(Cout.size());
-    for(const auto& coin : Cout)
+    pCout.reserve(job.Cout.size());
+    for(const auto& coin : job.Cout)
         pCout.emplace_back(coin.getPublicCoin());
 
-    if (!joinSplit.Verify(anonymity_sets, anonymity_set_hashes, pCout, Vout, txHash)) {
+    if (!joinSplit.Verify(job.anonymity_sets, job.anonymity_set_hashes, pCout, job.Vout, job.txHash)) {
         throw std::runtime_error(_("The joinsplit transaction failed to verify"));
     }
 
@@ -9,10 +9,43 @@
 
 #include "../hdmint/wallet.h"
 
+#include <map>
+
+/**
+ * Anonymity sets loaded for joinsplits, shared by the transactions of a batch.
+ * A set stays usable as long as the block it was taken at is in the active
+ * chain, so a set is only loaded again after a reorg. cs_main must be held.
+ */
+class LelantusAnonymitySetCache {
+public:
+    struct Entry {
+        uint256 blockHash;
+        std::shared_ptr<const std::vector<lelantus::PublicCoin>> set;
+        std::vector<unsigned char> setHash;
+    };
+
+    const Entry& Get(int groupId);
+
+private:
+    std::map<int, Entry> sets;
+};
+
+/** Everything the Lelantus prover needs for a joinsplit, no wallet or chain state */
+struct LelantusJoinSplitProofJob {
+    std::vector<std::pair<lelantus::PrivateCoin, uint32_t>> coins;
+    lelantus::shared_anonymity_sets anonymity_sets;
+    std::vector<std::vector<unsigned char>> anonymity_set_hashes;
+    std::map<uint32_t, uint256> groupBlockHashes;
+    std::vector<lelantus::PrivateCoin> Cout;
+    uint64_t Vout = 0;
+    uint64_t fee = 0;
+    uint256 txHash;
+    unsigned int version = 0;
+};
 
 class LelantusJoinSplitBuilder {
 public:
-    LelantusJoinSplitBuilder(CWallet& wallet, CHDMintWallet& mintWallet, const CCoinControl *coinControl = nullptr);
+    LelantusJoinSplitBuilder(CWallet& wallet, CHDMintWallet& mintWallet, const CCoinControl *coinControl = nullptr, LelantusAnonymitySetCache *setCache = nullptr);
     ~LelantusJoinSplitBuilder();
 
     CWalletTx Build(
@@ -21,14 +54,25 @@ public:
         const std::vector<CAmount>& newMintss,
         std::function<void(CTxOut & , LelantusJoinSplitBuilder const &)> outModifier = nullptr);
 
+    // Same as Build with the estimated fee, but the proof is left out: the
+    // returned transaction has no payload until ProveJoinSplit ran on job,
+    // which needs no locks. The fee is not checked against the proven size.
+    CWalletTx BuildUnproven(
+        const std::vector<CRecipient>& recipients,
+        CAmount &fee,
+        const std::vector<CAmount>& newMints,
+        LelantusJoinSplitProofJob& job);
+
+    static void ProveJoinSplit(const LelantusJoinSplitProofJob& job, CMutableTransaction& tx);
+
 private:
     void GenerateMints(const std::vector<CAmount>& newMints, const CAmount& changeToMint, std::vector<lelantus::PrivateCoin>& Cout, std::vector<CTxOut>& outputs);
-    void CreateJoinSplit(
+    void PrepareJoinSplit(
             const uint256& txHash,
             const std::vector<lelantus::PrivateCoin>& Cout,
             const uint64_t& Vout,
             const uint64_t& fee,
-            CMutableTransaction& tx);
+            LelantusJoinSplitProofJob& job);
 
 public:
     std::vector<CLelantusEntry> spendCoins;
@@ -41,6 +85,9 @@ public:
 
 private:
     CHDMintWallet& mintWallet;
+    LelantusAnonymitySetCache localSetCache;
+    LelantusAnonymitySetCache *setCache;
+    LelantusJoinSplitProofJob *unprovenJob = nullptr;
 };
 
 
@@ -0,0 +1,120 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "../liblelantus/threadpool.h"
+#include "rescan.h"
+#include "wallet.h"
+
+#include "../chain.h"
+#include "../chainparams.h"
+#include "../script/ismine.h"
+#include "../spark/state.h"
+#include "../validation.h"
+
+#include <algorithm>
+
+CWalletRescanPipeline::CWalletRescanPipeline(const CWallet& wallet, int nThreads) :
+    wallet(wallet)
+{
+    if (nThreads <= 0)
+        nThreads = boost::thread::hardware_concurrency();
+    this->nThreads = std::max(nThreads, 1);
+    nMaxInFlight = (size_t)this->nThreads * RESCAN_BLOCKS_PER_THREAD;
+    workerPool.reset(new ParallelOpThreadPool<void>(this->nThreads));
+}
+
+CWalletRescanPipeline::~CWalletRescanPipeline()
+{
+    // Shutdown drains the queued tasks, they still reference the entries we hold
+    workerPool->Shutdown();
+}
+
+void CWalletRescanPipeline::Push(const CBlockIndex* pindex, size_t nKeyGeneration)
+{
+    std::shared_ptr<CWalletRescanBlock> entry = std::make_shared<CWalletRescanBlock>(pindex, nKeyGeneration);
+    queue.push_back(entry);
+
+    const CWallet* pwallet = &wallet;
+    workerPool->PostTask([pwallet, entry]() {
+        try {
+            ProcessBlock(*pwallet, *entry);
+        } catch (const std::exception& e) {
+            LogPrintf("%s: failed to process block %s: %s\n", __func__, entry->pindex->GetBlockHash().ToString(), e.what());
+            entry->fRead = false;
+        }
+        entry->done.set_value();
+    });
+}
+
+std::shared_ptr<CWalletRescanBlock> CWalletRescanPipeline::Pop()
+{
+    if (queue.empty())
+        return nullptr;
+
+    std::shared_ptr<CWalletRescanBlock> entry = queue.front();
+    queue.pop_front();
+    entry->done.get_future().wait();
+    return entry;
+}
+
+void CWalletRescanPipeline::ProcessBlock(const CWallet& wallet, CWalletRescanBlock& entry)
+{
+    if (!ReadBlockFromDisk(entry.block, entry.pindex, Params().GetConsensus()))
+        return;
+    entry.fRead = true;
+
+    entry.vCandidate.assign(entry.block.vtx.size(), false);
+    for (size_t i = 0; i < entry.block.vtx.size(); ++i) {
+        if (IsCandidate(wallet, *entry.block.vtx[i])) {
+            entry.vCandidate[i] = true;
+            ++entry.nCandidates;
+        }
+    }
+}
+
+bool CWalletRescanPipeline::IsCandidate(const CWallet& wallet, const CTransaction& tx)
+{
+    // Private spends are matched against mints found in earlier blocks, which the commit thread may not have added yet
+    if (tx.HasNoRegularInputs())
+        return true;
+
+    std::vector<unsigned char> serialContext;
+    for (const CTxOut& txout : tx.vout) {
+        const CScript& script = txout.scriptPubKey;
+        if (script.IsLelantusMint() || script.IsLelantusJMint()) {
+            // Lelantus mints are looked up in the wallet database
+            return true;
+        } else if (script.IsSparkMint() || script.IsSparkSMint()) {
+            if (!wallet.sparkWallet)
+                continue;
+            if (serialContext.empty())
+                serialContext = spark::getSerialContext(tx);
+
+            spark::Coin coin(spark::Params::get_default());
+            try {
+                spark::ParseSparkMintCoin(script, coin);
+            } catch (const std::exception &) {
+                continue;
+            }
+            coin.setSerialContext(serialContext);
+            if (wallet.sparkWallet->isMine(coin))
+                return true;
+        } else if (::IsMine(wallet, script) != ISMINE_NO) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CWalletRescanPipeline::IsMineOutputs(const CWallet& wallet, const CTransaction& tx)
+{
+    for (const CTxOut& txout : tx.vout) {
+        const CScript& script = txout.scriptPubKey;
+        if (script.IsLelantusMint() || script.IsLelantusJMint() || script.IsSparkMint() || script.IsSparkSMint())
+            continue;
+        if (::IsMine(wallet, script) != ISMINE_NO)
+            return true;
+    }
+    return false;
+}
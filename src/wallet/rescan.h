@@ -0,0 +1,90 @@
+// Copyright (c) 2025 The BZX Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BZX_WALLET_RESCAN_H
+#define BZX_WALLET_RESCAN_H
+
+#include "../primitives/block.h"
+
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+class CBlockIndex;
+class CWallet;
+template <typename Result>
+class ParallelOpThreadPool;
+
+//! -rescanthreads default, 0 means one worker per core
+static const int DEFAULT_RESCAN_THREADS = 0;
+//! Number of blocks kept in flight per rescan worker
+static const int RESCAN_BLOCKS_PER_THREAD = 8;
+
+/**
+ * A block loaded and pre-filtered by a rescan worker.
+ *
+ * vCandidate[i] is set when transaction i pays to one of our keys, carries a
+ * Spark output identified by our incoming view key, or needs wallet state
+ * (Lelantus mints, private spends) to be decided. Inputs spending wallet
+ * outputs are checked again on the commit thread.
+ */
+struct CWalletRescanBlock
+{
+    const CBlockIndex* pindex;
+    //! mapKeyMetadata size when the block was queued, see CWalletRescanPipeline::Pop
+    size_t nKeyGeneration;
+    bool fRead;
+    CBlock block;
+    std::vector<bool> vCandidate;
+    size_t nCandidates;
+
+    std::promise<void> done;
+
+    CWalletRescanBlock(const CBlockIndex* pindexIn, size_t nKeyGenerationIn) :
+        pindex(pindexIn), nKeyGeneration(nKeyGenerationIn), fRead(false), nCandidates(0) {}
+};
+
+/**
+ * Rescan pipeline: blocks are read, deserialized and matched against the
+ * wallet keys on a pool of workers while the caller commits the results
+ * in height order on its own thread.
+ *
+ * Workers never take cs_main or cs_wallet, so the caller may hold both
+ * while pushing and popping blocks.
+ */
+class CWalletRescanPipeline
+{
+public:
+    CWalletRescanPipeline(const CWallet& wallet, int nThreads);
+    ~CWalletRescanPipeline();
+
+    //! Queue a block for loading and filtering
+    void Push(const CBlockIndex* pindex, size_t nKeyGeneration);
+    //! Wait for the oldest queued block, nullptr if nothing is queued
+    std::shared_ptr<CWalletRescanBlock> Pop();
+
+    bool Full() const { return queue.size() >= nMaxInFlight; }
+    bool Empty() const { return queue.empty(); }
+    int GetNumThreads() const { return nThreads; }
+
+    //! Transparent output checks only, used when the keystore grew after the block was queued
+    static bool IsMineOutputs(const CWallet& wallet, const CTransaction& tx);
+
+private:
+    static void ProcessBlock(const CWallet& wallet, CWalletRescanBlock& entry);
+    static bool IsCandidate(const CWallet& wallet, const CTransaction& tx);
+
+    const CWallet& wallet;
+    int nThreads;
+    size_t nMaxInFlight;
+    // only forward declared here to keep boost futures out of the wallet headers
+    std::unique_ptr<ParallelOpThreadPool<void>> workerPool;
+    std::deque<std::shared_ptr<CWalletRescanBlock>> queue;
+};
+
+#endif // BZX_WALLET_RESCAN_H
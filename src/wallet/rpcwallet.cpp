@@ -2078,14 +2078,14 @@ UniValue gettransaction(const JSONRPCRequest& request)
     CAmount nFee = (wtx.IsFromMe(filter) ? wtx.tx->GetValueOut() - nDebit : 0);
     if (wtx.tx->vin[0].IsLelantusJoinSplit()) {
         try {
-            nFee = (0 - lelantus::ParseLelantusJoinSplit(*wtx.tx)->getFee());
+            nFee = (0 - lelantus::GetParsedLelantusJoinSplit(*wtx.tx)->getFee());
         }
         catch (const std::exception &) {
             // do nothing
         }
     } else if (wtx.tx->IsSparkSpend()) {
         try {
-            nFee = (0 - spark::ParseSparkSpend(*wtx.tx).getFee());
+            nFee = (0 - spark::GetParsedSparkSpend(*wtx.tx)->getFee());
         }
         catch (const std::exception &) {
             // do nothing
@@ -3978,7 +3978,8 @@ UniValue lelantustospark(const JSONRPCRequest& request) {
     if (request.fHelp || request.params.size() > 0) {
         throw std::runtime_error(
                 "lelantustospark \n"
-                "Takes all your lelantus mints, spends all to transparent layer, takes all that UTX's and mints to Spark");
+                "Takes all your lelantus mints, spends all to transparent layer, takes all that UTX's and mints to Spark\n"
+                "See getlelantustosparkprogress for the progress of a running migration");
     }
 
     if (!lelantus::IsLelantusGraceFulPeriod()) {
@@ -4003,6 +4004,55 @@ UniValue lelantustospark(const JSONRPCRequest& request) {
     return NullUniValue;
 }
 
+UniValue getlelantustosparkprogress(const JSONRPCRequest& request) {
+    CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
+    if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
+        return NullUniValue;
+    }
+
+    if (request.fHelp || request.params.size() > 0) {
+        throw std::runtime_error(
+                "getlelantustosparkprogress \n"
+                "Returns the progress of the running or last lelantustospark migration\n"
+                "\nResult:\n"
+                "{\n"
+                "  \"running\": true|false,        (boolean) If the migration is still running\n"
+                "  \"starttime\": n,               (numeric) Start time of the migration in seconds since epoch, 0 if there was none\n"
+                "  \"endtime\": n,                 (numeric) End time of the migration in seconds since epoch, 0 while running\n"
+                "  \"transactions\": n,            (numeric) Number of planned joinsplits\n"
+                "  \"coins\": n,                   (numeric) Number of lelantus coins they spend\n"
+                "  \"skippedcoins\": n,            (numeric) Number of lelantus coins too small to pay their fee\n"
+                "  \"proved\": n,                  (numeric) Number of joinsplits proven so far\n"
+                "  \"committed\": n,               (numeric) Number of joinsplits committed and minted to Spark so far\n"
+                "  \"migrated\": x.xxx,            (numeric) Amount minted to Spark so far in " + CURRENCY_UNIT + "\n"
+                "  \"fees\": x.xxx,                (numeric) Fees paid so far in " + CURRENCY_UNIT + "\n"
+                "  \"error\": \"...\"              (string, optional) Why the migration stopped\n"
+                "}\n"
+                "\nExamples:\n"
+                + HelpExampleCli("getlelantustosparkprogress", "")
+                + HelpExampleRpc("getlelantustosparkprogress", ""));
+    }
+
+    assert(pwallet != NULL);
+    CLelantusToSparkProgress progress = pwallet->GetLelantusToSparkProgress();
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("running", progress.fRunning));
+    result.push_back(Pair("starttime", progress.nStartTime));
+    result.push_back(Pair("endtime", progress.nEndTime));
+    result.push_back(Pair("transactions", (uint64_t)progress.nTransactions));
+    result.push_back(Pair("coins", (uint64_t)progress.nCoins));
+    result.push_back(Pair("skippedcoins", (uint64_t)progress.nSkippedCoins));
+    result.push_back(Pair("proved", (uint64_t)progress.nProved));
+    result.push_back(Pair("committed", (uint64_t)progress.nCommitted));
+    result.push_back(Pair("migrated", ValueFromAmount(progress.nMigrated)));
+    result.push_back(Pair("fees", ValueFromAmount(progress.nFees)));
+    if (!progress.strError.empty())
+        result.push_back(Pair("error", progress.strError));
+
+    return result;
+}
+
 UniValue identifysparkcoins(const JSONRPCRequest& request)
 {
     CWallet * const pwallet = GetWalletForJSONRPCRequest(request);
@@ -5297,6 +5347,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "automintspark",          &automintspark,          false, {} },
     { "wallet",             "spendspark",             &spendspark,             false, {} },
     { "wallet",             "lelantustospark",        &lelantustospark,        false, {} },
+    { "wallet",             "getlelantustosparkprogress", &getlelantustosparkprogress, false, {} },
     { "wallet",             "identifysparkcoins",     &identifysparkcoins,     false, {} },
     { "wallet",             "getsparkcoinaddr",       &getsparkcoinaddr,       false, {} },
     { "wallet",             "registersparkname",      &registersparkname,      false, {} },
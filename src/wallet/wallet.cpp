@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "../liblelantus/threadpool.h"
 #include "wallet.h"
 #include "boost/filesystem/operations.hpp"
 #include "libspark/keys.h"
@@ -42,6 +43,7 @@
 #include "hdmint/wallet.h"
 #include "rpc/protocol.h"
 #include "wallet/bip39.h"
+#include "wallet/rescan.h"
 
 #include "crypto/hmac_sha512.h"
 #include "crypto/aes.h"
@@ -2200,14 +2202,14 @@ void CWalletTx::GetAmounts(std::list<COutputEntry>& listReceived,
     {
         if (tx->IsLelantusJoinSplit()) {
             try {
-                nFee = lelantus::ParseLelantusJoinSplit(*tx)->getFee();
+                nFee = lelantus::GetParsedLelantusJoinSplit(*tx)->getFee();
             }
             catch (const std::exception &) {
                 // do nothing
             }
         } else if (tx->IsSparkSpend()) {
             try {
-                nFee = spark::ParseSparkSpend(*tx).getFee();
+                nFee = spark::GetParsedSparkSpend(*tx)->getFee();
             }
             catch (const std::exception &) {
                 // do nothing
@@ -2355,36 +2357,82 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex *pindexStart, bool f
         ShowProgress(_("Rescanning..."), 0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
         double dProgressStart = Checkpoints::GuessVerificationProgress(pindex);
         double dProgressTip = Checkpoints::GuessVerificationProgress(chainActive.Tip());
+
+        // Blocks are read and matched against our keys on the pipeline workers,
+        // wallet updates are committed here in height order.
+        CWalletRescanPipeline pipeline(*this, GetArg("-rescanthreads", DEFAULT_RESCAN_THREADS));
+        CBlockIndex* pindexQueue = pindex;
+        int64_t nStartTime = GetTimeMillis();
+        int64_t nBlocks = 0, nTxs = 0, nMatched = 0;
         while (pindex)
         {
             // A temporary fix for inability to Ctrl-C rescan when restoring a wallet (will be fixed in 0.15.)
             if (ShutdownRequested())
                 return nullptr;
+            while (pindexQueue && !pipeline.Full()) {
+                pipeline.Push(pindexQueue, mapKeyMetadata.size());
+                pindexQueue = chainActive.Next(pindexQueue);
+            }
             if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
                 ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(pindex) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
             if (GetTime() >= nNow + 60) {
                 nNow = GetTime();
-                LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, Checkpoints::GuessVerificationProgress(pindex));
+                double dElapsed = std::max(GetTimeMillis() - nStartTime, (int64_t)1) * 0.001;
+                LogPrintf("Still rescanning. At block %d. Progress=%f (%.1f blocks/s, %.1f tx/s)\n", pindex->nHeight, Checkpoints::GuessVerificationProgress(pindex),
+                          nBlocks / dElapsed, nTxs / dElapsed);
             }
 
-            CBlock block;
-            if (ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+            std::shared_ptr<CWalletRescanBlock> entry = pipeline.Pop();
+            assert(entry && entry->pindex == pindex);
+            if (entry->fRead) {
+                const CBlock& block = entry->block;
+                // Keys added since the block was queued (keypool top-up on a used key) were not seen by the worker
+                bool fKeysChanged = mapKeyMetadata.size() != entry->nKeyGeneration;
                 for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                    AddToWalletIfInvolvingMe(*block.vtx[posInBlock], pindex, posInBlock, fUpdate);
+                    const CTransaction& tx = *block.vtx[posInBlock];
+                    if (!entry->vCandidate[posInBlock] && !IsKnownOrSpendsWalletOutput(tx)
+                            && !(fKeysChanged && CWalletRescanPipeline::IsMineOutputs(*this, tx)))
+                        continue;
+                    if (AddToWalletIfInvolvingMe(tx, pindex, posInBlock, fUpdate))
+                        ++nMatched;
                 }
+                nTxs += block.vtx.size();
                 if (!ret) {
                     ret = pindex;
                 }
             } else {
                 ret = nullptr;
             }
+            ++nBlocks;
             pindex = chainActive.Next(pindex);
         }
+        double dElapsed = std::max(GetTimeMillis() - nStartTime, (int64_t)1) * 0.001;
+        LogPrintf("Rescan finished: %d blocks, %d transactions, %d added or updated in %.2fs (%.1f blocks/s, %d threads)\n",
+                  nBlocks, nTxs, nMatched, dElapsed, nBlocks / dElapsed, pipeline.GetNumThreads());
         ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
     }
     return ret;
 }
 
+/**
+ * Wallet state checks for transactions the rescan workers did not match:
+ * the transaction is already known or spends an outpoint we track.
+ */
+bool CWallet::IsKnownOrSpendsWalletOutput(const CTransaction& tx) const
+{
+    AssertLockHeld(cs_wallet);
+
+    if (mapWallet.count(tx.GetHash()))
+        return true;
+    if (tx.IsCoinBase())
+        return false;
+    for (const CTxIn& txin : tx.vin) {
+        if (mapWallet.count(txin.prevout.hash) || mapTxSpends.count(txin.prevout))
+            return true;
+    }
+    return false;
+}
+
 void CWallet::ReacceptWalletTransactions()
 {
     // If transactions aren't being broadcasted, don't let them into local mempool either
@@ -4933,63 +4981,246 @@ CWalletTx CWallet::SpendAndStoreSpark(
     return result;
 }
 
+CLelantusToSparkProgress CWallet::GetLelantusToSparkProgress() const {
+    LOCK(cs_lelantusToSpark);
+    return lelantusToSparkProgress;
+}
+
+// 1054 is constant part, mainly Schnorr and Range proofs, 2560 is for each sigma/aux data
+// 179 other parts of tx, assuming 1 utxo and 1 jmint
+static unsigned int EstimateJoinSplitSize(size_t nInputs)
+{
+    return 1054 + 2560 * nInputs + 179;
+}
+
+std::vector<std::vector<CLelantusEntry>> CWallet::PlanLelantusToSpark(const std::list<CLelantusEntry>& coins, const CScript& scriptChange, size_t& nSkippedRet) const {
+    const auto& consensusParams = Params().GetConsensus();
+
+    // same size estimate as EstimateJoinSplitFee, the change is an empty jmint
+    auto canPayFee = [&](const std::vector<CLelantusEntry>& batch) {
+        CAmount value = 0;
+        for (const auto& coin : batch)
+            value += coin.amount;
+        CAmount fee = CWallet::GetMinimumFee(EstimateJoinSplitSize(batch.size()), nTxConfirmTarget, mempool);
+        return !CTxOut(value - fee, scriptChange).IsDust(minRelayTxFee);
+    };
+
+    std::vector<std::vector<CLelantusEntry>> plan;
+    CAmount spendValue = 0;
+    for (const auto& coin : coins) {
+        if (plan.empty() || plan.back().size() >= consensusParams.nMaxLelantusInputPerTransaction
+                || spendValue + coin.amount > consensusParams.nMaxValueLelantusSpendPerTransaction) {
+            plan.emplace_back();
+            spendValue = 0;
+        }
+        plan.back().push_back(coin);
+        spendValue += coin.amount;
+    }
+
+    // a short last joinsplit can often be paid for by the one before it
+    if (plan.size() > 1 && !canPayFee(plan.back())) {
+        std::vector<CLelantusEntry> merged = plan[plan.size() - 2];
+        CAmount mergedValue = 0;
+        for (const auto& coin : merged)
+            mergedValue += coin.amount;
+        merged.insert(merged.end(), plan.back().begin(), plan.back().end());
+        if (merged.size() <= consensusParams.nMaxLelantusInputPerTransaction
+                && mergedValue + spendValue <= consensusParams.nMaxValueLelantusSpendPerTransaction) {
+            plan.pop_back();
+            plan.back().swap(merged);
+        }
+    }
+
+    nSkippedRet = 0;
+    std::vector<std::vector<CLelantusEntry>> result;
+    result.reserve(plan.size());
+    for (auto& batch : plan) {
+        if (canPayFee(batch))
+            result.push_back(std::move(batch));
+        else
+            nSkippedRet += batch.size();
+    }
+    return result;
+}
+
 bool CWallet::LelantusToSpark(std::string& strFailReason) {
-    std::list<CLelantusEntry> coins = GetAvailableLelantusCoins();
-    CScript scriptChange;
     {
-        // Reserve a new key pair from key pool
-        CPubKey vchPubKey;
-        bool ret;
-        ret = CReserveKey(this).GetReservedKey(vchPubKey);
-        if (!ret)
-        {
-            strFailReason = _("Keypool ran out, please call keypoolrefill first");
+        LOCK(cs_lelantusToSpark);
+        if (lelantusToSparkProgress.fRunning) {
+            strFailReason = _("Lelantus to Spark migration is already running");
             return false;
         }
-
-        scriptChange = GetScriptForDestination(vchPubKey.GetID());
+        lelantusToSparkProgress = CLelantusToSparkProgress();
+        lelantusToSparkProgress.fRunning = true;
+        lelantusToSparkProgress.nStartTime = GetTime();
     }
+    auto finish = [this](const std::string& strError) {
+        LOCK(cs_lelantusToSpark);
+        lelantusToSparkProgress.fRunning = false;
+        lelantusToSparkProgress.nEndTime = GetTime();
+        lelantusToSparkProgress.strError = strError;
+    };
 
-    while (coins.size() > 0) {
-        std::size_t selectedNum = 0;
-        CCoinControl coinControl;
-        CAmount spendValue = 0;
-        while (true) {
-            COutPoint outPoint;
-            if (coins.size() > 0) {
-                auto coin = coins.begin();
-                lelantus::GetOutPoint(outPoint, coin->value);
-                coinControl.Select(outPoint);
-                spendValue += coin->amount;
-                selectedNum++;
-                coins.erase(coin);
-            } else
-                break;
-
-             if ((spendValue + coins.begin()->amount) > Params().GetConsensus().nMaxValueLelantusSpendPerTransaction)
-                 break;
+    // a joinsplit of the migration, from its setup to the Spark mint of its output
+    struct PendingJoinSplit {
+        std::vector<CLelantusEntry> coins;
+        CRecipient recipient;
+        CAmount fee = 0;
+        CWalletTx wtx;
+        CMutableTransaction tx;
+        LelantusJoinSplitProofJob job;
+        std::vector<CLelantusEntry> spendCoins;
+        std::vector<CHDMint> mintCoins;
+        std::exception_ptr error;
+    };
 
-             if (selectedNum == Params().GetConsensus().nMaxLelantusInputPerTransaction)
-                 break;
+    try {
+        EnsureMintWalletAvailable();
+        if (IsLocked()) {
+            throw std::runtime_error(_("Wallet locked"));
         }
-        CRecipient recipient = {scriptChange, spendValue, true, {}, {}};
 
-        CWalletTx result;
-        JoinSplitLelantus({recipient}, {}, result, &coinControl);
-        coinControl.UnSelectAll();
+        std::list<CLelantusEntry> coins = GetAvailableLelantusCoins();
+        CScript scriptChange;
+        {
+            // Reserve a new key pair from key pool
+            CPubKey vchPubKey;
+            bool ret;
+            ret = CReserveKey(this).GetReservedKey(vchPubKey);
+            if (!ret)
+            {
+                strFailReason = _("Keypool ran out, please call keypoolrefill first");
+                finish(strFailReason);
+                return false;
+            }
 
-        uint32_t i = 0;
-        for (; i < result.tx->vout.size(); ++i) {
-            if (result.tx->vout[i].scriptPubKey == recipient.scriptPubKey)
-                break;
+            scriptChange = GetScriptForDestination(vchPubKey.GetID());
         }
 
-        COutPoint outPoint(result.GetHash(), i);
-        coinControl.Select(outPoint);
-        std::vector<std::pair<CWalletTx, CAmount>> wtxAndFee;
-        MintAndStoreSpark({}, wtxAndFee, true, true, false, false, &coinControl);
+        size_t nSkipped = 0;
+        std::vector<std::vector<CLelantusEntry>> plan = PlanLelantusToSpark(coins, scriptChange, nSkipped);
+        {
+            LOCK(cs_lelantusToSpark);
+            lelantusToSparkProgress.nTransactions = plan.size();
+            for (const auto& batch : plan)
+                lelantusToSparkProgress.nCoins += batch.size();
+            lelantusToSparkProgress.nSkippedCoins = nSkipped;
+        }
+        if (nSkipped > 0)
+            LogPrintf("%s: %u lelantus coins can't pay the fee of their joinsplit, leaving them out\n", __func__, nSkipped);
+
+        auto selectCoins = [](const std::vector<CLelantusEntry>& batch, CCoinControl& coinControl) {
+            for (const auto& coin : batch) {
+                COutPoint outPoint;
+                lelantus::GetOutPoint(outPoint, coin.value);
+                coinControl.Select(outPoint);
+            }
+        };
+
+        LelantusAnonymitySetCache setCache;
+        const size_t nParallel = std::max(1u, std::min(MAX_LELANTUS_TO_SPARK_PARALLEL_PROOFS, boost::thread::hardware_concurrency()));
+
+        for (size_t nNext = 0; nNext < plan.size(); ) {
+            std::vector<PendingJoinSplit> window(std::min(nParallel, plan.size() - nNext));
+
+            // set up the joinsplits in order, every change mint takes the next
+            // mint counter, which is written at once for the next one to see
+            for (PendingJoinSplit& pending : window) {
+                pending.coins = std::move(plan[nNext++]);
+                CAmount spendValue = 0;
+                for (const auto& coin : pending.coins)
+                    spendValue += coin.amount;
+                pending.recipient = {scriptChange, spendValue, true, {}, {}};
+
+                CCoinControl coinControl;
+                selectCoins(pending.coins, coinControl);
+                LelantusJoinSplitBuilder builder(*this, *zwallet, &coinControl, &setCache);
+                pending.wtx = builder.BuildUnproven({pending.recipient}, pending.fee, {}, pending.job);
+                pending.spendCoins = builder.spendCoins;
+                pending.mintCoins = builder.mintCoins;
+
+                CWalletDB walletdb(strWalletFile);
+                zwallet->UpdateCountDB(walletdb);
+            }
+
+            // the proofs need neither the wallet nor the chain
+            auto prove = [](PendingJoinSplit& pending) {
+                try {
+                    pending.tx = CMutableTransaction(*pending.wtx.tx);
+                    LelantusJoinSplitBuilder::ProveJoinSplit(pending.job, pending.tx);
+                } catch (...) {
+                    pending.error = std::current_exception();
+                }
+            };
+            if (window.size() == 1) {
+                prove(window[0]);
+            } else {
+                ParallelOpThreadPool<void> threadPool(window.size());
+                std::vector<boost::future<void>> parallelTasks;
+                parallelTasks.reserve(window.size());
+                DoNotDisturb dnd;
+                for (PendingJoinSplit& pending : window)
+                    parallelTasks.emplace_back(threadPool.PostTask([&prove, &pending]() { prove(pending); }));
+                for (auto& task : parallelTasks)
+                    task.get();
+            }
+            {
+                LOCK(cs_lelantusToSpark);
+                for (const PendingJoinSplit& pending : window)
+                    lelantusToSparkProgress.nProved += pending.error ? 0 : 1;
+            }
+
+            // commit in order, a failure stops the migration and leaves the
+            // coins of the joinsplits after it unspent
+            for (PendingJoinSplit& pending : window) {
+                if (pending.error)
+                    std::rethrow_exception(pending.error);
+                pending.wtx.SetTx(MakeTransactionRef(pending.tx));
+
+                unsigned int nSize = GetVirtualTransactionSize(pending.tx);
+                if (pending.fee < CWallet::GetMinimumFee(nSize, nTxConfirmTarget, mempool)) {
+                    // the proof came out larger than estimated, build it again with the fee loop
+                    CCoinControl coinControl;
+                    selectCoins(pending.coins, coinControl);
+                    LelantusJoinSplitBuilder builder(*this, *zwallet, &coinControl, &setCache);
+                    pending.wtx = builder.Build({pending.recipient}, pending.fee, {});
+                    pending.spendCoins = builder.spendCoins;
+                    pending.mintCoins = builder.mintCoins;
+                }
+                CommitLelantusTransaction(pending.wtx, pending.spendCoins, pending.mintCoins);
+
+                uint32_t i = 0;
+                for (; i < pending.wtx.tx->vout.size(); ++i) {
+                    if (pending.wtx.tx->vout[i].scriptPubKey == pending.recipient.scriptPubKey)
+                        break;
+                }
+
+                CCoinControl coinControl;
+                coinControl.Select(COutPoint(pending.wtx.GetHash(), i));
+                std::vector<std::pair<CWalletTx, CAmount>> wtxAndFee;
+                std::string strError = MintAndStoreSpark({}, wtxAndFee, true, true, false, false, &coinControl);
+                if (!strError.empty()) {
+                    strFailReason = strError;
+                    finish(strFailReason);
+                    return false;
+                }
+
+                LOCK(cs_lelantusToSpark);
+                lelantusToSparkProgress.nCommitted++;
+                lelantusToSparkProgress.nMigrated += pending.wtx.tx->vout[i].nValue;
+                lelantusToSparkProgress.nFees += pending.fee;
+                for (const auto& mint : wtxAndFee) {
+                    lelantusToSparkProgress.nMigrated -= mint.second;
+                    lelantusToSparkProgress.nFees += mint.second;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        finish(e.what());
+        throw;
     }
 
+    finish("");
     return true;
 }
 
@@ -5024,9 +5255,7 @@ std::pair<CAmount, unsigned int> CWallet::EstimateJoinSplitFee(
         } catch (std::runtime_error const &) {
         }
 
-        // 1054 is constant part, mainly Schnorr and Range proofs, 2560 is for each sigma/aux data
-        // 179 other parts of tx, assuming 1 utxo and 1 jmint
-        size = 1054 + 2560 * (spendCoins.size()) + 179;
+        size = EstimateJoinSplitSize(spendCoins.size());
         CAmount feeNeeded = CWallet::GetMinimumFee(size, nTxConfirmTarget, mempool);
 
         if (fee >= feeNeeded) {
@@ -6034,6 +6263,7 @@ std::string CWallet::GetWalletHelpString(bool showDebug)
     strUsage += HelpMessageOpt("-paytxfee=<amt>", strprintf(_("Fee (in %s/kB) to add to transactions you send (default: %s)"),
                                                             CURRENCY_UNIT, FormatMoney(payTxFee.GetFeePerK())));
     strUsage += HelpMessageOpt("-rescan", _("Rescan the block chain for missing wallet transactions on startup"));
+    strUsage += HelpMessageOpt("-rescanthreads=<n>", strprintf(_("Set the number of threads loading and filtering blocks during a rescan (0 = number of cores, default: %d)"), DEFAULT_RESCAN_THREADS));
     strUsage += HelpMessageOpt("-salvagewallet", _("Attempt to recover private keys from a corrupt wallet on startup"));
     if (showDebug)
         strUsage += HelpMessageOpt("-sendfreetransactions", strprintf(_("Send transactions as zero-fee transactions if possible (default: %u)"), DEFAULT_SEND_FREE_TRANSACTIONS));
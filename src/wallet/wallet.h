@@ -95,6 +95,11 @@ static const bool DEFAULT_USE_HD_WALLET = true;
 //! if set, all keys will be derived by using BIP39
 static const bool DEFAULT_USE_MNEMONIC = true;
 
+//! Joinsplits of a Lelantus to Spark migration proven at the same time, every
+//! proof already spreads its inputs over the cores and holds its own copy of
+//! the anonymity sets
+static const unsigned int MAX_LELANTUS_TO_SPARK_PARALLEL_PROOFS = 4;
+
 extern const char * DEFAULT_WALLET_DAT;
 
 const uint32_t BIP32_HARDENED_KEY_LIMIT = 0x80000000;
@@ -643,6 +648,25 @@ private:
 
 class LelantusJoinSplitBuilder;
 
+/** State of the running or last Lelantus to Spark migration of a wallet */
+struct CLelantusToSparkProgress
+{
+    bool fRunning = false;
+    int64_t nStartTime = 0;
+    int64_t nEndTime = 0;
+    //! Planned joinsplits and the coins they spend
+    size_t nTransactions = 0;
+    size_t nCoins = 0;
+    //! Coins left out because they can't pay the fee of their joinsplit
+    size_t nSkippedCoins = 0;
+    size_t nProved = 0;
+    //! Joinsplits committed and minted to Spark
+    size_t nCommitted = 0;
+    CAmount nMigrated = 0;
+    CAmount nFees = 0;
+    std::string strError;
+};
+
 
 /**Open unlock wallet window**/
 //static boost::signals2::signal<void (CWallet *wallet)> UnlockWallet;
@@ -725,6 +749,12 @@ private:
      */
     bool AddWatchOnly(const CScript& dest) override;
 
+    mutable CCriticalSection cs_lelantusToSpark;
+    CLelantusToSparkProgress lelantusToSparkProgress;
+
+    /** Split coins into joinsplits within the consensus limits that can pay their fee */
+    std::vector<std::vector<CLelantusEntry>> PlanLelantusToSpark(const std::list<CLelantusEntry>& coins, const CScript& scriptChange, size_t& nSkippedRet) const;
+
 public:
     /*
      * Main wallet lock.
@@ -932,6 +962,7 @@ public:
     void SyncTransaction(const CTransaction& tx, const CBlockIndex *pindex, int posInBlock) override;
     bool AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlockIndex* pIndex, int posInBlock, bool fUpdate);
     CBlockIndex* ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate = false, bool fRecoverMnemonic = false);
+    bool IsKnownOrSpendsWalletOutput(const CTransaction& tx) const;
     CBlockIndex* GetBlockByDate(CBlockIndex* pindexStart, const std::string& dateStr);
     void ReacceptWalletTransactions();
     void ResendWalletTransactions(int64_t nBestBlockTime, CConnman* connman) override;
@@ -1070,6 +1101,7 @@ public:
             const CCoinControl *coinControl = NULL);
 
     bool LelantusToSpark(std::string& strFailReason);
+    CLelantusToSparkProgress GetLelantusToSparkProgress() const;
 
     std::vector<CLelantusEntry> JoinSplitLelantus(const std::vector<CRecipient>& recipients, const std::vector<CAmount>& newMints, CWalletTx& result,  const CCoinControl *coinControl = NULL);
 